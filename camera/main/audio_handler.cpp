@@ -1,5 +1,6 @@
 #include "audio_handler.h"
 #include "wifi_manager.h"
+#include "trace.h"
 
 #define AUDIO_FILES_COUNT (sizeof(audioFiles)/sizeof(audioFiles[0]))
 
@@ -11,13 +12,14 @@ String audioFiles[] = {
 };
 
 Audio *audio = nullptr;
+bool sdCardMounted = false;
 bool audioInitialized = false;
 
 void initializeSDCard() 
 {
     SPI.begin(SPI_SCK, SPI_MISO, SPI_MOSI, SD_CS);
     
-    if (!SD.begin(SD_CS)) {
+    if (!SD.begin(SD_CS, SPI, SD_SPI_FREQ)) {
         Serial.println("[SD] Card Mount Failed");
         return;
     }
@@ -27,6 +29,8 @@ void initializeSDCard()
         Serial.println("[SD] No SD card attached");
         return;
     }
+
+    sdCardMounted = true;
 }
 
 void initializeAudio() 
@@ -81,6 +85,7 @@ void stopAudio() {
 void handleAudioLoop() {
     if (audioInitialized && audio) 
     {
+        TRACE_SCOPE("audio_loop");
         audio->loop();
     }
 }
@@ -6,6 +6,7 @@
 extern String audioFiles[];
 
 extern Audio *audio;
+extern bool sdCardMounted;
 
 void initializeAudio();
 void initializeSDCard();
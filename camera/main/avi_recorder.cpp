@@ -0,0 +1,385 @@
+#include "avi_recorder.h"
+#include "frame_ring.h"
+#include "audio_handler.h"
+#include <stdio.h>
+#include <unistd.h>
+
+// RIFF 'AVI ' + LIST hdrl (avih, LIST strl (strh, strf)) + LIST movi
+#define AVI_HEADER_SIZE     224
+#define AVI_MOVI_OFFSET     220     // vị trí fourcc 'movi', gốc của offset trong idx1
+#define AVIF_HASINDEX       0x10
+#define AVIIF_KEYFRAME      0x10
+
+typedef struct {
+    uint32_t ckid;
+    uint32_t flags;
+    uint32_t offset;
+    uint32_t size;
+} avi_index_entry_t;
+
+avi_stats_t aviStats;
+
+static FILE* aviFile = nullptr;
+static char aviPath[48];
+
+static uint8_t* block = nullptr;            // khối ghi SD, luôn ghi đủ AVI_WRITE_BLOCK trừ khối cuối
+static uint8_t* frameCopy = nullptr;        // bản sao frame trong PSRAM, để trả slot ring trước khi ghi thẻ
+static size_t blockFill = 0;
+static uint32_t fileBytes = 0;              // bytes đã ghi ra thẻ
+
+static avi_index_entry_t* aviIndex = nullptr;   // idx1, trong PSRAM
+static uint32_t frameCount = 0;
+static uint32_t maxFrameLen = 0;
+static int64_t firstCaptureUs = 0;
+static int64_t lastCaptureUs = 0;
+
+static volatile bool stopRequested = false;
+static TaskHandle_t aviTaskHandle = NULL;
+
+static inline uint8_t* putTag(uint8_t* p, const char* tag)
+{
+    memcpy(p, tag, 4);
+    return p + 4;
+}
+
+static inline uint8_t* put32(uint8_t* p, uint32_t v)
+{
+    p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+    return p + 4;
+}
+
+static inline uint8_t* put16(uint8_t* p, uint16_t v)
+{
+    p[0] = v; p[1] = v >> 8;
+    return p + 2;
+}
+
+static inline uint32_t fourcc(const char* tag)
+{
+    return tag[0] | (tag[1] << 8) | (tag[2] << 16) | ((uint32_t)tag[3] << 24);
+}
+
+static void buildHeader(uint8_t* h, uint32_t riffSize, uint32_t moviSize, uint32_t usPerFrame)
+{
+    uint32_t suggested = maxFrameLen + 8;
+    uint8_t* p = h;
+
+    p = putTag(p, "RIFF"); p = put32(p, riffSize); p = putTag(p, "AVI ");
+    p = putTag(p, "LIST"); p = put32(p, 192); p = putTag(p, "hdrl");
+
+    p = putTag(p, "avih"); p = put32(p, 56);
+    p = put32(p, usPerFrame);
+    p = put32(p, (uint32_t)((uint64_t)suggested * 1000000 / usPerFrame));
+    p = put32(p, 0);                    // padding granularity
+    p = put32(p, AVIF_HASINDEX);
+    p = put32(p, frameCount);
+    p = put32(p, 0);                    // initial frames
+    p = put32(p, 1);                    // streams
+    p = put32(p, suggested);
+    p = put32(p, FRAME_WIDTH);
+    p = put32(p, FRAME_HEIGHT);
+    for (int i = 0; i < 4; i++) p = put32(p, 0);
+
+    p = putTag(p, "LIST"); p = put32(p, 116); p = putTag(p, "strl");
+
+    p = putTag(p, "strh"); p = put32(p, 56);
+    p = putTag(p, "vids"); p = putTag(p, "MJPG");
+    p = put32(p, 0);                    // flags
+    p = put16(p, 0); p = put16(p, 0);   // priority, language
+    p = put32(p, 0);                    // initial frames
+    p = put32(p, usPerFrame);           // scale / rate = giây mỗi frame
+    p = put32(p, 1000000);
+    p = put32(p, 0);                    // start
+    p = put32(p, frameCount);
+    p = put32(p, suggested);
+    p = put32(p, 0xFFFFFFFF);           // quality mặc định
+    p = put32(p, 0);                    // sample size, 0 = thay đổi
+    p = put16(p, 0); p = put16(p, 0); p = put16(p, FRAME_WIDTH); p = put16(p, FRAME_HEIGHT);
+
+    p = putTag(p, "strf"); p = put32(p, 40);
+    p = put32(p, 40);
+    p = put32(p, FRAME_WIDTH);
+    p = put32(p, FRAME_HEIGHT);
+    p = put16(p, 1); p = put16(p, 24);
+    p = putTag(p, "MJPG");
+    p = put32(p, FRAME_WIDTH * FRAME_HEIGHT * 3);
+    for (int i = 0; i < 4; i++) p = put32(p, 0);
+
+    p = putTag(p, "LIST"); p = put32(p, moviSize); putTag(p, "movi");
+}
+
+static bool flushBlock()
+{
+    if (blockFill == 0) return true;
+
+    int64_t t0 = esp_timer_get_time();
+    size_t written = fwrite(block, 1, blockFill, aviFile);
+    uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+    aviStats.lastBlockWriteUs = us;
+    if (us > aviStats.maxBlockWriteUs) aviStats.maxBlockWriteUs = us;
+
+    bool ok = (written == blockFill);
+    if (ok) aviStats.bytesWritten += written;
+    else aviStats.writeErrors++;
+
+    fileBytes += written;
+    blockFill = 0;
+    return ok;
+}
+
+static bool appendBytes(const uint8_t* data, size_t len)
+{
+    while (len > 0)
+    {
+        size_t n = min(len, (size_t)AVI_WRITE_BLOCK - blockFill);
+        memcpy(block + blockFill, data, n);
+        blockFill += n;
+        data += n;
+        len -= n;
+
+        if (blockFill == AVI_WRITE_BLOCK && !flushBlock()) return false;
+    }
+    return true;
+}
+
+static inline uint32_t filePos()
+{
+    return fileBytes + blockFill;
+}
+
+static bool openFile()
+{
+    if (!SD.exists(AVI_DIR)) SD.mkdir(AVI_DIR);
+
+    // Tên file tăng dần, không ghi đè bản ghi của lần khởi động trước
+    char name[32];
+    for (int i = 0; i < 10000; i++)
+    {
+        snprintf(name, sizeof(name), AVI_DIR "/rec_%04d.avi", i);
+        if (!SD.exists(name)) break;
+    }
+    snprintf(aviPath, sizeof(aviPath), AVI_SD_MOUNT "%s", name);
+
+    aviFile = fopen(aviPath, "wb");
+    if (aviFile == nullptr)
+    {
+        Serial.printf("[AVI] ERROR: Cannot create %s\n", name);
+        aviStats.writeErrors++;
+        return false;
+    }
+    setvbuf(aviFile, NULL, _IONBF, 0);     // đã gom khối riêng, không cần buffer của stdio
+
+    // Cấp trước cluster để FAT không phải tìm cluster trống giữa lúc ghi, cắt lại khi đóng
+    bool prealloc = fseek(aviFile, AVI_PREALLOC_BYTES - 1, SEEK_SET) == 0 &&
+                    fputc(0, aviFile) != EOF &&
+                    fflush(aviFile) == 0;
+    fseek(aviFile, 0, SEEK_SET);
+    if (!prealloc) Serial.println("[AVI] WARNING: Preallocation failed, file will grow on demand");
+
+    blockFill = 0;
+    fileBytes = 0;
+    frameCount = 0;
+    maxFrameLen = 0;
+    firstCaptureUs = 0;
+    lastCaptureUs = 0;
+
+    // Header tạm, vá lại số frame và kích thước khi đóng file
+    uint8_t header[AVI_HEADER_SIZE];
+    buildHeader(header, 0, 0, 33333);
+    if (!appendBytes(header, sizeof(header)))
+    {
+        fclose(aviFile);
+        aviFile = nullptr;
+        return false;
+    }
+
+    Serial.printf("[AVI] Recording %s\n", name);
+    return true;
+}
+
+static void closeFile()
+{
+    uint32_t moviEnd = filePos();
+
+    uint8_t chunk[8];
+    put32(putTag(chunk, "idx1"), frameCount * sizeof(avi_index_entry_t));
+    bool ok = appendBytes(chunk, sizeof(chunk)) &&
+              appendBytes((const uint8_t*)aviIndex, frameCount * sizeof(avi_index_entry_t)) &&
+              flushBlock();
+
+    uint32_t usPerFrame = 33333;
+    if (frameCount > 1) usPerFrame = (uint32_t)((lastCaptureUs - firstCaptureUs) / (frameCount - 1));
+    if (usPerFrame == 0) usPerFrame = 33333;
+
+    uint8_t header[AVI_HEADER_SIZE];
+    buildHeader(header, fileBytes - 8, moviEnd - AVI_MOVI_OFFSET, usPerFrame);
+    ok = ok && fseek(aviFile, 0, SEEK_SET) == 0 &&
+         fwrite(header, 1, sizeof(header), aviFile) == sizeof(header) &&
+         fflush(aviFile) == 0;
+
+    if (ftruncate(fileno(aviFile), fileBytes) != 0) ok = false;
+    fclose(aviFile);
+    aviFile = nullptr;
+
+    if (frameCount == 0)
+    {
+        remove(aviPath);
+        return;
+    }
+
+    if (ok) aviStats.filesWritten++;
+    else aviStats.writeErrors++;
+
+    Serial.printf("[AVI] Closed %s: %lu frames, %lu KB, %.1f fps\n", aviPath,
+                  (unsigned long)frameCount, (unsigned long)(fileBytes / 1024),
+                  1000000.0f / usPerFrame);
+}
+
+static bool writeFrame(const uint8_t* data, size_t len, int64_t captureUs)
+{
+    uint32_t chunkLen = 8 + len + (len & 1);
+    uint32_t indexLen = 8 + (frameCount + 1) * sizeof(avi_index_entry_t);
+
+    if (frameCount >= AVI_MAX_FRAMES || filePos() + chunkLen + indexLen > AVI_MAX_FILE_BYTES)
+    {
+        closeFile();
+        if (!openFile()) return false;
+    }
+
+    avi_index_entry_t* e = &aviIndex[frameCount];
+    e->ckid = fourcc("00dc");
+    e->flags = AVIIF_KEYFRAME;
+    e->offset = filePos() - AVI_MOVI_OFFSET;
+    e->size = len;
+
+    uint8_t chunk[8];
+    put32(putTag(chunk, "00dc"), len);
+    static const uint8_t pad = 0;
+
+    if (!appendBytes(chunk, sizeof(chunk)) ||
+        !appendBytes(data, len) ||
+        ((len & 1) && !appendBytes(&pad, 1)))
+    {
+        return false;
+    }
+
+    if (frameCount == 0) firstCaptureUs = captureUs;
+    lastCaptureUs = captureUs;
+    if (len > maxFrameLen) maxFrameLen = len;
+    frameCount++;
+    aviStats.framesWritten++;
+    return true;
+}
+
+void aviRecorderTask(void* pvParameters)
+{
+    uint32_t lastSeq = 0;
+    bool ok = openFile();
+
+    while (ok && !stopRequested)
+    {
+        frame_slot_t* slot = frameRingAcquire(lastSeq);
+        bool gotFrame = slot && slot->len > 0;
+        size_t len = 0;
+        int64_t captureUs = 0;
+
+        // Chép ra rồi trả slot ngay, ghi thẻ SD (nhiều khối 32 KB) không được giữ frame trong ring
+        if (gotFrame)
+        {
+            if (lastSeq != 0 && slot->seq > lastSeq + 1) aviStats.framesSkipped += slot->seq - lastSeq - 1;
+            lastSeq = slot->seq;
+
+            len = slot->len;
+            captureUs = slot->captureUs;
+            memcpy(frameCopy, slot->data, len);
+        }
+        frameRingRelease(slot);
+
+        if (gotFrame)
+        {
+            ok = writeFrame(frameCopy, len, captureUs);
+            if (!ok) Serial.println("[AVI] ERROR: SD write failed, stopping recorder");
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(gotFrame ? 1 : 5));
+    }
+
+    if (aviFile != nullptr) closeFile();
+
+    Serial.println("[AVI] Recorder stopped");
+    aviTaskHandle = NULL;
+    vTaskDelete(NULL);
+}
+
+bool aviRecorderStart()
+{
+    if (aviTaskHandle != NULL) return true;
+
+    if (!sdCardMounted)
+    {
+        Serial.println("[AVI] SD card not mounted, cannot record");
+        return false;
+    }
+
+    if (block == nullptr)
+    {
+        block = (uint8_t*)heap_caps_malloc(AVI_WRITE_BLOCK, MALLOC_CAP_DMA);
+        if (block == nullptr)
+        {
+            Serial.println("[AVI] ERROR: Failed to allocate write block");
+            return false;
+        }
+    }
+
+    if (frameCopy == nullptr)
+    {
+        frameCopy = (uint8_t*)heap_caps_malloc(MJPEG_MAX_FRAME_SIZE, MALLOC_CAP_SPIRAM);
+        if (frameCopy == nullptr)
+        {
+            Serial.println("[AVI] ERROR: Failed to allocate frame buffer");
+            return false;
+        }
+    }
+
+    if (aviIndex == nullptr)
+    {
+        aviIndex = (avi_index_entry_t*)heap_caps_malloc(AVI_MAX_FRAMES * sizeof(avi_index_entry_t), MALLOC_CAP_SPIRAM);
+        if (aviIndex == nullptr)
+        {
+            Serial.println("[AVI] ERROR: Failed to allocate index");
+            return false;
+        }
+    }
+
+    stopRequested = false;
+
+    BaseType_t result = xTaskCreatePinnedToCore(
+        aviRecorderTask,
+        "AviRecorder",
+        4096,
+        NULL,
+        2,
+        &aviTaskHandle,
+        PRO_CPU
+    );
+
+    if (result != pdPASS)
+    {
+        Serial.println("[AVI] ERROR: Failed to create task!");
+        aviTaskHandle = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+// Task tự đóng file (ghi idx1, vá header) rồi thoát
+void aviRecorderStop()
+{
+    stopRequested = true;
+}
+
+bool aviRecorderActive()
+{
+    return aviTaskHandle != NULL;
+}
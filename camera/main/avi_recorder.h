@@ -0,0 +1,34 @@
+#ifndef AVI_RECORDER_H
+#define AVI_RECORDER_H
+
+#include "config.h"
+
+// Ghi thẳng frame MJPEG từ camera vào file AVI (RIFF) trên thẻ SD, không nén lại.
+// idx1 được dựng dần trong PSRAM và ghi ra khi đóng file, header được vá lại ở cuối.
+// Ghi qua khối lớn (nhiều sector) để mỗi lần ghi là 1 giao dịch SPI dài.
+
+#define AVI_DIR                 "/videos"
+#define AVI_SD_MOUNT            "/sd"               // mountpoint mặc định của SD.begin()
+#define AVI_WRITE_BLOCK         (32 * 1024)         // bội số của sector 512 byte
+#define AVI_PREALLOC_BYTES      (64UL * 1024 * 1024)
+#define AVI_MAX_FILE_BYTES      (1000UL * 1024 * 1024)  // AVI 1.0, offset idx1 là 32 bit
+#define AVI_MAX_FRAMES          (30 * 60 * 10)      // 10 phút @ 30 fps, ~280 KB idx1 trong PSRAM
+
+typedef struct {
+    uint32_t framesWritten;
+    uint32_t framesSkipped;     // ghi chậm hơn camera, frame bị bỏ qua trong ring
+    uint32_t filesWritten;
+    uint32_t writeErrors;
+    uint32_t lastBlockWriteUs;
+    uint32_t maxBlockWriteUs;
+    uint64_t bytesWritten;
+} avi_stats_t;
+
+extern avi_stats_t aviStats;
+
+bool aviRecorderStart();
+void aviRecorderStop();
+bool aviRecorderActive();
+void aviRecorderTask(void* pvParameters);
+
+#endif
@@ -5,6 +5,7 @@
 #include "blynk_handler.h"
 #include "wifi_manager.h"
 #include "security_system.h"
+#include "trace.h"
 #include <BlynkSimpleEsp32.h>
 
 Servo servo1, servo2;
@@ -137,6 +138,7 @@ bool isBlynkConnected() {
 
 void handleBlynkLoop() 
 {
+    TRACE_SCOPE("blynk_loop");
     if(wifiState == WIFI_STA_OK && WiFi.status() == WL_CONNECTED) 
     {
         if (!Blynk.connected()) 
@@ -1,13 +1,13 @@
 #include "camera_handler.h"
 #include "web_server.h"
+#include "frame_ring.h"
+#include "jpeg_validator.h"
+#include "motion_detector.h"
+#include "stream_mux.h"
+#include "rtsp_server.h"
+#include "mcast_stream.h"
+#include "trace.h"
 
-uint8_t* mjpeg_buf_a = nullptr;
-uint8_t* mjpeg_buf_b = nullptr;
-volatile size_t frame_len_a = 0;
-volatile size_t frame_len_b = 0;
-volatile bool frame_ready_a = false;
-volatile bool frame_ready_b = false;
-volatile bool use_buf_a = true;
 portMUX_TYPE frameMux = portMUX_INITIALIZER_UNLOCKED;
 
 uint8_t* payload_buf_a = nullptr;
@@ -20,7 +20,6 @@ USB_STREAM* uvc = nullptr;
 bool uvcStarted = false;
 
 static bool streaming_started = false;
-static TaskHandle_t clientProcessorHandle = NULL;
 
 void initializeBuffers() 
 {
@@ -29,16 +28,12 @@ void initializeBuffers()
         while(true) vTaskDelay(pdMS_TO_TICKS(1000));
     }
     
-    mjpeg_buf_a = (uint8_t*)heap_caps_malloc(MJPEG_BUF_SIZE, MALLOC_CAP_SPIRAM);
-    mjpeg_buf_b = (uint8_t*)heap_caps_malloc(MJPEG_BUF_SIZE, MALLOC_CAP_SPIRAM);
     payload_buf_a = (uint8_t*)heap_caps_malloc(USB_PAYLOAD_BUF_SIZE, MALLOC_CAP_SPIRAM);
     payload_buf_b = (uint8_t*)heap_caps_malloc(USB_PAYLOAD_BUF_SIZE, MALLOC_CAP_SPIRAM);
     frame_buf = (uint8_t*)heap_caps_malloc(USB_FRAME_BUF_SIZE, MALLOC_CAP_SPIRAM);
     
-    if(!mjpeg_buf_a || !mjpeg_buf_b || !payload_buf_a || !payload_buf_b || !frame_buf) 
+    if(!payload_buf_a || !payload_buf_b || !frame_buf || !initializeFrameRing()) 
     {
-        heap_caps_free(mjpeg_buf_a);
-        heap_caps_free(mjpeg_buf_b);
         heap_caps_free(payload_buf_a);
         heap_caps_free(payload_buf_b);
         heap_caps_free(frame_buf);
@@ -58,69 +53,23 @@ void initializeCamera()
 //hàm nãy sẽ được gọi khi có frame mưới được nhận
 void frame_cb(uvc_frame_t* frame, void*) 
 {
+    TRACE_SCOPE("frame_cb");
+    int64_t captureUs = esp_timer_get_time();
     if (!frame || !frame->data || frame->data_bytes == 0) return;
-    if (frame->data_bytes > MJPEG_BUF_SIZE || frame->data_bytes < 2000) return;
     
     frame_cnt_recv++;
-    
-    //double buffering
-    portENTER_CRITICAL_ISR(&frameMux);
-    if (use_buf_a && !frame_ready_a) 
-    {
-        memcpy(mjpeg_buf_a, frame->data, frame->data_bytes);
-        frame_len_a = frame->data_bytes;
-        frame_ready_a = true;
-        use_buf_a = false;
-    } 
-    else if (!use_buf_a && !frame_ready_b) 
-    {
-        memcpy(mjpeg_buf_b, frame->data, frame->data_bytes);
-        frame_len_b = frame->data_bytes;
-        frame_ready_b = true;
-        use_buf_a = true;
-    }
-    portEXIT_CRITICAL_ISR(&frameMux);
-}
 
-void clientProcessorTask(void *pvParameters) 
-{
-    stream_client_t* streamClient;
-    
-    while (true) 
+    //loại frame hỏng/bị cắt trước khi đưa vào ring
+    JpegCheck check = jpegValidate((const uint8_t*)frame->data, frame->data_bytes,
+                                   FRAME_WIDTH, FRAME_HEIGHT, nullptr);
+    if (check != JPEG_OK)
     {
-        if (xQueueReceive(clientQueue, &streamClient, portMAX_DELAY) == pdTRUE) 
-        {
-            extern TaskHandle_t streamTaskHandle[MAX_CLIENTS];
-            int taskSlot = -1;
-            for (int i = 0; i < MAX_CLIENTS; i++) 
-            {
-                if (streamTaskHandle[i] == NULL) 
-                {
-                    taskSlot = i;
-                    break;
-                }
-            }
-            
-            if (taskSlot != -1) 
-            {
-                String taskName = "StreamTask" + String(taskSlot);
-                xTaskCreatePinnedToCore(
-                    stream_task,
-                    taskName.c_str(),
-                    8192,
-                    streamClient,
-                    3,
-                    &streamTaskHandle[taskSlot],
-                    1
-                );
-            } 
-            else 
-            {
-                streamClient->client.stop();
-                delete streamClient;
-            }
-        }
+        jpegDropCount[check]++;
+        return;
     }
+    
+    //mọi client đọc chung ring, không client nào lấy mất frame của client khác
+    frameRingPush((const uint8_t*)frame->data, frame->data_bytes, captureUs);
 }
 
 void startStream() 
@@ -149,30 +98,18 @@ void startStream()
         }
     }
 
-    for (int i = 0; i < MAX_CLIENTS; i++) 
-    {
-        streamTaskHandle[i] = NULL;
-    }
+    // 1 task phục vụ mọi client thay cho 1 task 8 KB stack mỗi client
+    if (!startStreamMux()) return;
 
-    if (clientProcessorHandle == NULL) 
-    {
-        Serial.println("[CAMERA] Creating client processor task");
-        BaseType_t result = xTaskCreatePinnedToCore(
-            clientProcessorTask, 
-            "ClientProcessor", 
-            4096, 
-            NULL, 
-            3, 
-            &clientProcessorHandle, 
-            1
-        );
-        
-        if (result != pdPASS) {
-            Serial.println("[CAMERA] ERROR: Failed to create processor task!");
-            return;
-        }
-    }
+#if RTSP_ENABLED
+    startRtspServer();
+#endif
+#if MCAST_STREAM_ENABLED
+    startMcastStream();
+#endif
     
+    startMotionDetector();
+
     streaming_started = true;
     Serial.println("[CAMERA] Stream started successfully");
 }
@@ -182,17 +119,9 @@ void stopStream() {
     
     Serial.println("[CAMERA] Stopping stream");
 
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (streamTaskHandle[i] != NULL) {
-            vTaskDelete(streamTaskHandle[i]);
-            streamTaskHandle[i] = NULL;
-        }
-    }
-
-    if (clientProcessorHandle != NULL) {
-        vTaskDelete(clientProcessorHandle);
-        clientProcessorHandle = NULL;
-    }
+    stopStreamMux();
+    stopRtspServer();
+    stopMcastStream();
 
     if (clientQueue != NULL) {
         stream_client_t* streamClient;
@@ -208,11 +137,11 @@ void stopStream() {
         clientQueue = NULL;
     }
 
-    portENTER_CRITICAL(&frameMux);
-    frame_ready_a = false;
-    frame_ready_b = false;
-    use_buf_a = true;
-    portEXIT_CRITICAL(&frameMux);
+    stopMotionDetector();
+
+    frameRingLogStats();
+    jpegLogDropStats();
+    frameRingReset();
     
     streaming_started = false;
     Serial.println("[CAMERA] Stream stopped completely");
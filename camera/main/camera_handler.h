@@ -6,13 +6,6 @@
 extern USB_STREAM* uvc;
 extern bool uvcStarted;
 
-extern uint8_t* mjpeg_buf_a;
-extern uint8_t* mjpeg_buf_b;
-extern volatile size_t frame_len_a;
-extern volatile size_t frame_len_b;
-extern volatile bool frame_ready_a;
-extern volatile bool frame_ready_b;
-extern volatile bool use_buf_a;
 extern portMUX_TYPE frameMux;
 
 extern uint8_t* payload_buf_a;
@@ -26,7 +19,6 @@ void initializeCamera();
 void frame_cb(uvc_frame_t* frame, void*);
 void startStream();
 void stopStream();
-void clientProcessorTask(void *pvParameters);
 
 
 #endif
\ No newline at end of file
@@ -20,12 +20,43 @@
 
 #define FRAME_WIDTH 800
 #define FRAME_HEIGHT 600
-#define MJPEG_BUF_SIZE (FRAME_WIDTH * FRAME_HEIGHT * 2)
+// Vùng PSRAM chung chứa các JPEG nén (bằng 2 buffer 800x600x2 cũ, ~1.9 MB)
+#define FRAME_ARENA_SIZE (FRAME_WIDTH * FRAME_HEIGHT * 4)
+#define MJPEG_MAX_FRAME_SIZE USB_FRAME_BUF_SIZE
+#define MJPEG_MIN_FRAME_SIZE 2000
+
+// 1 = loại frame không có bảng Huffman (DHT); mặc định chỉ đếm
+#define JPEG_REQUIRE_DHT 0
 #define USB_PAYLOAD_BUF_SIZE (64 * 1024)
 #define USB_FRAME_BUF_SIZE (256 * 1024)
 
+// 1 = memcpy frame bên trong critical section (cách cũ, chỉ để so sánh)
+#define FRAME_HANDOFF_COPY_IN_CS 0
+
+// 1 = header + JPEG + boundary gửi chung 1 writev theo khối bội số MSS
+// 0 = 3 lần send riêng như cũ (chỉ để so sánh segments/frame và throughput)
+#define STREAM_SEND_GATHER 1
+
+// 1 = bật RTSP / RTP-JPEG qua UDP (rtsp_server), gateway đọc rtsp://cameraiuh.local:8554/mjpeg
+#define RTSP_ENABLED 1
+
+// 1 = nhận client WebSocket ws://cameraiuh.local:81/ws/stream (ws_stream) trong streamMuxTask
+#define WS_STREAM_ENABLED 1
+
+// 1 = gửi mỗi frame 1 lần tới nhóm UDP multicast 239.255.42.1:5010 (mcast_stream) cho nhiều consumer trong LAN.
+// Airtime: AP phát lại multicast ở basic rate (1-6 Mbps) không ack/aggregation, 15 fps x ~50 KB ≈ 6 Mbps
+// có thể chiếm gần hết kênh của /stream và RTSP. Chỉ gửi khi có consumer giữ lease qua GET /mcast?lease=s.
+#define MCAST_STREAM_ENABLED 0
+
+// 1 = ghi trace timeline vào ring PSRAM (trace), tải Chrome trace JSON qua GET /trace
+#define TRACE_ENABLED 0
+
+// 1 = PIR chỉ kích hoạt khi phân tích video xác nhận (motion_detector), 0 = chỉ dùng PIR như cũ
+#define MOTION_VIDEO_CONFIRM 1
+
 
 #define SD_CS     10
+#define SD_SPI_FREQ 20000000   // mặc định của SD.begin() là 4 MHz, không đủ cho ghi video
 #define SPI_MOSI  12
 #define SPI_MISO  13
 
@@ -56,6 +87,12 @@
 #define AUDIO_WIFI_SUCCESS         2  
 #define AUDIO_MOTION_DETECTED      3 
 
+// Số client /stream đồng thời. streamMuxTask dùng 1 task chung nên không còn tốn 8 KB stack mỗi client,
+// mỗi client chỉ ~250 B trạng thái + send buffer lwIP (tối đa TCP_SND_BUF 5744 B RAM trong).
+// Trần lý thuyết là CONFIG_LWIP_MAX_SOCKETS = 16 của arduino-esp32: trừ socket listen, request HTTP,
+// MQTT, Blynk, DNS/NTP còn ~10. Chưa đo trên phần cứng nên vẫn giữ giới hạn cũ 3.
+// Trước khi tăng: mở N = 3..8 client /stream cùng lúc, ghi fps mỗi client (/stats -> clients[].fps)
+// và heap trong (/stats -> mux.heap_internal_free) sau vài phút cho mỗi N, chép kết quả vào đây.
 #define MAX_CLIENTS 3
 #define APP_CPU 1
 #define PRO_CPU 0
@@ -0,0 +1,255 @@
+#include "event_buffer.h"
+#include "frame_ring.h"
+#include "audio_handler.h"
+#include <SD.h>
+
+event_stats_t eventStats;
+
+static frame_arena_t eventArena;
+static event_frame_t frames[EVENT_MAX_FRAMES];
+static int head = 0;            // frame cũ nhất
+static int count = 0;
+static uint32_t nextSeq = 1;
+
+static uint8_t* block = nullptr;    // khối ghi SD, luôn ghi đủ EVENT_WRITE_BLOCK trừ khối cuối
+static size_t blockFill = 0;
+
+static File clip;
+static volatile bool recording = false;
+static uint32_t writeSeq = 0;       // frame kế tiếp cần ghi
+static size_t writeOff = 0;
+
+static volatile bool triggerPending = false;
+static volatile unsigned long recordUntilMs = 0;
+static char triggerReason[16] = "";
+
+static TaskHandle_t eventTaskHandle = NULL;
+
+static inline event_frame_t* frameAt(int i)
+{
+    return &frames[(head + i) % EVENT_MAX_FRAMES];
+}
+
+// Frame chưa ghi ra thẻ thì không được xoá khi đang ghi clip
+static bool evictOldest()
+{
+    if (count == 0) return false;
+
+    event_frame_t* f = frameAt(0);
+    if (recording && f->seq >= writeSeq) return false;
+
+    frameArenaFree(&eventArena, f->data);
+    f->data = nullptr;
+    head = (head + 1) % EVENT_MAX_FRAMES;
+    count--;
+    return true;
+}
+
+static void captureFrame(uint32_t* lastSeq)
+{
+    frame_slot_t* slot = frameRingAcquire(*lastSeq);
+    if (slot == nullptr) return;
+
+    if (slot->len > 0)
+    {
+        *lastSeq = slot->seq;
+
+        uint8_t* dst = nullptr;
+        if (count < EVENT_MAX_FRAMES || evictOldest())
+        {
+            dst = frameArenaAlloc(&eventArena, slot->len);
+            while (dst == nullptr && evictOldest()) dst = frameArenaAlloc(&eventArena, slot->len);
+        }
+
+        if (dst)
+        {
+            memcpy(dst, slot->data, slot->len);
+
+            event_frame_t* f = frameAt(count);
+            f->data = dst;
+            f->len = slot->len;
+            f->seq = nextSeq++;
+            f->captureMs = millis();
+            count++;
+            eventStats.framesBuffered++;
+        }
+        else
+        {
+            eventStats.framesDropped++;
+        }
+    }
+    frameRingRelease(slot);
+
+    // Chỉ giữ EVENT_PRE_SECONDS giây gần nhất
+    unsigned long now = millis();
+    while (count > 0 && now - frameAt(0)->captureMs > EVENT_PRE_SECONDS * 1000UL && evictOldest()) {}
+}
+
+static bool flushBlock()
+{
+    if (blockFill == 0) return true;
+
+    int64_t t0 = esp_timer_get_time();
+    size_t written = clip.write(block, blockFill);
+    uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+    if (us > eventStats.maxBlockWriteUs) eventStats.maxBlockWriteUs = us;
+
+    bool ok = (written == blockFill);
+    if (ok) eventStats.bytesWritten += written;
+    else eventStats.writeErrors++;
+
+    blockFill = 0;
+    return ok;
+}
+
+static void openClip()
+{
+    triggerPending = false;
+
+    if (!sdCardMounted)
+    {
+        Serial.println("[EVENT] SD card not mounted, clip skipped");
+        return;
+    }
+
+    if (!SD.exists(EVENT_DIR)) SD.mkdir(EVENT_DIR);
+
+    char path[48];
+    snprintf(path, sizeof(path), EVENT_DIR "/%lu_%s.mjpg", millis(), triggerReason);
+    clip = SD.open(path, FILE_WRITE);
+    if (!clip)
+    {
+        Serial.printf("[EVENT] ERROR: Cannot create %s\n", path);
+        eventStats.writeErrors++;
+        return;
+    }
+
+    writeSeq = count > 0 ? frameAt(0)->seq : nextSeq;
+    writeOff = 0;
+    blockFill = 0;
+    recording = true;
+
+    Serial.printf("[EVENT] Recording %s (%d pre-event frames)\n", path, count);
+}
+
+static void closeClip()
+{
+    flushBlock();
+    clip.close();
+    recording = false;
+    eventStats.clipsWritten++;
+    Serial.printf("[EVENT] Clip closed (%lu frames written total)\n", (unsigned long)eventStats.framesWritten);
+}
+
+// Chép frame vào khối ghi, tối đa EVENT_BLOCKS_PER_ROUND khối mỗi lượt để không giữ task quá lâu
+static void writeRound()
+{
+    int blocks = 0;
+
+    while (blocks < EVENT_BLOCKS_PER_ROUND)
+    {
+        if (count == 0 || writeSeq >= frameAt(0)->seq + count) break;
+
+        event_frame_t* f = frameAt(writeSeq - frameAt(0)->seq);
+        size_t n = min(f->len - writeOff, (size_t)EVENT_WRITE_BLOCK - blockFill);
+        memcpy(block + blockFill, f->data + writeOff, n);
+        blockFill += n;
+        writeOff += n;
+
+        if (writeOff == f->len)
+        {
+            writeSeq++;
+            writeOff = 0;
+            eventStats.framesWritten++;
+        }
+
+        if (blockFill == EVENT_WRITE_BLOCK)
+        {
+            blocks++;
+            if (!flushBlock())
+            {
+                Serial.println("[EVENT] ERROR: SD write failed, closing clip");
+                closeClip();
+                return;
+            }
+        }
+    }
+
+    bool caughtUp = (count == 0 || writeSeq >= frameAt(0)->seq + count);
+    if (caughtUp && (long)(millis() - recordUntilMs) >= 0) closeClip();
+}
+
+void eventBufferTask(void* pvParameters)
+{
+    uint32_t lastSeq = 0;
+    unsigned long lastCaptureMs = 0;
+
+    while (true)
+    {
+        unsigned long now = millis();
+        if (now - lastCaptureMs >= 1000 / EVENT_BUFFER_FPS)
+        {
+            lastCaptureMs = now;
+            captureFrame(&lastSeq);
+        }
+
+        if (triggerPending && !recording) openClip();
+        if (recording) writeRound();
+
+        vTaskDelay(pdMS_TO_TICKS(recording ? 5 : 20));
+    }
+}
+
+bool startEventBuffer()
+{
+    if (eventTaskHandle != NULL) return true;
+
+    if (!frameArenaInit(&eventArena, EVENT_ARENA_SIZE))
+    {
+        Serial.println("[EVENT] ERROR: Failed to allocate PSRAM arena");
+        return false;
+    }
+
+    block = (uint8_t*)heap_caps_malloc(EVENT_WRITE_BLOCK, MALLOC_CAP_DMA);
+    if (block == nullptr)
+    {
+        Serial.println("[EVENT] ERROR: Failed to allocate write block");
+        return false;
+    }
+
+    BaseType_t result = xTaskCreatePinnedToCore(
+        eventBufferTask,
+        "EventBuffer",
+        4096,
+        NULL,
+        1,
+        &eventTaskHandle,
+        PRO_CPU
+    );
+
+    if (result != pdPASS)
+    {
+        Serial.println("[EVENT] ERROR: Failed to create task!");
+        eventTaskHandle = NULL;
+        return false;
+    }
+
+    Serial.printf("[EVENT] Pre-event buffer started (%ds @ %d fps)\n", EVENT_PRE_SECONDS, EVENT_BUFFER_FPS);
+    return true;
+}
+
+// Gọi khi hệ thống an ninh leo thang; đang ghi thì chỉ kéo dài thời gian ghi
+void eventBufferTrigger(const char* reason)
+{
+    recordUntilMs = millis() + EVENT_POST_SECONDS * 1000UL;
+    if (recording) return;
+
+    strncpy(triggerReason, reason, sizeof(triggerReason) - 1);
+    triggerReason[sizeof(triggerReason) - 1] = '\0';
+    triggerPending = true;
+}
+
+bool eventBufferRecording()
+{
+    return recording;
+}
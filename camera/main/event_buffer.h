@@ -0,0 +1,43 @@
+#ifndef EVENT_BUFFER_H
+#define EVENT_BUFFER_H
+
+#include "config.h"
+#include "frame_arena.h"
+
+// Lưu N giây JPEG gần nhất trong PSRAM, khi có báo động thì ghi ra thẻ SD
+// (kèm thêm vài giây sau sự kiện) từ task nền, ghi theo khối lớn căn sector.
+
+#define EVENT_PRE_SECONDS       10
+#define EVENT_POST_SECONDS      20
+#define EVENT_BUFFER_FPS        5
+#define EVENT_ARENA_SIZE        (2 * 1024 * 1024)
+#define EVENT_MAX_FRAMES        ((EVENT_PRE_SECONDS + 2) * EVENT_BUFFER_FPS)
+#define EVENT_WRITE_BLOCK       (32 * 1024)     // bội số của sector 512 byte
+#define EVENT_BLOCKS_PER_ROUND  4
+#define EVENT_DIR               "/events"
+
+typedef struct {
+    uint8_t* data;              // trong eventArena
+    size_t len;
+    uint32_t seq;
+    unsigned long captureMs;
+} event_frame_t;
+
+typedef struct {
+    uint32_t framesBuffered;
+    uint32_t framesDropped;     // arena đầy do frame chưa ghi xong
+    uint32_t framesWritten;
+    uint32_t clipsWritten;
+    uint32_t writeErrors;
+    uint32_t maxBlockWriteUs;
+    uint64_t bytesWritten;
+} event_stats_t;
+
+extern event_stats_t eventStats;
+
+bool startEventBuffer();
+void eventBufferTrigger(const char* reason);
+bool eventBufferRecording();
+void eventBufferTask(void* pvParameters);
+
+#endif
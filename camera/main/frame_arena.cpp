@@ -0,0 +1,215 @@
+#include "frame_arena.h"
+
+#define ARENA_BLOCK_LIVE 1
+#define ARENA_BLOCK_FREE 2
+
+typedef struct {
+    uint32_t size;      // kích thước cả block, gồm header
+    uint32_t state;
+    uint32_t prevSize;  // kích thước block liền trước (0 nếu là block đầu), để gộp ngược
+} arena_block_t;
+
+// Header chiếm nguyên 1 đơn vị align để payload luôn thẳng hàng
+#define ARENA_HDR_SIZE FRAME_ARENA_ALIGN
+// Phần dư nhỏ hơn mức này thì không tách thành block free riêng
+#define ARENA_MIN_SPLIT (ARENA_HDR_SIZE + FRAME_ARENA_ALIGN)
+#define ARENA_NO_FIT ((size_t)-1)
+
+static inline size_t alignUp(size_t n)
+{
+    return (n + FRAME_ARENA_ALIGN - 1) & ~(size_t)(FRAME_ARENA_ALIGN - 1);
+}
+
+static inline arena_block_t* blockAt(const frame_arena_t* arena, size_t offset)
+{
+    return (arena_block_t*)(arena->base + offset);
+}
+
+bool frameArenaInit(frame_arena_t* arena, size_t capacity)
+{
+    memset(arena, 0, sizeof(*arena));
+    capacity &= ~(size_t)(FRAME_ARENA_ALIGN - 1);
+
+    arena->base = (uint8_t*)heap_caps_aligned_alloc(FRAME_ARENA_ALIGN, capacity, MALLOC_CAP_SPIRAM);
+    if (!arena->base) return false;
+
+    arena->capacity = capacity;
+    frameArenaReset(arena);
+    return true;
+}
+
+void frameArenaReset(frame_arena_t* arena)
+{
+    arena_block_t* all = blockAt(arena, 0);
+    all->size = arena->capacity;
+    all->state = ARENA_BLOCK_FREE;
+    all->prevSize = 0;
+
+    arena->rover = 0;
+    arena->live = 0;
+    arena->liveBlocks = 0;
+}
+
+// Block free đầu tiên đủ need, bắt đầu tại các block có offset trong [start, end)
+static size_t findFree(const frame_arena_t* arena, size_t start, size_t end, size_t need)
+{
+    for (size_t off = start; off < end; off += blockAt(arena, off)->size)
+    {
+        const arena_block_t* b = blockAt(arena, off);
+        if (b->state == ARENA_BLOCK_FREE && b->size >= need) return off;
+    }
+    return ARENA_NO_FIT;
+}
+
+uint8_t* frameArenaAlloc(frame_arena_t* arena, size_t len)
+{
+    size_t need = alignUp(len + ARENA_HDR_SIZE);
+
+    // Next-fit: tìm từ rover đến cuối, rồi từ đầu đến rover
+    size_t offset = need <= arena->capacity ? findFree(arena, arena->rover, arena->capacity, need) : ARENA_NO_FIT;
+    if (offset == ARENA_NO_FIT && need <= arena->capacity) offset = findFree(arena, 0, arena->rover, need);
+    if (offset == ARENA_NO_FIT)
+    {
+        arena->allocFails++;
+        return nullptr;
+    }
+
+    arena_block_t* block = blockAt(arena, offset);
+    size_t rest = block->size - need;
+    if (rest >= ARENA_MIN_SPLIT)
+    {
+        block->size = need;
+
+        arena_block_t* tail = blockAt(arena, offset + need);
+        tail->size = rest;
+        tail->state = ARENA_BLOCK_FREE;
+        tail->prevSize = need;
+
+        size_t after = offset + need + rest;
+        if (after < arena->capacity) blockAt(arena, after)->prevSize = rest;
+    }
+    block->state = ARENA_BLOCK_LIVE;
+
+    arena->rover = offset + block->size;
+    if (arena->rover == arena->capacity) arena->rover = 0;
+
+    arena->live += block->size;
+    arena->liveBlocks++;
+    arena->allocCount++;
+    if (arena->live > arena->highWater) arena->highWater = arena->live;
+
+    return arena->base + offset + ARENA_HDR_SIZE;
+}
+
+void frameArenaFree(frame_arena_t* arena, uint8_t* ptr)
+{
+    if (ptr == nullptr) return;
+
+    arena_block_t* block = (arena_block_t*)(ptr - ARENA_HDR_SIZE);
+    if (block->state != ARENA_BLOCK_LIVE) return;
+
+    block->state = ARENA_BLOCK_FREE;
+    arena->live -= block->size;
+    arena->liveBlocks--;
+
+    size_t offset = (uint8_t*)block - arena->base;
+    size_t size = block->size;
+
+    // Gộp với block free phía sau
+    size_t next = offset + size;
+    if (next < arena->capacity && blockAt(arena, next)->state == ARENA_BLOCK_FREE)
+        size += blockAt(arena, next)->size;
+
+    // Gộp với block free phía trước
+    if (offset > 0)
+    {
+        size_t prev = offset - block->prevSize;
+        if (blockAt(arena, prev)->state == ARENA_BLOCK_FREE)
+        {
+            size += offset - prev;
+            offset = prev;
+        }
+    }
+
+    blockAt(arena, offset)->size = size;
+    size_t end = offset + size;
+    if (end < arena->capacity) blockAt(arena, end)->prevSize = size;
+
+    // rover phải luôn trỏ vào đầu 1 block
+    if (arena->rover > offset && arena->rover < end) arena->rover = offset;
+}
+
+// Tìm dải block liền kề (free hoặc evictable) đủ chứa len mà cần xoá ít block nhất.
+// Ghi các block cần xoá vào victims, trả về số block; -1 nếu xoá thế nào cũng không đủ chỗ.
+int frameArenaPlanEvict(const frame_arena_t* arena, size_t len, frame_arena_evictable_fn evictable, void* ctx,
+                        uint8_t** victims, int maxVictims)
+{
+    size_t need = alignUp(len + ARENA_HDR_SIZE);
+    if (need > arena->capacity) return -1;
+
+    size_t winStart = 0, winSize = 0;
+    int winVictims = 0;
+    size_t bestStart = 0, bestEnd = 0;
+    int bestVictims = -1;
+
+    for (size_t off = 0; off < arena->capacity; off += blockAt(arena, off)->size)
+    {
+        const arena_block_t* b = blockAt(arena, off);
+        bool isFree = b->state == ARENA_BLOCK_FREE;
+
+        if (!isFree && !evictable(arena->base + off + ARENA_HDR_SIZE, ctx))
+        {
+            winStart = off + b->size;
+            winSize = 0;
+            winVictims = 0;
+            continue;
+        }
+
+        winSize += b->size;
+        if (!isFree) winVictims++;
+
+        // Thu hẹp đầu cửa sổ khi vẫn còn đủ chỗ
+        while (winSize - blockAt(arena, winStart)->size >= need)
+        {
+            const arena_block_t* first = blockAt(arena, winStart);
+            if (first->state != ARENA_BLOCK_FREE) winVictims--;
+            winSize -= first->size;
+            winStart += first->size;
+        }
+
+        if (winSize >= need && winVictims <= maxVictims && (bestVictims < 0 || winVictims < bestVictims))
+        {
+            bestStart = winStart;
+            bestEnd = off + b->size;
+            bestVictims = winVictims;
+        }
+    }
+
+    if (bestVictims < 0) return -1;
+
+    int n = 0;
+    for (size_t off = bestStart; off < bestEnd; off += blockAt(arena, off)->size)
+    {
+        if (blockAt(arena, off)->state != ARENA_BLOCK_FREE) victims[n++] = arena->base + off + ARENA_HDR_SIZE;
+    }
+    return n;
+}
+
+size_t frameArenaLargestFree(const frame_arena_t* arena)
+{
+    size_t largest = 0;
+    for (size_t off = 0; off < arena->capacity; off += blockAt(arena, off)->size)
+    {
+        const arena_block_t* b = blockAt(arena, off);
+        if (b->state == ARENA_BLOCK_FREE && b->size > largest) largest = b->size;
+    }
+    return largest;
+}
+
+// Phần trăm vùng trống không nằm trong lỗ lớn nhất (phân mảnh ngoài)
+uint32_t frameArenaFragmentation(const frame_arena_t* arena)
+{
+    size_t freeBytes = arena->capacity - arena->live;
+    if (freeBytes == 0) return 0;
+    return (uint32_t)((freeBytes - frameArenaLargestFree(arena)) * 100 / freeBytes);
+}
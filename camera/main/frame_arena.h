@@ -0,0 +1,37 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include "config.h"
+
+// Arena cho JPEG có kích thước thay đổi trong 1 vùng PSRAM.
+// Block nằm liền nhau theo địa chỉ, block free được gộp với hàng xóm khi giải phóng.
+// Cấp phát next-fit từ sau block cấp gần nhất: khi không có block bị giữ lâu thì chạy như FIFO,
+// khi 1 reader giữ frame cũ thì frame mới vẫn lấp vào lỗ trống phía sau nó.
+// Không tự khoá: caller phải giữ lock khi gọi.
+
+#define FRAME_ARENA_ALIGN 32
+
+typedef struct {
+    uint8_t* base;
+    size_t capacity;
+    size_t rover;           // offset bắt đầu tìm chỗ trống ở lần cấp sau
+    size_t live;            // bytes của các block còn đang dùng (gồm header)
+    size_t highWater;       // giá trị lớn nhất của live
+    uint32_t liveBlocks;
+    uint32_t allocCount;
+    uint32_t allocFails;
+} frame_arena_t;
+
+// Trả về true nếu block ptr có thể bị xoá để lấy chỗ
+typedef bool (*frame_arena_evictable_fn)(const uint8_t* ptr, void* ctx);
+
+bool frameArenaInit(frame_arena_t* arena, size_t capacity);
+uint8_t* frameArenaAlloc(frame_arena_t* arena, size_t len);
+void frameArenaFree(frame_arena_t* arena, uint8_t* ptr);
+void frameArenaReset(frame_arena_t* arena);
+int frameArenaPlanEvict(const frame_arena_t* arena, size_t len, frame_arena_evictable_fn evictable, void* ctx,
+                        uint8_t** victims, int maxVictims);
+size_t frameArenaLargestFree(const frame_arena_t* arena);
+uint32_t frameArenaFragmentation(const frame_arena_t* arena);
+
+#endif
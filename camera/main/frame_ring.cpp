@@ -0,0 +1,222 @@
+#include "frame_ring.h"
+#include "camera_handler.h"
+#include "stream_stats.h"
+#include "trace.h"
+
+frame_slot_t frameRing[FRAME_RING_SLOTS];
+volatile uint32_t frameRingLatestSeq = 0;
+uint32_t frameRingDropped = 0;
+cs_hold_stats_t frameRingCsStats = {0, 0, 0, 0};
+frame_arena_t frameArena;
+
+static int latestSlot = -1;
+
+bool initializeFrameRing()
+{
+    if (!frameArenaInit(&frameArena, FRAME_ARENA_SIZE)) return false;
+
+    for (int i = 0; i < FRAME_RING_SLOTS; i++)
+    {
+        frameRing[i].data = nullptr;
+        frameRing[i].len = 0;
+        frameRing[i].seq = 0;
+        frameRing[i].refcnt = 0;
+    }
+    return true;
+}
+
+static inline void releaseSlotData(int i)
+{
+    frameArenaFree(&frameArena, frameRing[i].data);
+    frameRing[i].data = nullptr;
+    frameRing[i].len = 0;
+    frameRing[i].seq = 0;
+}
+
+// Slot cũ nhất mà không reader nào giữ (bỏ qua slot exclude)
+static int oldestFreeSlot(int exclude, bool withData)
+{
+    int best = -1;
+    for (int i = 0; i < FRAME_RING_SLOTS; i++)
+    {
+        if (i == latestSlot || i == exclude || frameRing[i].refcnt != 0) continue;
+        if (withData && frameRing[i].data == nullptr) continue;
+        if (best == -1 || frameRing[i].seq < frameRing[best].seq) best = i;
+    }
+    return best;
+}
+
+// Block của slot nào không bị reader giữ thì được xoá để lấy chỗ (ctx = slot đang ghi)
+static bool slotEvictable(const uint8_t* ptr, void* ctx)
+{
+    int exclude = *(int*)ctx;
+    for (int i = 0; i < FRAME_RING_SLOTS; i++)
+    {
+        if (frameRing[i].data != ptr) continue;
+        return i != latestSlot && i != exclude && frameRing[i].refcnt == 0;
+    }
+    return false;
+}
+
+// Chọn descriptor và cấp vùng arena cho frame mới.
+// Arena đầy thì chỉ xoá các frame nằm trong 1 dải liền kề đủ chỗ; nếu frame bị giữ chặn mọi dải
+// thì bỏ frame mới và giữ nguyên lịch sử. Gọi khi đang giữ frameMux. Slot trả về được writer giữ 1 ref.
+static int claimWriteSlot(size_t len)
+{
+    int slot = oldestFreeSlot(-1, false);
+    if (slot < 0) return -1;
+
+    releaseSlotData(slot);
+
+    uint8_t* data = frameArenaAlloc(&frameArena, len);
+    if (data == nullptr)
+    {
+        uint8_t* victims[FRAME_RING_SLOTS];
+        int n = frameArenaPlanEvict(&frameArena, len, slotEvictable, &slot, victims, FRAME_RING_SLOTS);
+        if (n < 0) return -1;
+
+        for (int v = 0; v < n; v++)
+        {
+            for (int i = 0; i < FRAME_RING_SLOTS; i++)
+            {
+                if (frameRing[i].data == victims[v]) releaseSlotData(i);
+            }
+        }
+
+        data = frameArenaAlloc(&frameArena, len);
+        if (data == nullptr) return -1;
+    }
+
+    frameRing[slot].data = data;
+    frameRing[slot].refcnt = 1;
+    return slot;
+}
+
+static inline void publishSlot(int slot, size_t len, int64_t captureUs)
+{
+    int64_t now = esp_timer_get_time();
+    latencyRecord(&captureToPublishHist, (uint32_t)(now - captureUs));
+
+    frameRing[slot].captureUs = captureUs;
+    frameRing[slot].publishUs = now;
+    frameRing[slot].len = len;
+    frameRing[slot].seq = frameRingLatestSeq + 1;
+    frameRing[slot].refcnt = 0;
+    frameRingLatestSeq = frameRing[slot].seq;
+    latestSlot = slot;
+}
+
+static inline void recordCsHold(uint32_t startCycles)
+{
+    uint32_t held = ESP.getCycleCount() - startCycles;
+    frameRingCsStats.count++;
+    frameRingCsStats.lastCycles = held;
+    frameRingCsStats.totalCycles += held;
+    if (held > frameRingCsStats.maxCycles) frameRingCsStats.maxCycles = held;
+}
+
+#if FRAME_HANDOFF_COPY_IN_CS
+// Cách cũ: memcpy cả frame trong critical section
+void frameRingPush(const uint8_t* data, size_t len, int64_t captureUs)
+{
+    TRACE_SCOPE("frame_ring_push");
+    portENTER_CRITICAL_ISR(&frameMux);
+    uint32_t start = ESP.getCycleCount();
+    int slot = claimWriteSlot(len);
+    if (slot >= 0)
+    {
+        memcpy(frameRing[slot].data, data, len);
+        publishSlot(slot, len, captureUs);
+    }
+    else
+    {
+        frameRingDropped++;
+    }
+    recordCsHold(start);
+    portEXIT_CRITICAL_ISR(&frameMux);
+}
+#else
+// Writer giữ 1 ref trên slot trong lúc copy ngoài critical section,
+// critical section chỉ còn chọn slot và publish descriptor
+void frameRingPush(const uint8_t* data, size_t len, int64_t captureUs)
+{
+    TRACE_SCOPE("frame_ring_push");
+    portENTER_CRITICAL_ISR(&frameMux);
+    uint32_t start = ESP.getCycleCount();
+    int slot = claimWriteSlot(len);
+    if (slot < 0) frameRingDropped++;
+    recordCsHold(start);
+    portEXIT_CRITICAL_ISR(&frameMux);
+
+    if (slot < 0) return;
+
+    uint8_t* dst = frameRing[slot].data;
+    {
+        TRACE_SCOPE("frame_ring_copy");
+        memcpy(dst, data, len);
+    }
+
+    portENTER_CRITICAL_ISR(&frameMux);
+    start = ESP.getCycleCount();
+    publishSlot(slot, len, captureUs);
+    recordCsHold(start);
+    portEXIT_CRITICAL_ISR(&frameMux);
+}
+#endif
+
+// Trả về frame mới nhất nếu mới hơn lastSeq, tăng refcount; NULL nếu chưa có frame mới
+frame_slot_t* frameRingAcquire(uint32_t lastSeq)
+{
+    frame_slot_t* slot = nullptr;
+
+    portENTER_CRITICAL(&frameMux);
+    if (latestSlot >= 0 && frameRing[latestSlot].seq != lastSeq)
+    {
+        slot = &frameRing[latestSlot];
+        slot->refcnt++;
+    }
+    portEXIT_CRITICAL(&frameMux);
+
+    return slot;
+}
+
+void frameRingRelease(frame_slot_t* slot)
+{
+    if (slot == nullptr) return;
+
+    portENTER_CRITICAL(&frameMux);
+    if (slot->refcnt > 0) slot->refcnt--;
+    portEXIT_CRITICAL(&frameMux);
+}
+
+// Bỏ mọi frame không có reader giữ. Slot đang bị giữ (event buffer, AVI, writer đang copy) vẫn
+// nguyên data và refcnt đến khi reader release, chỉ không còn là frame mới nhất nữa.
+void frameRingReset()
+{
+    portENTER_CRITICAL(&frameMux);
+    for (int i = 0; i < FRAME_RING_SLOTS; i++)
+    {
+        if (frameRing[i].refcnt == 0) releaseSlotData(i);
+    }
+    latestSlot = -1;
+    portEXIT_CRITICAL(&frameMux);
+}
+
+void frameRingLogStats()
+{
+    uint32_t mhz = ESP.getCpuFreqMHz();
+    cs_hold_stats_t st = frameRingCsStats;
+    uint32_t avg = st.count ? (uint32_t)(st.totalCycles / st.count) : 0;
+
+    Serial.printf("[FRAME] Handoff %s: CS held last=%luus avg=%luus max=%luus (%lu sections), dropped=%lu\n",
+                  FRAME_HANDOFF_COPY_IN_CS ? "copy-in-CS" : "descriptor",
+                  (unsigned long)(st.lastCycles / mhz), (unsigned long)(avg / mhz),
+                  (unsigned long)(st.maxCycles / mhz), (unsigned long)st.count,
+                  (unsigned long)frameRingDropped);
+
+    Serial.printf("[FRAME] Arena: %u/%u KB used, high-water %u KB, %lu frames, frag %lu%%, alloc fails %lu\n",
+                  (unsigned)(frameArena.live / 1024), (unsigned)(frameArena.capacity / 1024),
+                  (unsigned)(frameArena.highWater / 1024), (unsigned long)frameArena.liveBlocks,
+                  (unsigned long)frameArenaFragmentation(&frameArena),
+                  (unsigned long)frameArena.allocFails);
+}
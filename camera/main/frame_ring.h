@@ -0,0 +1,45 @@
+#ifndef FRAME_RING_H
+#define FRAME_RING_H
+
+#include "config.h"
+#include "frame_arena.h"
+
+// Slot chỉ là descriptor, dữ liệu JPEG nằm trong frameArena nên có thể giữ lịch sử sâu.
+// Cần ít nhất: mỗi reader giữ 1 slot, +1 slot mới nhất, +1 slot để ghi
+// Reader: các stream client + motion detector + event buffer + AVI recorder + RTSP + multicast
+#define FRAME_RING_READERS (MAX_CLIENTS + 5)
+#define FRAME_RING_SLOTS   32
+
+static_assert(FRAME_RING_READERS + 2 <= FRAME_RING_SLOTS, "frame ring needs one slot per reader + latest + writer");
+
+typedef struct {
+    uint8_t* data;      // nằm trong frameArena, nullptr = chưa cấp
+    size_t len;
+    uint32_t seq;       // 0 = slot empty
+    uint8_t refcnt;     // number of readers holding this slot
+    int64_t captureUs;  // esp_timer_get_time() khi frame_cb nhận frame
+    int64_t publishUs;  // khi frame được đưa vào ring
+} frame_slot_t;
+
+// Thời gian giữ frameMux khi publish frame (đơn vị CPU cycles)
+typedef struct {
+    uint32_t count;
+    uint32_t lastCycles;
+    uint32_t maxCycles;
+    uint64_t totalCycles;
+} cs_hold_stats_t;
+
+extern frame_slot_t frameRing[FRAME_RING_SLOTS];
+extern volatile uint32_t frameRingLatestSeq;
+extern uint32_t frameRingDropped;
+extern cs_hold_stats_t frameRingCsStats;
+extern frame_arena_t frameArena;
+
+bool initializeFrameRing();
+void frameRingPush(const uint8_t* data, size_t len, int64_t captureUs);
+frame_slot_t* frameRingAcquire(uint32_t lastSeq);
+void frameRingRelease(frame_slot_t* slot);
+void frameRingReset();
+void frameRingLogStats();
+
+#endif
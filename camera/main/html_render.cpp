@@ -0,0 +1,98 @@
+#include "html_render.h"
+#include "web_server.h"
+
+static void flush(html_render_t* r)
+{
+    if (r->len == 0) return;
+    server.sendContent(r->buf, r->len);
+    r->len = 0;
+}
+
+void htmlRenderBegin(html_render_t* r, int code)
+{
+    r->len = 0;
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(code, "text/html; charset=utf-8", "");
+}
+
+void htmlRenderRaw(html_render_t* r, const char* s, size_t n)
+{
+    // Đoạn lớn hơn buffer thì gửi thẳng từ flash, không copy
+    if (n >= HTML_RENDER_CHUNK)
+    {
+        flush(r);
+        server.sendContent(s, n);
+        return;
+    }
+
+    while (n > 0)
+    {
+        size_t space = HTML_RENDER_CHUNK - r->len;
+        size_t k = n < space ? n : space;
+        memcpy(r->buf + r->len, s, k);
+        r->len += k;
+        s += k;
+        n -= k;
+        if (r->len == HTML_RENDER_CHUNK) flush(r);
+    }
+}
+
+// Escape cho cả nội dung thẻ lẫn giá trị attribute trong nháy đơn / kép
+void htmlRenderText(html_render_t* r, const char* s)
+{
+    const char* run = s;
+    for (; *s; s++)
+    {
+        const char* entity;
+        switch (*s)
+        {
+        case '&':  entity = "&amp;";  break;
+        case '<':  entity = "&lt;";   break;
+        case '>':  entity = "&gt;";   break;
+        case '"':  entity = "&quot;"; break;
+        case '\'': entity = "&#39;";  break;
+        default:   continue;
+        }
+        htmlRenderRaw(r, run, s - run);
+        htmlRenderRaw(r, entity, strlen(entity));
+        run = s + 1;
+    }
+    htmlRenderRaw(r, run, s - run);
+}
+
+void htmlRenderInt(html_render_t* r, long v)
+{
+    char num[12];
+    int n = snprintf(num, sizeof(num), "%ld", v);
+    htmlRenderRaw(r, num, n);
+}
+
+void htmlRenderTemplate(html_render_t* r, const char* tpl, html_slot_fn fn, void* ctx)
+{
+    while (*tpl)
+    {
+        const char* open = strstr(tpl, "{{");
+        const char* close = open ? strstr(open + 2, "}}") : nullptr;
+        if (close == nullptr || close - open - 2 >= HTML_RENDER_KEY_MAX)
+        {
+            htmlRenderRaw(r, tpl, strlen(tpl));
+            return;
+        }
+
+        htmlRenderRaw(r, tpl, open - tpl);
+
+        char key[HTML_RENDER_KEY_MAX];
+        size_t keyLen = close - open - 2;
+        memcpy(key, open + 2, keyLen);
+        key[keyLen] = '\0';
+        if (fn) fn(r, key, ctx);
+
+        tpl = close + 2;
+    }
+}
+
+void htmlRenderEnd(html_render_t* r)
+{
+    flush(r);
+    server.sendContent("");     // chunk rỗng kết thúc response
+}
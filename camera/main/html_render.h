@@ -0,0 +1,29 @@
+#ifndef HTML_RENDER_H
+#define HTML_RENDER_H
+
+#include "config.h"
+
+// Render trang HTML động không cấp phát heap: template nằm trong flash, chỗ {{tên}} do callback
+// điền (giá trị đã escape), gom vào buffer cố định rồi gửi từng chunk (Transfer-Encoding: chunked).
+
+#define HTML_RENDER_CHUNK   1024
+#define HTML_RENDER_KEY_MAX 16
+
+typedef struct html_render html_render_t;
+
+// Gọi cho mỗi {{key}} trong template, ctx do người gọi truyền vào
+typedef void (*html_slot_fn)(html_render_t* r, const char* key, void* ctx);
+
+struct html_render {
+    char buf[HTML_RENDER_CHUNK];
+    size_t len;
+};
+
+void htmlRenderBegin(html_render_t* r, int code);
+void htmlRenderRaw(html_render_t* r, const char* s, size_t n);
+void htmlRenderText(html_render_t* r, const char* s);
+void htmlRenderInt(html_render_t* r, long v);
+void htmlRenderTemplate(html_render_t* r, const char* tpl, html_slot_fn fn, void* ctx);
+void htmlRenderEnd(html_render_t* r);
+
+#endif
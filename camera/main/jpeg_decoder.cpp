@@ -0,0 +1,401 @@
+#include "jpeg_decoder.h"
+
+const uint8_t jpegZigzag[64] = {
+     0,  1,  8, 16,  9,  2,  3, 10,
+    17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34,
+    27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36,
+    29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46,
+    53, 60, 61, 54, 47, 55, 62, 63
+};
+
+// Bảng Huffman chuẩn (ITU T.81 Annex K.3), camera UVC thường bỏ DHT và ngầm dùng các bảng này
+const uint8_t jpegStdDcLumBits[16] = { 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 };
+const uint8_t jpegStdDcLumVals[12] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+const uint8_t jpegStdDcChromBits[16] = { 0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0 };
+const uint8_t jpegStdDcChromVals[12] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+
+const uint8_t jpegStdAcLumBits[16] = { 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d };
+const uint8_t jpegStdAcLumVals[162] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+    0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+    0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+    0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+    0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+    0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+    0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa
+};
+
+const uint8_t jpegStdAcChromBits[16] = { 0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77 };
+const uint8_t jpegStdAcChromVals[162] = {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+    0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0,
+    0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+    0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+    0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+    0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+    0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+    0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa
+};
+
+static bool buildHuffTable(jpeg_huff_t* t, const uint8_t bits[16], const uint8_t* vals)
+{
+    int total = 0;
+    for (int i = 0; i < 16; i++) total += bits[i];
+    if (total > 256) return false;
+
+    memset(t->fastLen, 0, sizeof(t->fastLen));
+    memcpy(t->values, vals, total);
+
+    int32_t code = 0;
+    int k = 0;
+    for (int len = 1; len <= 16; len++)
+    {
+        t->valOffset[len] = k - code;
+        if (code + bits[len - 1] > (1 << len)) return false;
+        for (int i = 0; i < bits[len - 1]; i++)
+        {
+            if (len <= JPEG_HUFF_FAST_BITS)
+            {
+                int shift = JPEG_HUFF_FAST_BITS - len;
+                for (int j = 0; j < (1 << shift); j++)
+                {
+                    t->fastLen[(code << shift) | j] = len;
+                    t->fastVal[(code << shift) | j] = vals[k];
+                }
+            }
+            code++;
+            k++;
+        }
+        t->maxCode[len] = bits[len - 1] ? code - 1 : -1;
+        code <<= 1;
+    }
+    t->maxCode[17] = INT32_MAX;
+    return true;
+}
+
+static inline uint16_t readU16(const uint8_t* p)
+{
+    return ((uint16_t)p[0] << 8) | p[1];
+}
+
+static bool parseDht(jpeg_decoder_t* dec, const uint8_t* p, size_t len)
+{
+    while (len >= 17)
+    {
+        uint8_t tc = p[0] >> 4;
+        uint8_t th = p[0] & 0x0F;
+        int total = 0;
+        for (int i = 0; i < 16; i++) total += p[1 + i];
+        if (th > 1 || tc > 1 || len < (size_t)(17 + total)) return false;
+
+        jpeg_huff_t* t = tc ? &dec->acTables[th] : &dec->dcTables[th];
+        if (!buildHuffTable(t, p + 1, p + 17)) return false;
+
+        p += 17 + total;
+        len -= 17 + total;
+    }
+    dec->hasDht = true;
+    return true;
+}
+
+static bool parseDqt(jpeg_decoder_t* dec, const uint8_t* p, size_t len)
+{
+    while (len >= 65)
+    {
+        uint8_t pq = p[0] >> 4;
+        uint8_t tq = p[0] & 0x0F;
+        if (tq > 3) return false;
+
+        if (pq == 0)
+        {
+            for (int i = 0; i < 64; i++) dec->qt[tq][i] = p[1 + i];
+            p += 65;
+            len -= 65;
+        }
+        else
+        {
+            if (len < 129) return false;
+            for (int i = 0; i < 64; i++) dec->qt[tq][i] = readU16(p + 1 + 2 * i);
+            p += 129;
+            len -= 129;
+        }
+    }
+    return true;
+}
+
+static bool parseSof(jpeg_decoder_t* dec, const uint8_t* p, size_t len)
+{
+    if (len < 6 || p[0] != 8) return false;
+
+    dec->height = readU16(p + 1);
+    dec->width = readU16(p + 3);
+    dec->numComps = p[5];
+    if (dec->numComps != 1 && dec->numComps != 3) return false;
+    if (len < 6 + 3 * (size_t)dec->numComps || dec->width == 0 || dec->height == 0) return false;
+
+    dec->hmax = 1;
+    dec->vmax = 1;
+    for (int c = 0; c < dec->numComps; c++)
+    {
+        jpeg_component_t* comp = &dec->comps[c];
+        comp->id = p[6 + 3 * c];
+        comp->h = p[7 + 3 * c] >> 4;
+        comp->v = p[7 + 3 * c] & 0x0F;
+        comp->tq = p[8 + 3 * c] & 0x03;
+        if (comp->h < 1 || comp->h > 2 || comp->v < 1 || comp->v > 2) return false;
+        if (dec->numComps == 1) comp->h = comp->v = 1;
+        dec->hmax = max(dec->hmax, comp->h);
+        dec->vmax = max(dec->vmax, comp->v);
+    }
+
+    dec->mcusX = (dec->width + 8 * dec->hmax - 1) / (8 * dec->hmax);
+    dec->mcusY = (dec->height + 8 * dec->vmax - 1) / (8 * dec->vmax);
+    for (int c = 0; c < dec->numComps; c++)
+    {
+        dec->comps[c].blocksW = dec->mcusX * dec->comps[c].h;
+        dec->comps[c].blocksH = dec->mcusY * dec->comps[c].v;
+    }
+    return true;
+}
+
+static bool parseSos(jpeg_decoder_t* dec, const uint8_t* p, size_t len)
+{
+    // Chỉ hỗ trợ 1 scan chứa đủ mọi component (baseline interleaved)
+    if (len < 1 || p[0] != dec->numComps || len < 4 + 2 * (size_t)p[0]) return false;
+
+    for (int i = 0; i < dec->numComps; i++)
+    {
+        uint8_t id = p[1 + 2 * i];
+        uint8_t tables = p[2 + 2 * i];
+        int c = 0;
+        while (c < dec->numComps && dec->comps[c].id != id) c++;
+        if (c != i) return false;
+
+        dec->comps[c].td = tables >> 4;
+        dec->comps[c].ta = tables & 0x0F;
+        if (dec->comps[c].td > 1 || dec->comps[c].ta > 1) return false;
+    }
+    return true;
+}
+
+bool jpegDecoderBegin(jpeg_decoder_t* dec, const uint8_t* data, size_t len)
+{
+    dec->numComps = 0;
+    dec->restartInterval = 0;
+    dec->hasDht = false;
+
+    if (len < 4 || data[0] != 0xFF || data[1] != 0xD8) return false;
+
+    size_t pos = 2;
+    bool haveSof = false;
+
+    while (true)
+    {
+        while (pos < len && data[pos] == 0xFF) pos++;
+        if (pos + 3 > len) return false;
+
+        uint8_t marker = data[pos++];
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) continue;
+        if (marker == 0xD8 || marker == 0xD9) return false;
+
+        size_t segLen = readU16(data + pos);
+        if (segLen < 2 || pos + segLen > len) return false;
+
+        const uint8_t* seg = data + pos + 2;
+        size_t body = segLen - 2;
+
+        switch (marker)
+        {
+            case 0xC0:
+            case 0xC1:
+                if (!parseSof(dec, seg, body)) return false;
+                haveSof = true;
+                break;
+            case 0xC4:
+                if (!parseDht(dec, seg, body)) return false;
+                break;
+            case 0xDB:
+                if (!parseDqt(dec, seg, body)) return false;
+                break;
+            case 0xDD:
+                if (body < 2) return false;
+                dec->restartInterval = readU16(seg);
+                break;
+            case 0xDA:
+                if (!haveSof || !parseSos(dec, seg, body)) return false;
+                pos += segLen;
+                goto scanStart;
+            default:
+                // progressive/lossless/arithmetic không hỗ trợ
+                if (marker >= 0xC2 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) return false;
+                break;
+        }
+        pos += segLen;
+    }
+
+scanStart:
+    if (!dec->hasDht)
+    {
+        buildHuffTable(&dec->dcTables[0], jpegStdDcLumBits, jpegStdDcLumVals);
+        buildHuffTable(&dec->acTables[0], jpegStdAcLumBits, jpegStdAcLumVals);
+        buildHuffTable(&dec->dcTables[1], jpegStdDcChromBits, jpegStdDcChromVals);
+        buildHuffTable(&dec->acTables[1], jpegStdAcChromBits, jpegStdAcChromVals);
+    }
+
+    for (int c = 0; c < dec->numComps; c++) dec->comps[c].dcPred = 0;
+
+    dec->pos = data + pos;
+    dec->end = data + len;
+    dec->bitBuf = 0;
+    dec->bitCnt = 0;
+    dec->hitMarker = false;
+    dec->mcusToRestart = dec->restartInterval;
+    dec->firstMcu = true;
+    return true;
+}
+
+static inline void fillBits(jpeg_decoder_t* dec)
+{
+    while (dec->bitCnt <= 24)
+    {
+        uint32_t b = 0;
+        if (!dec->hitMarker && dec->pos < dec->end)
+        {
+            b = *dec->pos++;
+            if (b == 0xFF)
+            {
+                uint8_t next = (dec->pos < dec->end) ? *dec->pos : 0xD9;
+                if (next == 0x00)
+                {
+                    dec->pos++;
+                }
+                else
+                {
+                    // Dừng trước marker, phần còn lại đệm bằng 0
+                    dec->hitMarker = true;
+                    dec->pos--;
+                    b = 0;
+                }
+            }
+        }
+        dec->bitBuf |= b << (24 - dec->bitCnt);
+        dec->bitCnt += 8;
+    }
+}
+
+static inline void skipBits(jpeg_decoder_t* dec, int n)
+{
+    dec->bitBuf <<= n;
+    dec->bitCnt -= n;
+}
+
+static inline int decodeHuff(jpeg_decoder_t* dec, const jpeg_huff_t* t)
+{
+    fillBits(dec);
+
+    uint32_t look = dec->bitBuf >> (32 - JPEG_HUFF_FAST_BITS);
+    int len = t->fastLen[look];
+    if (len)
+    {
+        skipBits(dec, len);
+        return t->fastVal[look];
+    }
+
+    for (len = JPEG_HUFF_FAST_BITS + 1; len <= 16; len++)
+    {
+        int32_t code = (int32_t)(dec->bitBuf >> (32 - len));
+        if (code <= t->maxCode[len])
+        {
+            skipBits(dec, len);
+            return t->values[t->valOffset[len] + code];
+        }
+    }
+    return -1;
+}
+
+static inline int receiveExtend(jpeg_decoder_t* dec, int s)
+{
+    fillBits(dec);
+    int v = (int)(dec->bitBuf >> (32 - s));
+    skipBits(dec, s);
+    if (v < (1 << (s - 1))) v += 1 - (1 << s);
+    return v;
+}
+
+// Gọi trước mỗi MCU, xử lý restart marker
+bool jpegDecoderStartMcu(jpeg_decoder_t* dec)
+{
+    if (dec->restartInterval == 0) return true;
+
+    if (dec->firstMcu)
+    {
+        dec->firstMcu = false;
+        dec->mcusToRestart = dec->restartInterval;
+    }
+    else if (dec->mcusToRestart == 0)
+    {
+        const uint8_t* p = dec->pos;
+        while (p + 1 < dec->end && !(p[0] == 0xFF && p[1] >= 0xD0 && p[1] <= 0xD7)) p++;
+        if (p + 1 >= dec->end) return false;
+
+        dec->pos = p + 2;
+        dec->bitBuf = 0;
+        dec->bitCnt = 0;
+        dec->hitMarker = false;
+        for (int c = 0; c < dec->numComps; c++) dec->comps[c].dcPred = 0;
+        dec->mcusToRestart = dec->restartInterval;
+    }
+
+    dec->mcusToRestart--;
+    return true;
+}
+
+// coef nhận hệ số đã lượng tử theo thứ tự zigzag; dcOnly chỉ ghi coef[0] nhưng vẫn phải đọc qua AC
+bool jpegDecodeBlock(jpeg_decoder_t* dec, int comp, int16_t coef[64], bool dcOnly)
+{
+    jpeg_component_t* c = &dec->comps[comp];
+
+    int s = decodeHuff(dec, &dec->dcTables[c->td]);
+    if (s < 0 || s > 11) return false;
+
+    int diff = s ? receiveExtend(dec, s) : 0;
+    c->dcPred += diff;
+
+    if (!dcOnly) memset(coef, 0, 64 * sizeof(int16_t));
+    coef[0] = (int16_t)c->dcPred;
+
+    const jpeg_huff_t* ac = &dec->acTables[c->ta];
+    for (int k = 1; k < 64; )
+    {
+        int rs = decodeHuff(dec, ac);
+        if (rs < 0) return false;
+
+        int r = rs >> 4;
+        s = rs & 0x0F;
+
+        if (s)
+        {
+            k += r;
+            if (k > 63) return false;
+            int v = receiveExtend(dec, s);
+            if (!dcOnly) coef[k] = (int16_t)v;
+            k++;
+        }
+        else
+        {
+            if (r != 15) break;
+            k += 16;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,67 @@
+#ifndef JPEG_DECODER_H
+#define JPEG_DECODER_H
+
+#include "config.h"
+
+// Giải mã entropy JPEG baseline tới mức hệ số DCT (không IDCT).
+// Dùng chung cho scaler preview và các bước phân tích frame.
+
+#define JPEG_MAX_COMPS      3
+#define JPEG_HUFF_FAST_BITS 9
+
+typedef struct {
+    uint8_t fastLen[1 << JPEG_HUFF_FAST_BITS];  // 0 = mã dài hơn FAST_BITS
+    uint8_t fastVal[1 << JPEG_HUFF_FAST_BITS];
+    int32_t maxCode[18];
+    int32_t valOffset[18];
+    uint8_t values[256];
+} jpeg_huff_t;
+
+typedef struct {
+    uint8_t id;
+    uint8_t h, v;           // sampling factors
+    uint8_t tq;             // bảng lượng tử
+    uint8_t td, ta;         // bảng Huffman DC / AC
+    int dcPred;
+    uint16_t blocksW;       // số block mỗi hàng (làm tròn theo MCU)
+    uint16_t blocksH;
+} jpeg_component_t;
+
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    uint8_t numComps;
+    jpeg_component_t comps[JPEG_MAX_COMPS];
+    uint8_t hmax, vmax;
+    uint16_t mcusX, mcusY;
+    uint16_t restartInterval;
+    bool hasDht;
+    uint16_t qt[4][64];     // thứ tự zigzag
+    jpeg_huff_t dcTables[2];
+    jpeg_huff_t acTables[2];
+
+    // bit reader
+    const uint8_t* pos;
+    const uint8_t* end;
+    uint32_t bitBuf;        // bit kế tiếp nằm ở MSB
+    int bitCnt;
+    bool hitMarker;
+    uint16_t mcusToRestart;
+    bool firstMcu;
+} jpeg_decoder_t;
+
+extern const uint8_t jpegZigzag[64];
+extern const uint8_t jpegStdDcLumBits[16];
+extern const uint8_t jpegStdDcLumVals[12];
+extern const uint8_t jpegStdDcChromBits[16];
+extern const uint8_t jpegStdDcChromVals[12];
+extern const uint8_t jpegStdAcLumBits[16];
+extern const uint8_t jpegStdAcLumVals[162];
+extern const uint8_t jpegStdAcChromBits[16];
+extern const uint8_t jpegStdAcChromVals[162];
+
+bool jpegDecoderBegin(jpeg_decoder_t* dec, const uint8_t* data, size_t len);
+bool jpegDecoderStartMcu(jpeg_decoder_t* dec);
+bool jpegDecodeBlock(jpeg_decoder_t* dec, int comp, int16_t coef[64], bool dcOnly);
+
+#endif
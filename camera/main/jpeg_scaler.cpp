@@ -0,0 +1,437 @@
+#include "jpeg_scaler.h"
+
+#define SCALER_QUALITY 75
+
+typedef struct {
+    uint16_t code[256];
+    uint8_t size[256];
+} huff_enc_t;
+
+typedef struct {
+    uint8_t* out;
+    size_t cap;
+    size_t len;
+    uint32_t acc;
+    int n;
+    bool overflow;
+} bit_writer_t;
+
+static bool tablesReady = false;
+// basis[i][h][U][u], s = 2 << i, k = 8 / s: đóng góp của hệ số u (u < k) ở block gốc thứ h
+// (trong s block ghép theo 1 chiều) vào hệ số U của block đầu ra.
+// Bằng IDCT rút gọn k điểm rồi DCT 8 điểm, gộp sẵn thành 1 phép nhân.
+static float basis[3][8][8][JPEG_SCALER_MAX_K];
+static uint8_t qLum[64];            // thứ tự zigzag
+static uint8_t qChrom[64];
+static huff_enc_t encDcLum, encAcLum, encDcChrom, encAcChrom;
+
+static const uint8_t stdLumQuant[64] = {
+    16, 11, 10, 16,  24,  40,  51,  61,
+    12, 12, 14, 19,  26,  58,  60,  55,
+    14, 13, 16, 24,  40,  57,  69,  56,
+    14, 17, 22, 29,  51,  87,  80,  62,
+    18, 22, 37, 56,  68, 109, 103,  77,
+    24, 35, 55, 64,  81, 104, 113,  92,
+    49, 64, 78, 87, 103, 121, 120, 101,
+    72, 92, 95, 98, 112, 100, 103,  99
+};
+
+static const uint8_t stdChromQuant[64] = {
+    17, 18, 24, 47, 99, 99, 99, 99,
+    18, 21, 26, 66, 99, 99, 99, 99,
+    24, 26, 56, 99, 99, 99, 99, 99,
+    47, 66, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99
+};
+
+static void buildEncTable(huff_enc_t* t, const uint8_t bits[16], const uint8_t* vals)
+{
+    memset(t->size, 0, sizeof(t->size));
+    uint16_t code = 0;
+    int k = 0;
+    for (int len = 1; len <= 16; len++)
+    {
+        for (int i = 0; i < bits[len - 1]; i++)
+        {
+            t->code[vals[k]] = code++;
+            t->size[vals[k]] = len;
+            k++;
+        }
+        code <<= 1;
+    }
+}
+
+static void initTables()
+{
+    if (tablesReady) return;
+
+    const float pi = 3.14159265f;
+    float fdct8[8][8];              // [u][x]
+    for (int u = 0; u < 8; u++)
+        for (int x = 0; x < 8; x++)
+            fdct8[u][x] = 0.5f * (u == 0 ? 0.70710678f : 1.0f) * cosf((2 * x + 1) * u * pi / 16);
+
+    for (int i = 0; i < 3; i++)
+    {
+        int s = 2 << i;
+        int k = 8 / s;
+        for (int h = 0; h < s; h++)
+        {
+            for (int U = 0; U < 8; U++)
+            {
+                for (int u = 0; u < k; u++)
+                {
+                    float sum = 0;
+                    for (int x = 0; x < k; x++)
+                    {
+                        float idct = 0.5f * (u == 0 ? 0.70710678f : 1.0f) * cosf((2 * x + 1) * u * pi / (2 * k));
+                        sum += fdct8[U][h * k + x] * idct;
+                    }
+                    basis[i][h][U][u] = sum;
+                }
+            }
+        }
+    }
+
+    int scale = SCALER_QUALITY < 50 ? 5000 / SCALER_QUALITY : 200 - 2 * SCALER_QUALITY;
+    for (int i = 0; i < 64; i++)
+    {
+        int n = jpegZigzag[i];
+        qLum[i] = (uint8_t)constrain((stdLumQuant[n] * scale + 50) / 100, 1, 255);
+        qChrom[i] = (uint8_t)constrain((stdChromQuant[n] * scale + 50) / 100, 1, 255);
+    }
+
+    buildEncTable(&encDcLum, jpegStdDcLumBits, jpegStdDcLumVals);
+    buildEncTable(&encAcLum, jpegStdAcLumBits, jpegStdAcLumVals);
+    buildEncTable(&encDcChrom, jpegStdDcChromBits, jpegStdDcChromVals);
+    buildEncTable(&encAcChrom, jpegStdAcChromBits, jpegStdAcChromVals);
+
+    tablesReady = true;
+}
+
+bool jpegScalerInit(jpeg_scaler_t* scaler, uint8_t scaleDiv)
+{
+    memset(scaler, 0, sizeof(*scaler));
+    if (scaleDiv != 2 && scaleDiv != 4 && scaleDiv != 8) return false;
+
+    initTables();
+
+    scaler->scaleDiv = scaleDiv;
+    scaler->dec = (jpeg_decoder_t*)heap_caps_malloc(sizeof(jpeg_decoder_t), MALLOC_CAP_SPIRAM);
+    scaler->outCap = MJPEG_MAX_FRAME_SIZE / scaleDiv;
+    scaler->out = (uint8_t*)heap_caps_malloc(scaler->outCap, MALLOC_CAP_SPIRAM);
+
+    if (!scaler->dec || !scaler->out)
+    {
+        jpegScalerFree(scaler);
+        return false;
+    }
+    return true;
+}
+
+void jpegScalerFree(jpeg_scaler_t* scaler)
+{
+    heap_caps_free(scaler->dec);
+    heap_caps_free(scaler->out);
+    for (int c = 0; c < JPEG_MAX_COMPS; c++) heap_caps_free(scaler->acc[c]);
+    memset(scaler, 0, sizeof(*scaler));
+}
+
+static bool ensureAcc(jpeg_scaler_t* scaler, int c, size_t need)
+{
+    if (scaler->accCap[c] < need)
+    {
+        heap_caps_free(scaler->acc[c]);
+        scaler->acc[c] = (float*)heap_caps_malloc(need * sizeof(float), MALLOC_CAP_SPIRAM);
+        scaler->accCap[c] = scaler->acc[c] ? need : 0;
+        if (!scaler->acc[c]) return false;
+    }
+    memset(scaler->acc[c], 0, need * sizeof(float));
+    return true;
+}
+
+// Cộng đóng góp của 1 block gốc (F: k x k hệ số đã giải lượng tử) vào block đầu ra dst.
+// bh, bv: hàng của basis ứng với vị trí block gốc trong block đầu ra theo chiều ngang / dọc.
+static void addBlock(float* dst, const float F[JPEG_SCALER_MAX_K][JPEG_SCALER_MAX_K],
+                     const float bh[8][JPEG_SCALER_MAX_K], const float bv[8][JPEG_SCALER_MAX_K], int k)
+{
+    float rows[JPEG_SCALER_MAX_K][8];
+    for (int v = 0; v < k; v++)
+    {
+        for (int U = 0; U < 8; U++)
+        {
+            float s = 0;
+            for (int u = 0; u < k; u++) s += F[v][u] * bh[U][u];
+            rows[v][U] = s;
+        }
+    }
+
+    for (int V = 0; V < 8; V++)
+    {
+        for (int U = 0; U < 8; U++)
+        {
+            float s = 0;
+            for (int v = 0; v < k; v++) s += bv[V][v] * rows[v][U];
+            dst[V * 8 + U] += s;
+        }
+    }
+}
+
+static inline void putByte(bit_writer_t* bw, uint8_t b)
+{
+    if (bw->len >= bw->cap)
+    {
+        bw->overflow = true;
+        return;
+    }
+    bw->out[bw->len++] = b;
+}
+
+static inline void putBits(bit_writer_t* bw, uint32_t code, int size)
+{
+    bw->acc = (bw->acc << size) | (code & ((1u << size) - 1));
+    bw->n += size;
+    while (bw->n >= 8)
+    {
+        uint8_t b = (uint8_t)(bw->acc >> (bw->n - 8));
+        putByte(bw, b);
+        if (b == 0xFF) putByte(bw, 0x00);
+        bw->n -= 8;
+    }
+    bw->acc &= (1u << bw->n) - 1;
+}
+
+static void flushBits(bit_writer_t* bw)
+{
+    if (bw->n > 0) putBits(bw, 0x7F, 8 - bw->n);
+}
+
+static inline int bitLength(int v)
+{
+    if (v < 0) v = -v;
+    int n = 0;
+    while (v) { n++; v >>= 1; }
+    return n;
+}
+
+static void putU16(bit_writer_t* bw, uint16_t v)
+{
+    putByte(bw, v >> 8);
+    putByte(bw, v & 0xFF);
+}
+
+static void writeDht(bit_writer_t* bw, uint8_t tcTh, const uint8_t bits[16], const uint8_t* vals)
+{
+    int total = 0;
+    for (int i = 0; i < 16; i++) total += bits[i];
+    putByte(bw, 0xFF); putByte(bw, 0xC4);
+    putU16(bw, 3 + 16 + total);
+    putByte(bw, tcTh);
+    for (int i = 0; i < 16; i++) putByte(bw, bits[i]);
+    for (int i = 0; i < total; i++) putByte(bw, vals[i]);
+}
+
+static void writeHeaders(bit_writer_t* bw, const jpeg_decoder_t* dec, uint16_t w, uint16_t h)
+{
+    putByte(bw, 0xFF); putByte(bw, 0xD8);
+
+    putByte(bw, 0xFF); putByte(bw, 0xDB);
+    putU16(bw, 2 + 2 * 65);
+    putByte(bw, 0x00);
+    for (int i = 0; i < 64; i++) putByte(bw, qLum[i]);
+    putByte(bw, 0x01);
+    for (int i = 0; i < 64; i++) putByte(bw, qChrom[i]);
+
+    putByte(bw, 0xFF); putByte(bw, 0xC0);
+    putU16(bw, 8 + 3 * dec->numComps);
+    putByte(bw, 8);
+    putU16(bw, h);
+    putU16(bw, w);
+    putByte(bw, dec->numComps);
+    for (int c = 0; c < dec->numComps; c++)
+    {
+        putByte(bw, c + 1);
+        putByte(bw, (dec->comps[c].h << 4) | dec->comps[c].v);
+        putByte(bw, c == 0 ? 0 : 1);
+    }
+
+    // Luôn ghi DHT để trình duyệt giải mã được
+    writeDht(bw, 0x00, jpegStdDcLumBits, jpegStdDcLumVals);
+    writeDht(bw, 0x10, jpegStdAcLumBits, jpegStdAcLumVals);
+    writeDht(bw, 0x01, jpegStdDcChromBits, jpegStdDcChromVals);
+    writeDht(bw, 0x11, jpegStdAcChromBits, jpegStdAcChromVals);
+
+    putByte(bw, 0xFF); putByte(bw, 0xDA);
+    putU16(bw, 6 + 2 * dec->numComps);
+    putByte(bw, dec->numComps);
+    for (int c = 0; c < dec->numComps; c++)
+    {
+        putByte(bw, c + 1);
+        putByte(bw, c == 0 ? 0x00 : 0x11);
+    }
+    putByte(bw, 0);
+    putByte(bw, 63);
+    putByte(bw, 0);
+}
+
+static void encodeBlock(bit_writer_t* bw, const float* coef, const uint8_t* q,
+                        const huff_enc_t* dcT, const huff_enc_t* acT, int* dcPred)
+{
+    // Giới hạn theo bảng Huffman chuẩn: AC tối đa 10 bit, hiệu DC tối đa 11 bit
+    int zz[64];
+    for (int i = 0; i < 64; i++) zz[i] = constrain((int)lroundf(coef[jpegZigzag[i]] / q[i]), -1023, 1023);
+
+    int diff = zz[0] - *dcPred;
+    *dcPred = zz[0];
+    int nbits = bitLength(diff);
+    putBits(bw, dcT->code[nbits], dcT->size[nbits]);
+    if (nbits) putBits(bw, diff < 0 ? diff - 1 : diff, nbits);
+
+    int run = 0;
+    for (int i = 1; i < 64; i++)
+    {
+        int v = zz[i];
+        if (v == 0)
+        {
+            run++;
+            continue;
+        }
+        while (run > 15)
+        {
+            putBits(bw, acT->code[0xF0], acT->size[0xF0]);
+            run -= 16;
+        }
+        nbits = bitLength(v);
+        int sym = (run << 4) | nbits;
+        putBits(bw, acT->code[sym], acT->size[sym]);
+        putBits(bw, v < 0 ? v - 1 : v, nbits);
+        run = 0;
+    }
+    if (run > 0) putBits(bw, acT->code[0x00], acT->size[0x00]);
+}
+
+// Mã hoá 1 hàng MCU đầu ra từ hệ số đã cộng dồn, cùng sampling factors với frame gốc
+static void encodeRow(bit_writer_t* bw, const jpeg_scaler_t* scaler, const jpeg_decoder_t* dec, int outMcusX,
+                      int* dcPred)
+{
+    for (int mx = 0; mx < outMcusX; mx++)
+    {
+        for (int c = 0; c < dec->numComps; c++)
+        {
+            const jpeg_component_t* comp = &dec->comps[c];
+            int outBlocksW = outMcusX * comp->h;
+            bool luma = (c == 0);
+            for (int by = 0; by < comp->v; by++)
+            {
+                for (int bx = 0; bx < comp->h; bx++)
+                {
+                    encodeBlock(bw, scaler->acc[c] + (by * outBlocksW + mx * comp->h + bx) * 64,
+                                luma ? qLum : qChrom,
+                                luma ? &encDcLum : &encDcChrom,
+                                luma ? &encAcLum : &encAcChrom,
+                                &dcPred[c]);
+                }
+            }
+        }
+    }
+}
+
+bool jpegScaleFrame(jpeg_scaler_t* scaler, const uint8_t* data, size_t len)
+{
+    jpeg_decoder_t* dec = scaler->dec;
+    scaler->outLen = 0;
+    if (!jpegDecoderBegin(dec, data, len)) return false;
+
+    int s = scaler->scaleDiv;
+    int k = 8 / s;
+    int lastZz = (k == 4) ? 24 : (k == 2) ? 4 : 0;     // vị trí zigzag cuối cùng còn nằm trong vùng k x k
+    const float (*table)[8][JPEG_SCALER_MAX_K] = basis[s == 2 ? 0 : s == 4 ? 1 : 2];
+
+    uint16_t outW = (dec->width + s - 1) / s;
+    uint16_t outH = (dec->height + s - 1) / s;
+    int outMcusX = (outW + 8 * dec->hmax - 1) / (8 * dec->hmax);
+    int outMcusY = (outH + 8 * dec->vmax - 1) / (8 * dec->vmax);
+
+    for (int c = 0; c < dec->numComps; c++)
+    {
+        if (!ensureAcc(scaler, c, (size_t)outMcusX * dec->comps[c].h * dec->comps[c].v * 64)) return false;
+    }
+
+    bit_writer_t bw = { scaler->out, scaler->outCap, 0, 0, 0, false };
+    writeHeaders(&bw, dec, outW, outH);
+
+    // Mỗi s hàng MCU gốc cho đúng 1 hàng MCU đầu ra (cùng sampling factors)
+    int dcPred[JPEG_MAX_COMPS] = {0, 0, 0};
+    int outRow = 0;
+    int16_t coef[64];
+    float F[JPEG_SCALER_MAX_K][JPEG_SCALER_MAX_K];
+
+    for (int my = 0; my < dec->mcusY; my++)
+    {
+        for (int mx = 0; mx < dec->mcusX; mx++)
+        {
+            if (!jpegDecoderStartMcu(dec)) return false;
+
+            for (int c = 0; c < dec->numComps; c++)
+            {
+                const jpeg_component_t* comp = &dec->comps[c];
+                const uint16_t* qt = dec->qt[comp->tq];
+                int outBlocksW = outMcusX * comp->h;
+
+                for (int by = 0; by < comp->v; by++)
+                {
+                    for (int bx = 0; bx < comp->h; bx++)
+                    {
+                        if (!jpegDecodeBlock(dec, c, coef, k == 1)) return false;
+
+                        memset(F, 0, sizeof(F));
+                        for (int i = 0; i <= lastZz; i++)
+                        {
+                            int n = jpegZigzag[i];
+                            int u = n & 7;
+                            int v = n >> 3;
+                            if (u < k && v < k) F[v][u] = (float)coef[i] * qt[i];
+                        }
+
+                        // Block cuối hàng / cột được dùng lại cho phần block đầu ra nằm ngoài frame gốc
+                        int ix = mx * comp->h + bx;
+                        int iy = my * comp->v + by;
+                        int xEnd = (ix == comp->blocksW - 1) ? outBlocksW * s - 1 : ix;
+                        int yEnd = (iy == comp->blocksH - 1) ? (outRow + 1) * comp->v * s - 1 : iy;
+
+                        for (int vy = iy; vy <= yEnd; vy++)
+                        {
+                            int oy = vy / s - outRow * comp->v;
+                            if (oy < 0 || oy >= comp->v) continue;
+                            for (int vx = ix; vx <= xEnd && vx / s < outBlocksW; vx++)
+                            {
+                                addBlock(scaler->acc[c] + (oy * outBlocksW + vx / s) * 64, F,
+                                         table[vx % s], table[vy % s], k);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        if ((my + 1) % s == 0 || my == dec->mcusY - 1)
+        {
+            if (outRow < outMcusY) encodeRow(&bw, scaler, dec, outMcusX, dcPred);
+            outRow++;
+            for (int c = 0; c < dec->numComps; c++)
+                memset(scaler->acc[c], 0, (size_t)outMcusX * dec->comps[c].h * dec->comps[c].v * 64 * sizeof(float));
+        }
+        if (bw.overflow) return false;
+    }
+
+    flushBits(&bw);
+    putByte(&bw, 0xFF);
+    putByte(&bw, 0xD9);
+
+    if (bw.overflow) return false;
+    scaler->outLen = bw.len;
+    return true;
+}
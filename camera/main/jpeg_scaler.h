@@ -0,0 +1,27 @@
+#ifndef JPEG_SCALER_H
+#define JPEG_SCALER_H
+
+#include "config.h"
+#include "jpeg_decoder.h"
+
+// Thu nhỏ MJPEG 1/2, 1/4 hoặc 1/8 hoàn toàn trong miền DCT, không có bước pixel nào:
+// mỗi block 8x8 đầu ra ghép từ s x s block gốc, chỉ dùng (8/s) x (8/s) hệ số tần số thấp của mỗi block
+// (1/8 chỉ còn DC) qua 1 ma trận tính sẵn, rồi lượng tử lại và mã hoá entropy baseline.
+
+#define JPEG_SCALER_MAX_K   4       // số hệ số mỗi chiều lấy từ block gốc ở 1/2
+
+typedef struct {
+    uint8_t scaleDiv;               // 2, 4 hoặc 8
+    jpeg_decoder_t* dec;
+    float* acc[JPEG_MAX_COMPS];     // hệ số 1 hàng MCU đầu ra, thứ tự tự nhiên, chưa lượng tử
+    size_t accCap[JPEG_MAX_COMPS];  // số phần tử float
+    uint8_t* out;
+    size_t outCap;
+    size_t outLen;
+} jpeg_scaler_t;
+
+bool jpegScalerInit(jpeg_scaler_t* scaler, uint8_t scaleDiv);
+void jpegScalerFree(jpeg_scaler_t* scaler);
+bool jpegScaleFrame(jpeg_scaler_t* scaler, const uint8_t* data, size_t len);
+
+#endif
@@ -0,0 +1,130 @@
+#include "jpeg_validator.h"
+
+uint32_t jpegDropCount[JPEG_CHECK_COUNT] = {0};
+uint32_t jpegMissingDhtCount = 0;
+
+static const char* const checkNames[JPEG_CHECK_COUNT] = {
+    "ok", "size", "no_soi", "no_eoi", "bad_segment", "no_sof",
+    "dimensions", "no_sos", "bad_entropy", "no_dht"
+};
+
+const char* jpegCheckName(JpegCheck check)
+{
+    return (check < JPEG_CHECK_COUNT) ? checkNames[check] : "unknown";
+}
+
+// Sau 0xFF trong dữ liệu entropy chỉ được phép: 00 (byte stuffing), RST0-7, hoặc FF (fill)
+static inline bool validAfterFF(const uint8_t* p, const uint8_t* end)
+{
+    if (p + 1 >= end) return true;  // FF cuối cùng là fill ngay trước EOI
+    uint8_t next = p[1];
+    return next == 0x00 || next == 0xFF || (next >= 0xD0 && next <= 0xD7);
+}
+
+// Quét từng word 32-bit, chỉ xét từng byte khi word có chứa 0xFF
+static bool scanEntropy(const uint8_t* p, const uint8_t* end)
+{
+    while (p < end && ((uintptr_t)p & 3))
+    {
+        if (*p == 0xFF && !validAfterFF(p, end)) return false;
+        p++;
+    }
+
+    while (p + 4 <= end)
+    {
+        uint32_t inv = ~*(const uint32_t*)p;
+        if ((inv - 0x01010101u) & ~inv & 0x80808080u)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                if (p[i] == 0xFF && !validAfterFF(p + i, end)) return false;
+            }
+        }
+        p += 4;
+    }
+
+    while (p < end)
+    {
+        if (*p == 0xFF && !validAfterFF(p, end)) return false;
+        p++;
+    }
+    return true;
+}
+
+JpegCheck jpegValidate(const uint8_t* data, size_t len, uint16_t width, uint16_t height, jpeg_info_t* info)
+{
+    jpeg_info_t local;
+    if (info == nullptr) info = &local;
+    memset(info, 0, sizeof(*info));
+
+    if (len < MJPEG_MIN_FRAME_SIZE || len > MJPEG_MAX_FRAME_SIZE) return JPEG_ERR_SIZE;
+    if (data[0] != 0xFF || data[1] != 0xD8) return JPEG_ERR_NO_SOI;
+
+    // Một số camera UVC đệm 0x00 sau EOI
+    size_t end = len;
+    while (end > 2 && len - end < 64 && data[end - 1] == 0x00) end--;
+    if (end < 4 || data[end - 2] != 0xFF || data[end - 1] != 0xD9) return JPEG_ERR_NO_EOI;
+    info->eoiOffset = end - 2;
+
+    bool hasSof = false;
+    size_t pos = 2;
+
+    while (true)
+    {
+        if (pos + 4 > info->eoiOffset) return JPEG_ERR_NO_SOS;
+        if (data[pos] != 0xFF) return JPEG_ERR_BAD_SEGMENT;
+        while (data[pos] == 0xFF && pos < info->eoiOffset) pos++;
+
+        uint8_t marker = data[pos++];
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) continue;
+        if (marker == 0xD8 || marker == 0xD9) return JPEG_ERR_NO_SOS;
+        if (pos + 2 > info->eoiOffset) return JPEG_ERR_BAD_SEGMENT;
+
+        size_t segLen = ((size_t)data[pos] << 8) | data[pos + 1];
+        if (segLen < 2 || pos + segLen > info->eoiOffset) return JPEG_ERR_BAD_SEGMENT;
+
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+        {
+            if (segLen < 8) return JPEG_ERR_BAD_SEGMENT;
+            info->height = ((uint16_t)data[pos + 3] << 8) | data[pos + 4];
+            info->width = ((uint16_t)data[pos + 5] << 8) | data[pos + 6];
+            hasSof = true;
+        }
+        else if (marker == 0xC4)
+        {
+            info->hasDht = true;
+        }
+        else if (marker == 0xDA)
+        {
+            info->sosOffset = pos + segLen;
+            break;
+        }
+
+        pos += segLen;
+    }
+
+    if (!hasSof) return JPEG_ERR_NO_SOF;
+    if (info->width != width || info->height != height) return JPEG_ERR_DIMENSIONS;
+
+    if (!info->hasDht)
+    {
+        jpegMissingDhtCount++;
+#if JPEG_REQUIRE_DHT
+        return JPEG_ERR_NO_DHT;
+#endif
+    }
+
+    if (!scanEntropy(data + info->sosOffset, data + info->eoiOffset)) return JPEG_ERR_BAD_ENTROPY;
+
+    return JPEG_OK;
+}
+
+void jpegLogDropStats()
+{
+    Serial.print("[JPEG] Dropped:");
+    for (int i = 1; i < JPEG_CHECK_COUNT; i++)
+    {
+        Serial.printf(" %s=%lu", checkNames[i], (unsigned long)jpegDropCount[i]);
+    }
+    Serial.printf(", missing DHT=%lu\n", (unsigned long)jpegMissingDhtCount);
+}
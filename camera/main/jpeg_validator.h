@@ -0,0 +1,36 @@
+#ifndef JPEG_VALIDATOR_H
+#define JPEG_VALIDATOR_H
+
+#include "config.h"
+
+// Lý do loại frame, dùng làm index cho jpegDropCount
+enum JpegCheck {
+    JPEG_OK = 0,
+    JPEG_ERR_SIZE,          // ngoài khoảng [MJPEG_MIN_FRAME_SIZE, MJPEG_MAX_FRAME_SIZE]
+    JPEG_ERR_NO_SOI,
+    JPEG_ERR_NO_EOI,        // frame bị cắt
+    JPEG_ERR_BAD_SEGMENT,   // độ dài segment vượt quá frame
+    JPEG_ERR_NO_SOF,
+    JPEG_ERR_DIMENSIONS,    // SOF khác FRAME_WIDTH x FRAME_HEIGHT
+    JPEG_ERR_NO_SOS,
+    JPEG_ERR_BAD_ENTROPY,   // marker lạ trong dữ liệu entropy
+    JPEG_ERR_NO_DHT,        // chỉ khi JPEG_REQUIRE_DHT = 1
+    JPEG_CHECK_COUNT
+};
+
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    bool hasDht;            // UVC MJPEG thường bỏ DHT, decoder phải dùng bảng chuẩn
+    size_t sosOffset;       // byte đầu tiên của dữ liệu entropy
+    size_t eoiOffset;       // vị trí FF D9
+} jpeg_info_t;
+
+extern uint32_t jpegDropCount[JPEG_CHECK_COUNT];
+extern uint32_t jpegMissingDhtCount;
+
+JpegCheck jpegValidate(const uint8_t* data, size_t len, uint16_t width, uint16_t height, jpeg_info_t* info);
+const char* jpegCheckName(JpegCheck check);
+void jpegLogDropStats();
+
+#endif
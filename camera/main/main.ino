@@ -6,6 +6,9 @@
 #include "audio_handler.h"
 #include "sensors_handler.h"
 #include "security_system.h"
+#include "metrics.h"
+#include "trace.h"
+#include "sms_outbox.h"
 
 bool sdAudioInitialized = false;
 bool welcomeAudioPlayed = false;
@@ -33,11 +36,17 @@ void setup()
     EEPROM.begin(512);
     loadCredentials();
     initializeBuffers();
+#if TRACE_ENABLED
+    initializeTrace();
+#endif
     initializeCamera();
 }
 
 void loop() 
 {
+    metricsLoopTick();
+    TRACE_SCOPE("loop");
+
      //STATE 1 – Audio Init
     if (!sdAudioInitialized) 
     {
@@ -150,6 +159,11 @@ void loop()
     { 
         handleWebServerLoop();
         handleWiFiLoop();
+
+        // SMS là kênh dự phòng khi mất WiFi nên không phụ thuộc WIFI_STA_OK
+        if (securitySystemInitialized) {
+            handleSmsOutbox();
+        }
         
         if (systemReady && wifiState == WIFI_STA_OK) 
         {
@@ -0,0 +1,189 @@
+#include "mcast_stream.h"
+#include "frame_ring.h"
+#include <lwip/sockets.h>
+
+mcast_stats_t mcastStats;
+
+static int mcastFd = -1;
+static struct sockaddr_in groupAddr;
+static TaskHandle_t mcastTaskHandle = NULL;
+static volatile bool stopRequested = false;
+static volatile unsigned long leaseUntilMs = 0;
+static volatile bool leaseActive = false;
+
+static bool sendDatagram(const mcast_header_t* header, const uint8_t* payload, size_t len)
+{
+    struct iovec iov[2];
+    iov[0].iov_base = (void*)header;
+    iov[0].iov_len = sizeof(*header);
+    iov[1].iov_base = (void*)payload;
+    iov[1].iov_len = len;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &groupAddr;
+    msg.msg_namelen = sizeof(groupAddr);
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+
+    // Hết pbuf khi burst cả frame: chờ WiFi xả bớt rồi thử lại 1 lần
+    if (sendmsg(mcastFd, &msg, 0) >= 0) return true;
+    if (errno != ENOMEM) return false;
+    vTaskDelay(1);
+    return sendmsg(mcastFd, &msg, 0) >= 0;
+}
+
+static void sendFrame(const frame_slot_t* slot)
+{
+    uint16_t fragCount = (slot->len + MCAST_PAYLOAD_MAX - 1) / MCAST_PAYLOAD_MAX;
+
+    mcast_header_t header;
+    header.magic = htons(MCAST_MAGIC);
+    header.version = MCAST_VERSION;
+    header.frameSeq = htonl(slot->seq);
+    header.fragCount = htons(fragCount);
+    header.frameLen = htonl(slot->len);
+    uint64_t captureUs = (uint64_t)slot->captureUs;
+    header.captureUs = ((uint64_t)htonl((uint32_t)captureUs) << 32) | htonl((uint32_t)(captureUs >> 32));
+
+    for (uint16_t i = 0; i < fragCount; i++)
+    {
+        size_t offset = (size_t)i * MCAST_PAYLOAD_MAX;
+        size_t n = min((size_t)MCAST_PAYLOAD_MAX, slot->len - offset);
+
+        header.flags = (i == fragCount - 1) ? 0x01 : 0x00;
+        header.fragIndex = htons(i);
+        header.fragOffset = htonl(offset);
+
+        // Mất 1 datagram thì cả frame hỏng, bỏ phần còn lại cho đỡ airtime
+        if (!sendDatagram(&header, slot->data + offset, n))
+        {
+            mcastStats.sendErrors++;
+            return;
+        }
+        mcastStats.datagramsSent++;
+    }
+    mcastStats.framesSent++;
+}
+
+void mcastStreamTask(void* pvParameters)
+{
+    uint32_t lastSeq = 0;
+    const unsigned long frameInterval = 1000 / MCAST_MAX_FPS;
+
+    // Thoát giữa 2 frame: không bao giờ mang theo ref của slot khi task kết thúc
+    while (!stopRequested)
+    {
+        unsigned long start = millis();
+
+        if (leaseActive && (long)(start - leaseUntilMs) >= 0)
+        {
+            leaseActive = false;
+            Serial.println("[MCAST] Lease expired, multicast paused");
+        }
+        if (!leaseActive)
+        {
+            vTaskDelay(pdMS_TO_TICKS(200));
+            continue;
+        }
+
+        frame_slot_t* slot = frameRingAcquire(lastSeq);
+        if (slot && slot->len > 0)
+        {
+            if (lastSeq != 0 && slot->seq > lastSeq + 1) mcastStats.framesSkipped += slot->seq - lastSeq - 1;
+            lastSeq = slot->seq;
+            sendFrame(slot);
+        }
+        frameRingRelease(slot);
+
+        unsigned long elapsed = millis() - start;
+        vTaskDelay(pdMS_TO_TICKS(elapsed < frameInterval ? frameInterval - elapsed : 1));
+    }
+
+    mcastTaskHandle = NULL;
+    vTaskDelete(NULL);
+}
+
+bool startMcastStream()
+{
+    if (mcastTaskHandle != NULL) return true;
+
+    mcastFd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (mcastFd < 0)
+    {
+        Serial.println("[MCAST] ERROR: Failed to create socket");
+        return false;
+    }
+
+    uint8_t ttl = MCAST_TTL;
+    setsockopt(mcastFd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+
+    memset(&groupAddr, 0, sizeof(groupAddr));
+    groupAddr.sin_family = AF_INET;
+    groupAddr.sin_port = htons(MCAST_PORT);
+    groupAddr.sin_addr.s_addr = inet_addr(MCAST_GROUP);
+
+    stopRequested = false;
+    BaseType_t result = xTaskCreatePinnedToCore(
+        mcastStreamTask,
+        "McastStream",
+        3072,
+        NULL,
+        2,
+        &mcastTaskHandle,
+        APP_CPU
+    );
+
+    if (result != pdPASS)
+    {
+        Serial.println("[MCAST] ERROR: Failed to create task!");
+        mcastTaskHandle = NULL;
+        close(mcastFd);
+        mcastFd = -1;
+        return false;
+    }
+
+    Serial.printf("[MCAST] Ready for %s:%d (%u bytes/datagram), waiting for a lease\n", MCAST_GROUP, MCAST_PORT, (unsigned)MCAST_DATAGRAM_MAX);
+    return true;
+}
+
+void stopMcastStream()
+{
+    // Chờ task tự trả slot và thoát rồi mới đóng socket nó đang dùng
+    if (mcastTaskHandle != NULL)
+    {
+        stopRequested = true;
+        while (mcastTaskHandle != NULL) vTaskDelay(pdMS_TO_TICKS(1000 / MCAST_MAX_FPS));
+    }
+
+    if (mcastFd >= 0)
+    {
+        close(mcastFd);
+        mcastFd = -1;
+    }
+    leaseActive = false;
+}
+
+// Xin / gia hạn lease, 0 = huỷ lease. Trả về số giây thực sự được cấp.
+uint32_t mcastStreamLease(uint32_t seconds)
+{
+    if (seconds > MCAST_LEASE_MAX_S) seconds = MCAST_LEASE_MAX_S;
+    if (seconds == 0)
+    {
+        leaseActive = false;
+        return 0;
+    }
+
+    leaseUntilMs = millis() + seconds * 1000UL;
+    if (!leaseActive) Serial.printf("[MCAST] Lease granted for %lus, multicast running\n", (unsigned long)seconds);
+    leaseActive = true;
+    mcastStats.leases++;
+    return seconds;
+}
+
+uint32_t mcastStreamLeaseRemainingMs()
+{
+    if (!leaseActive) return 0;
+    long left = (long)(leaseUntilMs - millis());
+    return left > 0 ? (uint32_t)left : 0;
+}
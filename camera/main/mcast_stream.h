@@ -0,0 +1,53 @@
+#ifndef MCAST_STREAM_H
+#define MCAST_STREAM_H
+
+#include "config.h"
+
+// Gửi mỗi frame 1 lần tới nhóm multicast cho mọi consumer trong LAN (gateway, NVR, viewer).
+// Frame được chia thành datagram có header nhỏ để ghép lại và phát hiện mất gói.
+// Nhóm / cổng được quảng bá qua mDNS: _mjpeg-mcast._udp, TXT group, port, ver.
+// Chỉ gửi khi có consumer xin lease (GET /mcast?lease=giây) và gia hạn trước khi hết,
+// không ai xin thì không tốn airtime.
+
+#define MCAST_GROUP         "239.255.42.1"
+#define MCAST_PORT          5010
+#define MCAST_TTL           1
+#define MCAST_DATAGRAM_MAX  1400    // vừa 1 gói WiFi, không bị IP fragment
+#define MCAST_MAX_FPS       15      // AP phát lại multicast ở basic rate, giới hạn airtime
+#define MCAST_VERSION       1
+#define MCAST_MAGIC         0x4D4A  // "MJ"
+#define MCAST_LEASE_DEFAULT_S   30
+#define MCAST_LEASE_MAX_S       300
+
+// Header đầu mỗi datagram, big-endian
+typedef struct __attribute__((packed)) {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t flags;              // bit 0 = fragment cuối
+    uint32_t frameSeq;          // seq trong frame ring, tăng dần (có thể nhảy khi bỏ frame)
+    uint16_t fragIndex;
+    uint16_t fragCount;
+    uint32_t frameLen;
+    uint32_t fragOffset;
+    uint64_t captureUs;
+} mcast_header_t;
+
+#define MCAST_PAYLOAD_MAX   (MCAST_DATAGRAM_MAX - sizeof(mcast_header_t))
+
+typedef struct {
+    uint32_t framesSent;
+    uint32_t datagramsSent;
+    uint32_t framesSkipped;
+    uint32_t sendErrors;
+    uint32_t leases;            // số lần consumer xin / gia hạn lease
+} mcast_stats_t;
+
+extern mcast_stats_t mcastStats;
+
+bool startMcastStream();
+void stopMcastStream();
+uint32_t mcastStreamLease(uint32_t seconds);
+uint32_t mcastStreamLeaseRemainingMs();
+void mcastStreamTask(void* pvParameters);
+
+#endif
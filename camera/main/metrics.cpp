@@ -0,0 +1,191 @@
+#include "metrics.h"
+#include "camera_handler.h"
+#include "frame_ring.h"
+#include "stream_stats.h"
+#include "stream_mux.h"
+#include "security_system.h"
+#include "sim_at.h"
+#include "sms_outbox.h"
+#include "mqtt_task.h"
+
+runtime_metrics_t runtimeMetrics;
+
+// Task có stack cố định cần theo dõi (tên như lúc xTaskCreatePinnedToCore)
+static const char* const stackTasks[] = {
+    "loopTask", "StreamMux", "PreviewScaler", "RtspServer", "McastStream",
+    "MotionDetect", "EventBuffer", "AviRecorder", "SimAT", "MqttTask"
+};
+
+// Gọi đầu mỗi loop(): đo khoảng cách giữa 2 lần vào loop
+void metricsLoopTick()
+{
+    static uint32_t lastUs = 0;
+    uint32_t now = micros();
+
+    if (lastUs != 0)
+    {
+        uint32_t us = now - lastUs;
+        runtimeMetrics.loopLastUs = us;
+        runtimeMetrics.loopSumUs += us;
+        if (us > runtimeMetrics.loopMaxUs) runtimeMetrics.loopMaxUs = us;
+        runtimeMetrics.loopCount++;
+    }
+    lastUs = now;
+}
+
+// Không đủ chỗ thì đặt pos = size, metricsToText trả về 0 thay vì text bị cắt
+static void appendf(char* buf, size_t size, size_t* pos, const char* fmt, ...)
+{
+    if (*pos >= size) return;
+
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf + *pos, size - *pos, fmt, args);
+    va_end(args);
+
+    if (n < 0 || *pos + (size_t)n >= size) *pos = size;
+    else *pos += n;
+}
+
+static void appendMeta(char* buf, size_t size, size_t* pos, const char* name, const char* type, const char* help)
+{
+    appendf(buf, size, pos, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+static void appendHeap(char* buf, size_t size, size_t* pos, const char* region, uint32_t caps)
+{
+    appendf(buf, size, pos, "camera_heap_free_bytes{region=\"%s\"} %u\n", region, (unsigned)heap_caps_get_free_size(caps));
+    appendf(buf, size, pos, "camera_heap_min_free_bytes{region=\"%s\"} %u\n", region, (unsigned)heap_caps_get_minimum_free_size(caps));
+    appendf(buf, size, pos, "camera_heap_largest_free_block_bytes{region=\"%s\"} %u\n", region, (unsigned)heap_caps_get_largest_free_block(caps));
+}
+
+size_t metricsToText(char* buf, size_t size)
+{
+    size_t pos = 0;
+
+    appendMeta(buf, size, &pos, "camera_uptime_seconds", "gauge", "Thoi gian tu luc khoi dong");
+    appendf(buf, size, &pos, "camera_uptime_seconds %lu\n", (unsigned long)(millis() / 1000));
+
+    appendMeta(buf, size, &pos, "camera_frames_received_total", "counter", "Frame nhan tu camera UVC (frame_cnt_recv)");
+    appendf(buf, size, &pos, "camera_frames_received_total %lu\n", (unsigned long)frame_cnt_recv);
+    appendMeta(buf, size, &pos, "camera_frames_sent_total", "counter", "Frame gui xong toi client stream (frame_cnt_sent)");
+    appendf(buf, size, &pos, "camera_frames_sent_total %lu\n", (unsigned long)frame_cnt_sent);
+    appendMeta(buf, size, &pos, "camera_frames_dropped_total", "counter", "Frame bi bo vi frame ring day");
+    appendf(buf, size, &pos, "camera_frames_dropped_total %lu\n", (unsigned long)frameRingDropped);
+
+    appendMeta(buf, size, &pos, "camera_stream_clients", "gauge", "So client stream dang ket noi");
+    appendf(buf, size, &pos, "camera_stream_clients %u\n", streamMuxStats.clients);
+
+    appendMeta(buf, size, &pos, "camera_client_fps", "gauge", "FPS thuc te cua tung client");
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        const client_stats_t* st = &clientStats[i];
+        if (!st->active) continue;
+        appendf(buf, size, &pos, "camera_client_fps{slot=\"%d\",ip=\"%s\",proto=\"%s\"} %u\n",
+                i, IPAddress(st->ip).toString().c_str(), st->websocket ? "ws" : "mjpeg", st->fps);
+    }
+    appendMeta(buf, size, &pos, "camera_client_sent_bytes_total", "counter", "Byte da gui toi tung client");
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        const client_stats_t* st = &clientStats[i];
+        if (!st->active) continue;
+        appendf(buf, size, &pos, "camera_client_sent_bytes_total{slot=\"%d\",ip=\"%s\",proto=\"%s\"} %llu\n",
+                i, IPAddress(st->ip).toString().c_str(), st->websocket ? "ws" : "mjpeg", (unsigned long long)st->bytesSent);
+    }
+    appendMeta(buf, size, &pos, "camera_client_frames_skipped_total", "counter", "Frame bo qua vi client nhan cham");
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        const client_stats_t* st = &clientStats[i];
+        if (!st->active) continue;
+        appendf(buf, size, &pos, "camera_client_frames_skipped_total{slot=\"%d\",ip=\"%s\",proto=\"%s\"} %lu\n",
+                i, IPAddress(st->ip).toString().c_str(), st->websocket ? "ws" : "mjpeg", (unsigned long)st->framesSkipped);
+    }
+
+    appendMeta(buf, size, &pos, "camera_heap_free_bytes", "gauge", "Heap con trong");
+    appendMeta(buf, size, &pos, "camera_heap_min_free_bytes", "gauge", "Heap con trong thap nhat tu luc khoi dong");
+    appendMeta(buf, size, &pos, "camera_heap_largest_free_block_bytes", "gauge", "Khoi lien tuc lon nhat co the cap phat");
+    appendHeap(buf, size, &pos, "internal", MALLOC_CAP_INTERNAL);
+    appendHeap(buf, size, &pos, "psram", MALLOC_CAP_SPIRAM);
+
+    // ESP-IDF tính high-water mark theo byte
+    appendMeta(buf, size, &pos, "camera_task_stack_free_min_bytes", "gauge", "Stack con trong thap nhat cua task");
+    for (size_t i = 0; i < sizeof(stackTasks) / sizeof(stackTasks[0]); i++)
+    {
+        TaskHandle_t task = xTaskGetHandle(stackTasks[i]);
+        if (task == nullptr) continue;
+        appendf(buf, size, &pos, "camera_task_stack_free_min_bytes{task=\"%s\"} %lu\n", stackTasks[i], (unsigned long)uxTaskGetStackHighWaterMark(task));
+    }
+
+    appendMeta(buf, size, &pos, "camera_mqtt_connected", "gauge", "1 = dang ket noi MQTT broker");
+    appendf(buf, size, &pos, "camera_mqtt_connected %d\n", mqttConnected ? 1 : 0);
+    appendMeta(buf, size, &pos, "camera_mqtt_connects_total", "counter", "Lan ket noi MQTT thanh cong");
+    appendf(buf, size, &pos, "camera_mqtt_connects_total %lu\n", (unsigned long)runtimeMetrics.mqttConnects);
+    appendMeta(buf, size, &pos, "camera_mqtt_connect_failures_total", "counter", "Lan ket noi MQTT that bai");
+    appendf(buf, size, &pos, "camera_mqtt_connect_failures_total %lu\n", (unsigned long)runtimeMetrics.mqttConnectFailures);
+    appendMeta(buf, size, &pos, "camera_mqtt_disconnects_total", "counter", "Lan mat ket noi MQTT");
+    appendf(buf, size, &pos, "camera_mqtt_disconnects_total %lu\n", (unsigned long)runtimeMetrics.mqttDisconnects);
+    appendMeta(buf, size, &pos, "camera_mqtt_connect_max_ms", "gauge", "connect() MQTT lau nhat (DNS + TCP), chay trong MqttTask");
+    appendf(buf, size, &pos, "camera_mqtt_connect_max_ms %lu\n", (unsigned long)mqttTaskStats.connectMaxMs);
+    appendMeta(buf, size, &pos, "camera_mqtt_ring_messages_total", "counter", "Tin qua ring giua loop() va MqttTask");
+    appendf(buf, size, &pos, "camera_mqtt_ring_messages_total{dir=\"tx\",result=\"queued\"} %lu\n", (unsigned long)mqttTaskStats.txQueued);
+    appendf(buf, size, &pos, "camera_mqtt_ring_messages_total{dir=\"tx\",result=\"full\"} %lu\n", (unsigned long)mqttTaskStats.txFull);
+    appendf(buf, size, &pos, "camera_mqtt_ring_messages_total{dir=\"rx\",result=\"queued\"} %lu\n", (unsigned long)mqttTaskStats.rxQueued);
+    appendf(buf, size, &pos, "camera_mqtt_ring_messages_total{dir=\"rx\",result=\"full\"} %lu\n", (unsigned long)mqttTaskStats.rxFull);
+    appendf(buf, size, &pos, "camera_mqtt_ring_messages_total{dir=\"rx\",result=\"too_large\"} %lu\n", (unsigned long)mqttTaskStats.rxTooLarge);
+    appendMeta(buf, size, &pos, "camera_mqtt_outbox_depth", "gauge", "Su kien MQTT cho phat lai");
+    appendf(buf, size, &pos, "camera_mqtt_outbox_depth %u\n", (unsigned)mqttOutboxStats.depth);
+    appendMeta(buf, size, &pos, "camera_mqtt_outbox_max_depth", "gauge", "Do sau lon nhat tu luc khoi dong");
+    appendf(buf, size, &pos, "camera_mqtt_outbox_max_depth %u\n", (unsigned)mqttOutboxStats.maxDepth);
+    appendMeta(buf, size, &pos, "camera_mqtt_outbox_messages_total", "counter", "Su kien MQTT qua outbox");
+    appendf(buf, size, &pos, "camera_mqtt_outbox_messages_total{result=\"queued\"} %lu\n", (unsigned long)mqttOutboxStats.queued);
+    appendf(buf, size, &pos, "camera_mqtt_outbox_messages_total{result=\"replayed\"} %lu\n", (unsigned long)mqttOutboxStats.replayed);
+    appendf(buf, size, &pos, "camera_mqtt_outbox_messages_total{result=\"acked\"} %lu\n", (unsigned long)mqttOutboxStats.acked);
+    appendf(buf, size, &pos, "camera_mqtt_outbox_messages_total{result=\"resent\"} %lu\n", (unsigned long)mqttOutboxStats.resent);
+    appendf(buf, size, &pos, "camera_mqtt_outbox_messages_total{result=\"coalesced\"} %lu\n", (unsigned long)mqttOutboxStats.coalesced);
+    appendf(buf, size, &pos, "camera_mqtt_outbox_messages_total{result=\"dropped\"} %lu\n", (unsigned long)mqttOutboxStats.dropped);
+    appendMeta(buf, size, &pos, "camera_mqtt_outbox_replay_failures_total", "counter", "Lan publish loi khi phat lai");
+    appendf(buf, size, &pos, "camera_mqtt_outbox_replay_failures_total %lu\n", (unsigned long)mqttOutboxStats.replayFailures);
+    appendMeta(buf, size, &pos, "camera_mqtt_outbox_ack_timeouts_total", "counter", "Marker khong quay ve, ket noi lai de gui lai");
+    appendf(buf, size, &pos, "camera_mqtt_outbox_ack_timeouts_total %lu\n", (unsigned long)mqttOutboxStats.ackTimeouts);
+    appendMeta(buf, size, &pos, "camera_mqtt_outbox_max_age_ms", "gauge", "Su kien cho lau nhat truoc khi broker xac nhan");
+    appendf(buf, size, &pos, "camera_mqtt_outbox_max_age_ms %lu\n", (unsigned long)mqttOutboxStats.maxAgeMs);
+
+    appendMeta(buf, size, &pos, "camera_sim_at_commands_total", "counter", "Lenh AT da gui toi SIM800");
+    appendf(buf, size, &pos, "camera_sim_at_commands_total %lu\n", (unsigned long)simAtStats.commands);
+    appendMeta(buf, size, &pos, "camera_sim_at_failures_total", "counter", "Lenh AT loi hoac het thoi gian");
+    appendf(buf, size, &pos, "camera_sim_at_failures_total{reason=\"error\"} %lu\n", (unsigned long)simAtStats.errors);
+    appendf(buf, size, &pos, "camera_sim_at_failures_total{reason=\"timeout\"} %lu\n", (unsigned long)simAtStats.timeouts);
+    appendf(buf, size, &pos, "camera_sim_at_failures_total{reason=\"queue_full\"} %lu\n", (unsigned long)simAtStats.queueFull);
+    appendMeta(buf, size, &pos, "camera_sim_urcs_total", "counter", "URC nhan tu SIM800 (+CMTI, RING, +CMGS)");
+    appendf(buf, size, &pos, "camera_sim_urcs_total %lu\n", (unsigned long)simAtStats.urcs);
+
+    appendMeta(buf, size, &pos, "camera_sms_outbox_depth", "gauge", "SMS dang cho gui");
+    appendf(buf, size, &pos, "camera_sms_outbox_depth %u\n", (unsigned)smsOutboxStats.depth);
+    appendMeta(buf, size, &pos, "camera_sms_outbox_max_depth", "gauge", "Do sau lon nhat tu luc khoi dong");
+    appendf(buf, size, &pos, "camera_sms_outbox_max_depth %u\n", (unsigned)smsOutboxStats.maxDepth);
+    appendMeta(buf, size, &pos, "camera_sms_retries_total", "counter", "Lan gui lai SMS sau loi");
+    appendf(buf, size, &pos, "camera_sms_retries_total %lu\n", (unsigned long)smsOutboxStats.retries);
+    appendMeta(buf, size, &pos, "camera_sms_dropped_total", "counter", "SMS bi bo khoi hang doi");
+    appendf(buf, size, &pos, "camera_sms_dropped_total{reason=\"failed\"} %lu\n", (unsigned long)smsOutboxStats.failed);
+    appendf(buf, size, &pos, "camera_sms_dropped_total{reason=\"evicted\"} %lu\n", (unsigned long)smsOutboxStats.evicted);
+    appendf(buf, size, &pos, "camera_sms_dropped_total{reason=\"rejected\"} %lu\n", (unsigned long)smsOutboxStats.rejected);
+    appendMeta(buf, size, &pos, "camera_sms_delivery_ms", "summary", "Tu luc xep hang toi khi modem nhan SMS");
+    appendf(buf, size, &pos, "camera_sms_delivery_ms_sum %llu\n", (unsigned long long)smsOutboxStats.totalLatencyMs);
+    appendf(buf, size, &pos, "camera_sms_delivery_ms_count %lu\n", (unsigned long)smsOutboxStats.sent);
+    appendMeta(buf, size, &pos, "camera_sms_delivery_max_ms", "gauge", "SMS cho lau nhat tu luc khoi dong");
+    appendf(buf, size, &pos, "camera_sms_delivery_max_ms %lu\n", (unsigned long)smsOutboxStats.maxLatencyMs);
+
+    // Scrape chạy trong loop() (server.handleClient), cùng task ghi nên reset max không bị race
+    appendMeta(buf, size, &pos, "camera_loop_iteration_us", "summary", "Thoi gian 1 vong loop()");
+    appendf(buf, size, &pos, "camera_loop_iteration_us_sum %llu\n", (unsigned long long)runtimeMetrics.loopSumUs);
+    appendf(buf, size, &pos, "camera_loop_iteration_us_count %lu\n", (unsigned long)runtimeMetrics.loopCount);
+    appendMeta(buf, size, &pos, "camera_loop_iteration_max_us", "gauge", "Vong loop() lau nhat tu lan scrape truoc");
+    appendf(buf, size, &pos, "camera_loop_iteration_max_us %lu\n", (unsigned long)runtimeMetrics.loopMaxUs);
+    appendMeta(buf, size, &pos, "camera_loop_iteration_last_us", "gauge", "Vong loop() gan nhat");
+    appendf(buf, size, &pos, "camera_loop_iteration_last_us %lu\n", (unsigned long)runtimeMetrics.loopLastUs);
+    runtimeMetrics.loopMaxUs = 0;
+
+    if (pos < size) return pos;
+    if (size > 0) buf[0] = '\0';
+    return 0;
+}
@@ -0,0 +1,28 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "config.h"
+
+// /metrics dạng text Prometheus. Bộ đếm ở đây chỉ có 1 task ghi (loop hoặc task riêng),
+// đọc khi scrape không cần khóa: uint32_t căn lề đọc/ghi nguyên tử trên Xtensa.
+
+#define METRICS_BASE_MAX    8192    // mọi metric trừ theo client, tệ nhất ~7.2 KB
+#define METRICS_CLIENT_MAX  320     // 3 dòng / client, tệ nhất ~300 byte
+#define METRICS_BUF_SIZE (METRICS_BASE_MAX + MAX_CLIENTS * METRICS_CLIENT_MAX)
+
+typedef struct {
+    uint32_t loopCount;
+    uint32_t loopLastUs;        // thời gian 1 vòng loop() gần nhất
+    uint32_t loopMaxUs;         // lớn nhất kể từ lần scrape trước
+    uint64_t loopSumUs;
+    uint32_t mqttConnects;
+    uint32_t mqttConnectFailures;
+    uint32_t mqttDisconnects;
+} runtime_metrics_t;
+
+extern runtime_metrics_t runtimeMetrics;
+
+void metricsLoopTick();
+size_t metricsToText(char* buf, size_t size);     // 0 = không đủ chỗ, không trả text bị cắt
+
+#endif
@@ -0,0 +1,260 @@
+#include "motion_detector.h"
+#include "frame_ring.h"
+#include "jpeg_decoder.h"
+
+#define MOTION_CELL_THRESHOLD_PCT 10   // ô được đánh dấu khi >= 10% block thay đổi
+
+typedef struct {
+    jpeg_decoder_t dec;
+    uint8_t cur[MOTION_MAX_BLOCKS_H][MOTION_MAX_BLOCKS_W];       // độ sáng trung bình block
+    uint16_t bg[MOTION_MAX_BLOCKS_H][MOTION_MAX_BLOCKS_W];       // nền, fixed-point x16
+} motion_work_t;
+
+motion_stats_t motionStats;
+
+static motion_work_t* work = nullptr;
+static TaskHandle_t motionTaskHandle = NULL;
+static uint8_t consecutiveFrames = 0;
+static bool relearnBackground = true;
+
+// Đọc DC của mọi block luma vào work->cur, trả về false nếu frame không giải mã được
+static bool extractBlockLuma(const uint8_t* data, size_t len, int* validW, int* validH)
+{
+    jpeg_decoder_t* dec = &work->dec;
+    if (!jpegDecoderBegin(dec, data, len)) return false;
+
+    const jpeg_component_t* luma = &dec->comps[0];
+    if (luma->blocksW > MOTION_MAX_BLOCKS_W || luma->blocksH > MOTION_MAX_BLOCKS_H) return false;
+
+    // DC = 8 x độ sáng trung bình (đã trừ 128)
+    int q0 = dec->qt[luma->tq][0];
+    int16_t coef[64];
+
+    for (int my = 0; my < dec->mcusY; my++)
+    {
+        for (int mx = 0; mx < dec->mcusX; mx++)
+        {
+            if (!jpegDecoderStartMcu(dec)) return false;
+
+            for (int c = 0; c < dec->numComps; c++)
+            {
+                const jpeg_component_t* comp = &dec->comps[c];
+                for (int by = 0; by < comp->v; by++)
+                {
+                    for (int bx = 0; bx < comp->h; bx++)
+                    {
+                        if (!jpegDecodeBlock(dec, c, coef, true)) return false;
+                        if (c != 0) continue;
+
+                        int v = 128 + (coef[0] * q0) / 8;
+                        work->cur[my * comp->v + by][mx * comp->h + bx] = (uint8_t)constrain(v, 0, 255);
+                    }
+                }
+            }
+        }
+    }
+
+    *validW = (dec->width + 7) / 8;
+    *validH = (dec->height + 7) / 8;
+    return true;
+}
+
+static void scoreFrame(int w, int h)
+{
+    int n = w * h;
+
+    if (relearnBackground)
+    {
+        for (int y = 0; y < h; y++)
+            for (int x = 0; x < w; x++) work->bg[y][x] = work->cur[y][x] << 4;
+        relearnBackground = false;
+        consecutiveFrames = 0;
+        return;
+    }
+
+    // Bù thay đổi độ sáng toàn cảnh (đèn flash/IR bật tắt) trước khi so từng block
+    int32_t sumDiff = 0;
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++) sumDiff += (work->cur[y][x] << 4) - work->bg[y][x];
+    int offset = sumDiff / n;
+
+    uint16_t cellChanged[MOTION_GRID_H][MOTION_GRID_W] = {};
+    uint16_t cellTotal[MOTION_GRID_H][MOTION_GRID_W] = {};
+    int changed = 0;
+
+    for (int y = 0; y < h; y++)
+    {
+        int gy = y * MOTION_GRID_H / h;
+        for (int x = 0; x < w; x++)
+        {
+            int gx = x * MOTION_GRID_W / w;
+            int cur = work->cur[y][x] << 4;
+            int d = abs(cur - work->bg[y][x] - offset) >> 4;
+
+            cellTotal[gy][gx]++;
+            if (d > MOTION_BLOCK_THRESHOLD)
+            {
+                cellChanged[gy][gx]++;
+                changed++;
+            }
+            work->bg[y][x] += (cur - work->bg[y][x]) >> MOTION_BG_SHIFT;
+        }
+    }
+
+    uint16_t score = changed * 1000 / n;
+    if (score >= MOTION_SCENE_CHANGE_SCORE)
+    {
+        Serial.printf("[MOTION] Scene change (score=%u), relearning background\n", score);
+        relearnBackground = true;
+        consecutiveFrames = 0;
+        return;
+    }
+
+    uint64_t mask = 0;
+    for (int gy = 0; gy < MOTION_GRID_H; gy++)
+    {
+        for (int gx = 0; gx < MOTION_GRID_W; gx++)
+        {
+            uint8_t pct = cellTotal[gy][gx] ? cellChanged[gy][gx] * 100 / cellTotal[gy][gx] : 0;
+            motionStats.grid[gy][gx] = pct;
+            if (pct >= MOTION_CELL_THRESHOLD_PCT) mask |= 1ULL << (gy * MOTION_GRID_W + gx);
+        }
+    }
+    motionStats.gridMask = mask;
+    motionStats.score = score;
+
+    unsigned long now = millis();
+    if (score >= MOTION_SCORE_THRESHOLD)
+    {
+        if (consecutiveFrames < 255) consecutiveFrames++;
+    }
+    else
+    {
+        consecutiveFrames = 0;
+    }
+
+    if (consecutiveFrames >= MOTION_CONFIRM_FRAMES)
+    {
+        motionStats.lastMotionMs = now;
+        if (motionStats.motionSinceMs == 0)
+        {
+            motionStats.motionSinceMs = now;
+            Serial.printf("[MOTION] Video motion (score=%u, grid=0x%012llx)\n", score, (unsigned long long)mask);
+        }
+    }
+    else if (motionStats.motionSinceMs != 0 && now - motionStats.lastMotionMs > MOTION_VIDEO_HOLD_MS)
+    {
+        motionStats.motionSinceMs = 0;
+        Serial.println("[MOTION] Video motion ended");
+    }
+}
+
+void motionDetectorTask(void* pvParameters)
+{
+    uint32_t lastSeq = 0;
+
+    while (true)
+    {
+        unsigned long start = millis();
+
+        // reader riêng của ring, cùng cơ chế với các stream client
+        frame_slot_t* slot = frameRingAcquire(lastSeq);
+        if (slot && slot->len > 0)
+        {
+            lastSeq = slot->seq;
+
+            int64_t t0 = esp_timer_get_time();
+            int w = 0, h = 0;
+            bool ok = extractBlockLuma(slot->data, slot->len, &w, &h);
+            frameRingRelease(slot);
+            slot = nullptr;
+
+            if (ok)
+            {
+                scoreFrame(w, h);
+                motionStats.framesAnalyzed++;
+                motionStats.lastAnalyzeMs = millis();
+            }
+            else
+            {
+                motionStats.decodeErrors++;
+            }
+
+            uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+            motionStats.lastAnalyzeUs = us;
+            if (us > motionStats.maxAnalyzeUs) motionStats.maxAnalyzeUs = us;
+            if (us > MOTION_ANALYZE_INTERVAL_MS * 1000UL) motionStats.budgetOverruns++;
+        }
+        frameRingRelease(slot);
+
+        unsigned long elapsed = millis() - start;
+        vTaskDelay(pdMS_TO_TICKS(elapsed < MOTION_ANALYZE_INTERVAL_MS ? MOTION_ANALYZE_INTERVAL_MS - elapsed : 1));
+    }
+}
+
+bool startMotionDetector()
+{
+    if (motionTaskHandle != NULL) return true;
+
+    if (work == nullptr)
+    {
+        work = (motion_work_t*)heap_caps_malloc(sizeof(motion_work_t), MALLOC_CAP_SPIRAM);
+        if (work == nullptr)
+        {
+            Serial.println("[MOTION] ERROR: Failed to allocate work buffer");
+            return false;
+        }
+    }
+
+    memset(&motionStats, 0, sizeof(motionStats));
+    consecutiveFrames = 0;
+    relearnBackground = true;
+
+    BaseType_t result = xTaskCreatePinnedToCore(
+        motionDetectorTask,
+        "MotionDetect",
+        4096,
+        NULL,
+        2,
+        &motionTaskHandle,
+        APP_CPU
+    );
+
+    if (result != pdPASS)
+    {
+        Serial.println("[MOTION] ERROR: Failed to create task!");
+        motionTaskHandle = NULL;
+        return false;
+    }
+
+    Serial.println("[MOTION] Video motion detector started");
+    return true;
+}
+
+void stopMotionDetector()
+{
+    if (motionTaskHandle != NULL)
+    {
+        vTaskDelete(motionTaskHandle);
+        motionTaskHandle = NULL;
+    }
+    motionStats.motionSinceMs = 0;
+}
+
+// Có frame được phân tích gần đây và đã qua giai đoạn học nền
+bool motionVideoHealthy()
+{
+    return motionStats.lastAnalyzeMs != 0 &&
+           millis() - motionStats.lastAnalyzeMs < 1000 &&
+           motionStats.framesAnalyzed >= MOTION_WARMUP_FRAMES;
+}
+
+bool motionVideoActive()
+{
+    return motionVideoHealthy() && motionStats.motionSinceMs != 0;
+}
+
+bool motionVideoSustained()
+{
+    return motionVideoActive() && millis() - motionStats.motionSinceMs >= MOTION_VIDEO_ONLY_MS;
+}
@@ -0,0 +1,50 @@
+#ifndef MOTION_DETECTOR_H
+#define MOTION_DETECTOR_H
+
+#include "config.h"
+
+// Phát hiện chuyển động từ hệ số DC (độ sáng trung bình mỗi block 8x8) của frame MJPEG.
+// Chỉ giải mã entropy, không IDCT, chạy trên APP core với tốc độ thấp hơn camera.
+
+#define MOTION_ANALYZE_INTERVAL_MS  100     // ~10 frame/s được phân tích
+#define MOTION_BG_SHIFT             4       // nền EMA, alpha = 1/16
+#define MOTION_BLOCK_THRESHOLD      12      // chênh lệch độ sáng để coi block là thay đổi
+#define MOTION_SCORE_THRESHOLD      15      // ‰ số block thay đổi để coi frame có chuyển động
+#define MOTION_SCENE_CHANGE_SCORE   600     // ‰, đổi cảnh (bật đèn/IR) -> học lại nền
+#define MOTION_CONFIRM_FRAMES       3       // số frame liên tiếp trước khi xác nhận
+#define MOTION_WARMUP_FRAMES        20
+#define MOTION_VIDEO_HOLD_MS        1500    // giữ trạng thái video motion sau frame cuối
+#define MOTION_VIDEO_ONLY_MS        2000    // video motion liên tục đủ lâu thì tự kích hoạt (PIR bỏ sót)
+
+#define MOTION_GRID_W 8
+#define MOTION_GRID_H 6
+
+// Kích thước tối đa theo block luma (làm tròn theo MCU 16x16)
+#define MOTION_MAX_BLOCKS_W (((FRAME_WIDTH) + 15) / 16 * 2)
+#define MOTION_MAX_BLOCKS_H (((FRAME_HEIGHT) + 15) / 16 * 2)
+
+typedef struct {
+    uint32_t framesAnalyzed;
+    uint32_t decodeErrors;
+    uint32_t budgetOverruns;        // phân tích lâu hơn MOTION_ANALYZE_INTERVAL_MS
+    uint32_t lastAnalyzeUs;
+    uint32_t maxAnalyzeUs;
+    uint16_t score;                 // ‰ block thay đổi của frame gần nhất
+    uint64_t gridMask;              // bit (y * MOTION_GRID_W + x) = ô có chuyển động
+    uint8_t grid[MOTION_GRID_H][MOTION_GRID_W];  // % block thay đổi trong từng ô
+    unsigned long lastAnalyzeMs;
+    unsigned long lastMotionMs;     // frame cuối có chuyển động đã xác nhận
+    unsigned long motionSinceMs;    // 0 = hiện không có chuyển động
+} motion_stats_t;
+
+extern motion_stats_t motionStats;
+
+bool startMotionDetector();
+void stopMotionDetector();
+void motionDetectorTask(void* pvParameters);
+
+bool motionVideoHealthy();
+bool motionVideoActive();
+bool motionVideoSustained();
+
+#endif
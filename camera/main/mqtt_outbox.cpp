@@ -0,0 +1,201 @@
+#include "mqtt_outbox.h"
+#include "mqtt_task.h"
+#include "security_system.h"
+
+mqtt_outbox_stats_t mqttOutboxStats;
+
+// Ring FIFO, chỉ MqttTask đọc/ghi (ghi khi mất kết nối, phát lại sau khi kết nối lại)
+static mqtt_outbox_entry_t* ring = nullptr;
+static uint16_t head = 0;
+static uint16_t count = 0;
+static uint32_t nextSeq = 1;
+
+// Trạng thái của kết nối hiện tại, đặt lại khi kết nối lại
+static uint32_t sentSeq = 0;        // seq lớn nhất đã publish
+static uint32_t markerSeq = 0;      // seq trong marker gần nhất đã publish
+static bool awaitingAck = false;
+static uint32_t ackWaitSinceMs = 0;
+
+static mqtt_outbox_entry_t* entryAt(uint16_t i)
+{
+    return &ring[(head + i) % MQTT_OUTBOX_MAX];
+}
+
+// Bỏ các entry đã bị gộp ở đầu ring để head luôn trỏ tới tin còn hiệu lực
+static void trimHead()
+{
+    while (count > 0 && ring[head].seq == 0)
+    {
+        head = (head + 1) % MQTT_OUTBOX_MAX;
+        count--;
+    }
+}
+
+static void popHead()
+{
+    ring[head].seq = 0;
+    mqttOutboxStats.depth--;
+    trimHead();
+}
+
+bool startMqttOutbox()
+{
+    if (ring != nullptr) return true;
+
+    ring = (mqtt_outbox_entry_t*)heap_caps_malloc(MQTT_OUTBOX_MAX * sizeof(mqtt_outbox_entry_t), MALLOC_CAP_SPIRAM);
+    if (ring == nullptr)
+    {
+        Serial.println("[MQTT] ERROR: Failed to allocate outbox");
+        return false;
+    }
+
+    memset(ring, 0, MQTT_OUTBOX_MAX * sizeof(mqtt_outbox_entry_t));
+    memset(&mqttOutboxStats, 0, sizeof(mqttOutboxStats));
+    head = 0;
+    count = 0;
+    return true;
+}
+
+bool mqttOutboxEmpty()
+{
+    return mqttOutboxStats.depth == 0;
+}
+
+bool mqttOutboxPush(const char* topic, const char* payload, bool retained, bool coalesce)
+{
+    if (ring == nullptr) return false;
+
+    if (strlen(topic) >= MQTT_OUTBOX_TOPIC_MAX || strlen(payload) >= MQTT_OUTBOX_PAYLOAD_MAX)
+    {
+        Serial.printf("[MQTT] Outbox: message too large for %s\n", topic);
+        mqttOutboxStats.dropped++;
+        return false;
+    }
+
+    // Lệnh điều khiển: trạng thái cũ vô nghĩa, xoá để tin mới xếp cuối hàng (giữ thứ tự so với tin khác)
+    if (coalesce)
+    {
+        for (uint16_t i = 0; i < count; i++)
+        {
+            mqtt_outbox_entry_t* e = entryAt(i);
+            if (e->seq != 0 && strcmp(e->topic, topic) == 0)
+            {
+                e->seq = 0;
+                mqttOutboxStats.depth--;
+                mqttOutboxStats.coalesced++;
+            }
+        }
+        trimHead();
+    }
+
+    // Đầy (kể cả slot đã gộp nằm giữa ring): bỏ tin cũ nhất
+    if (count == MQTT_OUTBOX_MAX)
+    {
+        Serial.printf("[MQTT] Outbox full, dropped %s\n", ring[head].topic);
+        mqttOutboxStats.dropped++;
+        popHead();
+    }
+
+    mqtt_outbox_entry_t* e = entryAt(count);
+    e->seq = nextSeq++;
+    e->queuedMs = millis();
+    e->retained = retained;
+    strlcpy(e->topic, topic, sizeof(e->topic));
+    strlcpy(e->payload, payload, sizeof(e->payload));
+    count++;
+
+    mqttOutboxStats.queued++;
+    mqttOutboxStats.depth++;
+    if (mqttOutboxStats.depth > mqttOutboxStats.maxDepth) mqttOutboxStats.maxDepth = mqttOutboxStats.depth;
+    return true;
+}
+
+static bool sendMarker()
+{
+    char payload[12];
+    snprintf(payload, sizeof(payload), "%lu", (unsigned long)sentSeq);
+    if (!mqttClient.publish(MQTT_TOPIC_OUTBOX_ACK, payload)) return false;
+
+    if (!awaitingAck) ackWaitSinceMs = millis();
+    awaitingAck = true;
+    markerSeq = sentSeq;
+    return true;
+}
+
+// Gửi theo thứ tự các entry chưa gửi trên kết nối này, rồi gửi marker; trả về true khi không còn gì chờ gửi.
+// Entry vẫn nằm trong outbox đến khi mqttOutboxAck() xác nhận.
+bool mqttOutboxReplay()
+{
+    if (ring == nullptr) return true;
+    if (!mqttConnected) return false;
+
+    int n = 0;
+    for (uint16_t i = 0; i < count && n < MQTT_OUTBOX_REPLAY_BURST; i++)
+    {
+        mqtt_outbox_entry_t* e = entryAt(i);
+        if (e->seq == 0 || e->seq <= sentSeq) continue;
+
+        if (!mqttClient.publish(e->topic, e->payload, e->retained))
+        {
+            mqttOutboxStats.replayFailures++;
+            return false;
+        }
+
+        sentSeq = e->seq;
+        mqttOutboxStats.replayed++;
+        n++;
+    }
+
+    if (sentSeq > markerSeq && !sendMarker())
+    {
+        mqttOutboxStats.replayFailures++;
+        return false;
+    }
+
+    for (uint16_t i = 0; i < count; i++)
+    {
+        if (entryAt(i)->seq > sentSeq) return false;
+    }
+    return true;
+}
+
+// Gọi sau mỗi lần kết nối lại: mọi entry chưa được xác nhận sẽ được gửi lại từ đầu
+void mqttOutboxRewind()
+{
+    for (uint16_t i = 0; i < count; i++)
+    {
+        uint32_t seq = entryAt(i)->seq;
+        if (seq != 0 && seq <= sentSeq) mqttOutboxStats.resent++;
+    }
+
+    sentSeq = 0;
+    markerSeq = 0;
+    awaitingAck = false;
+}
+
+// Marker seq quay về từ broker: mọi entry tới seq đã tới broker
+void mqttOutboxAck(uint32_t seq)
+{
+    if (ring == nullptr || seq == 0 || seq > sentSeq) return;   // marker của kết nối trước
+
+    uint32_t now = millis();
+    while (count > 0 && ring[head].seq <= seq)
+    {
+        uint32_t age = now - ring[head].queuedMs;
+        if (age > mqttOutboxStats.maxAgeMs) mqttOutboxStats.maxAgeMs = age;
+        mqttOutboxStats.acked++;
+        popHead();
+    }
+
+    if (seq >= markerSeq) awaitingAck = false;
+    else ackWaitSinceMs = now;  // có tiến triển, chờ marker tiếp theo
+}
+
+bool mqttOutboxAckOverdue()
+{
+    if (!awaitingAck || millis() - ackWaitSinceMs < MQTT_OUTBOX_ACK_TIMEOUT_MS) return false;
+
+    mqttOutboxStats.ackTimeouts++;
+    awaitingAck = false;
+    return true;
+}
@@ -0,0 +1,53 @@
+#ifndef MQTT_OUTBOX_H
+#define MQTT_OUTBOX_H
+
+#include "config.h"
+
+// Nhật ký sự kiện MQTT (PSRAM), mọi sự kiện đều đi qua đây và được gửi đúng thứ tự.
+// PubSubClient chỉ có QoS0: publish() trả true khi mới chép vào TCP send buffer, mất kết nối kiểu
+// half-open (trước khi keepalive phát hiện) thì tin mất hẳn. Vì vậy entry chỉ bị xoá khi có round-trip:
+// sau mỗi lượt gửi, thiết bị publish seq cuối lên MQTT_TOPIC_OUTBOX_ACK mà chính nó subscribe.
+// Broker xử lý tin trên 1 kết nối theo thứ tự, nhận lại marker nghĩa là broker đã nhận mọi tin trước đó.
+// Quá MQTT_OUTBOX_ACK_TIMEOUT_MS không có marker thì ngắt, kết nối lại và gửi lại mọi entry chưa xác nhận
+// (at-least-once, bên nhận có thể thấy tin trùng).
+// Lệnh điều khiển (lock/buzzer) được gộp theo topic: chỉ giữ trạng thái mới nhất.
+
+#define MQTT_OUTBOX_MAX             64
+#define MQTT_OUTBOX_TOPIC_MAX       48
+#define MQTT_OUTBOX_PAYLOAD_MAX     384
+#define MQTT_OUTBOX_REPLAY_BURST    8       // tin mỗi vòng loop(), tránh chặn loop lâu khi xả
+#define MQTT_OUTBOX_ACK_TIMEOUT_MS  5000    // chờ marker quay về, quá thì coi kết nối đã chết
+
+typedef struct {
+    uint32_t seq;               // 0 = đã bị gộp, bỏ qua khi phát lại
+    uint32_t queuedMs;
+    bool retained;
+    char topic[MQTT_OUTBOX_TOPIC_MAX];
+    char payload[MQTT_OUTBOX_PAYLOAD_MAX];
+} mqtt_outbox_entry_t;
+
+typedef struct {
+    uint16_t depth;
+    uint16_t maxDepth;
+    uint32_t queued;
+    uint32_t replayed;          // publish() từ outbox, kể cả gửi lại
+    uint32_t acked;             // được xác nhận qua marker, đã xoá khỏi outbox
+    uint32_t resent;            // gửi lại sau khi kết nối lại mà chưa được xác nhận
+    uint32_t ackTimeouts;
+    uint32_t coalesced;         // lệnh cũ bị thay bằng lệnh mới cùng topic
+    uint32_t dropped;           // đầy, bỏ entry cũ nhất
+    uint32_t replayFailures;
+    uint32_t maxAgeMs;          // entry chờ lâu nhất từ lúc xếp hàng tới khi được xác nhận
+} mqtt_outbox_stats_t;
+
+extern mqtt_outbox_stats_t mqttOutboxStats;
+
+bool startMqttOutbox();
+bool mqttOutboxPush(const char* topic, const char* payload, bool retained, bool coalesce);
+bool mqttOutboxEmpty();
+bool mqttOutboxReplay();
+void mqttOutboxRewind();
+void mqttOutboxAck(uint32_t seq);
+bool mqttOutboxAckOverdue();
+
+#endif
@@ -0,0 +1,289 @@
+#include "mqtt_task.h"
+#include "security_system.h"
+#include "wifi_manager.h"
+#include "stream_stats.h"
+#include "metrics.h"
+#include "trace.h"
+
+typedef struct {
+    bool retained;
+    bool coalesce;
+    char topic[MQTT_OUTBOX_TOPIC_MAX];
+    char payload[MQTT_OUTBOX_PAYLOAD_MAX];
+} mqtt_tx_msg_t;
+
+typedef struct {
+    char topic[MQTT_OUTBOX_TOPIC_MAX];
+    char payload[MQTT_RX_PAYLOAD_MAX];
+} mqtt_rx_msg_t;
+
+volatile bool mqttConnected = false;
+mqtt_task_stats_t mqttTaskStats;
+
+static WiFiClient espClient;
+PubSubClient mqttClient(espClient);
+
+static TaskHandle_t mqttTaskHandle = NULL;
+static mqtt_message_fn messageHandler = nullptr;
+
+// Dữ liệu ring ở PSRAM, chỉ số ở RAM trong (atomic); head do producer ghi, tail do consumer ghi
+// tx: loopTask -> MqttTask, rx: MqttTask -> loopTask
+static mqtt_tx_msg_t* txRing = nullptr;
+static uint32_t txHead = 0;
+static uint32_t txTail = 0;
+static mqtt_rx_msg_t* rxRing = nullptr;
+static uint32_t rxHead = 0;
+static uint32_t rxTail = 0;
+
+// Chỉ loopTask gọi (publishMQTTStatus, sendNodeCommand, cảnh báo motion)
+bool mqttPublishAsync(const char* topic, const char* payload, bool retained, bool coalesce)
+{
+    if (txRing == nullptr) return false;
+
+    if (strlen(topic) >= MQTT_OUTBOX_TOPIC_MAX || strlen(payload) >= MQTT_OUTBOX_PAYLOAD_MAX)
+    {
+        Serial.printf("[MQTT] Message too large for %s\n", topic);
+        return false;
+    }
+
+    uint32_t head = txHead;
+    if (head - __atomic_load_n(&txTail, __ATOMIC_ACQUIRE) >= MQTT_TX_SLOTS)
+    {
+        mqttTaskStats.txFull++;
+        return false;
+    }
+
+    mqtt_tx_msg_t* msg = &txRing[head & (MQTT_TX_SLOTS - 1)];
+    msg->retained = retained;
+    msg->coalesce = coalesce;
+    strlcpy(msg->topic, topic, sizeof(msg->topic));
+    strlcpy(msg->payload, payload, sizeof(msg->payload));
+    __atomic_store_n(&txHead, head + 1, __ATOMIC_RELEASE);
+
+    mqttTaskStats.txQueued++;
+    if (mqttTaskHandle) xTaskNotifyGive(mqttTaskHandle);
+    return true;
+}
+
+// Chạy trong MqttTask (bên trong mqttClient.loop()): chỉ chép sang ring, xử lý ở loop()
+static void onMqttMessage(char* topic, byte* payload, unsigned int length)
+{
+    if (length == 0) return;
+
+    // Marker của outbox quay về: xử lý ngay trong MqttTask, không đưa sang loopTask
+    if (strcmp(topic, MQTT_TOPIC_OUTBOX_ACK) == 0)
+    {
+        char seq[12];
+        size_t n = min((size_t)length, sizeof(seq) - 1);
+        memcpy(seq, payload, n);
+        seq[n] = '\0';
+        mqttOutboxAck(strtoul(seq, nullptr, 10));
+        return;
+    }
+
+    if (strlen(topic) >= MQTT_OUTBOX_TOPIC_MAX || length >= MQTT_RX_PAYLOAD_MAX)
+    {
+        mqttTaskStats.rxTooLarge++;
+        return;
+    }
+
+    uint32_t head = rxHead;
+    if (head - __atomic_load_n(&rxTail, __ATOMIC_ACQUIRE) >= MQTT_RX_SLOTS)
+    {
+        mqttTaskStats.rxFull++;
+        return;
+    }
+
+    mqtt_rx_msg_t* msg = &rxRing[head & (MQTT_RX_SLOTS - 1)];
+    strlcpy(msg->topic, topic, sizeof(msg->topic));
+    memcpy(msg->payload, payload, length);
+    msg->payload[length] = '\0';
+    __atomic_store_n(&rxHead, head + 1, __ATOMIC_RELEASE);
+    mqttTaskStats.rxQueued++;
+}
+
+// Gọi từ loop(): xử lý tin nhận về trong ngữ cảnh loopTask như trước
+void mqttPollInbound()
+{
+    if (rxRing == nullptr) return;
+
+    uint32_t tail = rxTail;
+    while (tail != __atomic_load_n(&rxHead, __ATOMIC_ACQUIRE))
+    {
+        mqtt_rx_msg_t* msg = &rxRing[tail & (MQTT_RX_SLOTS - 1)];
+        if (messageHandler) messageHandler(msg->topic, msg->payload);
+        tail++;
+        __atomic_store_n(&rxTail, tail, __ATOMIC_RELEASE);
+    }
+}
+
+static void connectBroker()
+{
+    Serial.println("[MQTT] Connecting...");
+
+    uint32_t start = millis();
+    bool ok = mqttClient.connect(MQTT_CLIENT_ID, MQTT_USER, MQTT_PASSWORD);
+    uint32_t elapsed = millis() - start;
+    if (elapsed > mqttTaskStats.connectMaxMs) mqttTaskStats.connectMaxMs = elapsed;
+
+    if (!ok)
+    {
+        runtimeMetrics.mqttConnectFailures++;
+        Serial.printf("[MQTT] FAIL RC=%d (%lu ms)\n", mqttClient.state(), (unsigned long)elapsed);
+        return;
+    }
+
+    mqttClient.subscribe(MQTT_TOPIC_COMMAND);
+    mqttClient.subscribe(MQTT_TOPIC_FAMILY_DETECT);
+    mqttClient.subscribe(MQTT_TOPIC_OUTBOX_ACK);
+
+    mqttConnected = true;
+    runtimeMetrics.mqttConnects++;
+    Serial.printf("[MQTT] OK (%lu ms)\n", (unsigned long)elapsed);
+
+    // Gửi lại mọi sự kiện chưa được xác nhận (kể cả đã gửi trên kết nối cũ), tin mới trong ring xếp sau
+    mqttOutboxRewind();
+    mqttOutboxReplay();
+}
+
+// Mọi sự kiện vào outbox để được giữ tới khi có xác nhận; mqttOutboxReplay() gửi ngay trong cùng vòng
+static void drainOutbound()
+{
+    uint32_t tail = txTail;
+    while (tail != __atomic_load_n(&txHead, __ATOMIC_ACQUIRE))
+    {
+        mqtt_tx_msg_t* msg = &txRing[tail & (MQTT_TX_SLOTS - 1)];
+        mqttOutboxPush(msg->topic, msg->payload, msg->retained, msg->coalesce);
+
+        tail++;
+        __atomic_store_n(&txTail, tail, __ATOMIC_RELEASE);
+    }
+}
+
+// Tổng hợp 1 message, mỗi client 1 message riêng để kích thước không phụ thuộc MAX_CLIENTS
+static void publishStreamStats()
+{
+    static_assert(STREAM_STATS_SUMMARY_JSON_MAX <= MQTT_BUFFER_SIZE - 64, "stats JSON does not fit the MQTT buffer");
+    static char json[STREAM_STATS_SUMMARY_JSON_MAX];
+
+    if (streamStatsSummaryToJson(json, sizeof(json)) == 0)
+    {
+        Serial.println("[MQTT] Stats JSON too large, not published");
+        return;
+    }
+    mqttClient.publish(MQTT_TOPIC_STATS, json);
+
+    char topic[48];
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        if (streamStatsClientToJson(i, json, sizeof(json)) == 0) continue;
+        snprintf(topic, sizeof(topic), MQTT_TOPIC_STATS "/client/%d", i);
+        mqttClient.publish(topic, json);
+    }
+}
+
+void mqttTask(void* pvParameters)
+{
+    uint32_t lastAttempt = millis() - MQTT_RECONNECT_INTERVAL;
+    uint32_t lastStatsPublish = millis();
+
+    while (true)
+    {
+        {
+            TRACE_SCOPE("mqtt_loop");
+
+            if (!mqttConnected)
+            {
+                if (wifiState == WIFI_STA_OK && millis() - lastAttempt >= MQTT_RECONNECT_INTERVAL)
+                {
+                    lastAttempt = millis();
+                    connectBroker();
+                }
+            }
+            else if (!mqttClient.connected())
+            {
+                Serial.println("[MQTT] Lost connection");
+                mqttConnected = false;
+                runtimeMetrics.mqttDisconnects++;
+                lastAttempt = millis();
+            }
+            else
+            {
+                mqttClient.loop();
+            }
+
+            drainOutbound();
+
+            // Marker không quay về: kết nối half-open, kết nối lại ngay để gửi lại
+            if (mqttConnected && mqttOutboxAckOverdue())
+            {
+                Serial.println("[MQTT] Outbox ack timeout, reconnecting");
+                mqttClient.disconnect();
+                mqttConnected = false;
+                runtimeMetrics.mqttDisconnects++;
+                lastAttempt = millis() - MQTT_RECONNECT_INTERVAL;
+            }
+
+            if (mqttConnected)
+            {
+                mqttOutboxReplay();
+
+                if (millis() - lastStatsPublish >= STATS_PUBLISH_INTERVAL)
+                {
+                    lastStatsPublish = millis();
+                    publishStreamStats();
+                }
+            }
+        }
+
+        // Thức dậy ngay khi loop() xếp tin gửi đi, không thì theo chu kỳ để giữ keepalive
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(MQTT_TASK_POLL_MS));
+    }
+}
+
+bool startMqttTask(mqtt_message_fn onMessage)
+{
+    if (mqttTaskHandle != NULL) return true;
+
+    if (!startMqttOutbox()) return false;
+
+    if (txRing == nullptr)
+    {
+        txRing = (mqtt_tx_msg_t*)heap_caps_malloc(MQTT_TX_SLOTS * sizeof(mqtt_tx_msg_t), MALLOC_CAP_SPIRAM);
+        rxRing = (mqtt_rx_msg_t*)heap_caps_malloc(MQTT_RX_SLOTS * sizeof(mqtt_rx_msg_t), MALLOC_CAP_SPIRAM);
+        if (txRing == nullptr || rxRing == nullptr)
+        {
+            Serial.println("[MQTT] ERROR: Failed to allocate message rings");
+            heap_caps_free(txRing);
+            heap_caps_free(rxRing);
+            txRing = nullptr;
+            rxRing = nullptr;
+            return false;
+        }
+    }
+
+    messageHandler = onMessage;
+    mqttClient.setServer(MQTT_SERVER, MQTT_PORT);
+    mqttClient.setBufferSize(MQTT_BUFFER_SIZE);
+    mqttClient.setCallback(onMqttMessage);
+
+    // PRO_CPU cùng stack WiFi/lwIP, không tranh CPU với loopTask
+    BaseType_t result = xTaskCreatePinnedToCore(
+        mqttTask,
+        "MqttTask",
+        4096,
+        NULL,
+        1,
+        &mqttTaskHandle,
+        PRO_CPU
+    );
+
+    if (result != pdPASS)
+    {
+        Serial.println("[MQTT] ERROR: Failed to create task!");
+        mqttTaskHandle = NULL;
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,37 @@
+#ifndef MQTT_TASK_H
+#define MQTT_TASK_H
+
+#include "config.h"
+#include <PubSubClient.h>
+#include "mqtt_outbox.h"
+
+// Task MqttTask sở hữu mqttClient: connect (DNS + TCP, có thể chặn vài giây), loop(), phát lại outbox.
+// loop() không bao giờ gọi mạng: tin gửi đi / nhận về đi qua 2 ring 1 producer - 1 consumer không khóa.
+
+#define MQTT_TX_SLOTS               16      // lũy thừa của 2
+#define MQTT_RX_SLOTS               8       // lũy thừa của 2
+#define MQTT_RX_PAYLOAD_MAX         320
+#define MQTT_RECONNECT_INTERVAL     10000
+#define MQTT_TASK_POLL_MS           20      // chu kỳ mqttClient.loop() khi không có tin gửi đi
+
+typedef struct {
+    uint32_t txQueued;
+    uint32_t txFull;            // ring gửi đầy, tin bị bỏ ở phía loop()
+    uint32_t rxQueued;
+    uint32_t rxFull;
+    uint32_t rxTooLarge;
+    uint32_t connectMaxMs;      // connect() lâu nhất (trước đây chặn loop())
+} mqtt_task_stats_t;
+
+extern volatile bool mqttConnected;
+extern PubSubClient mqttClient;
+extern mqtt_task_stats_t mqttTaskStats;
+
+typedef void (*mqtt_message_fn)(const char* topic, const char* payload);
+
+bool startMqttTask(mqtt_message_fn onMessage);
+bool mqttPublishAsync(const char* topic, const char* payload, bool retained, bool coalesce);
+void mqttPollInbound();
+void mqttTask(void* pvParameters);
+
+#endif
@@ -0,0 +1,225 @@
+// File sinh tự động bởi camera/tools/gen_portal_assets.py từ camera/main/portal/, không sửa tay
+#ifndef PORTAL_ASSETS_H
+#define PORTAL_ASSETS_H
+
+#include <Arduino.h>
+
+typedef struct {
+    const char* path;
+    const char* contentType;
+    const char* cacheControl;
+    const char* etag;
+    const uint8_t* gz;
+    size_t gzLen;
+} portal_asset_t;
+
+#define PORTAL_URL_PORTAL_JS "/portal.js?v=e53787ff6de1"
+#define PORTAL_URL_STYLE_CSS "/style.css?v=c1626e5e9147"
+
+// portal.js: 650 -> 346 byte
+static const uint8_t portal_portal_js_gz[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x85, 0x50, 0x5d, 0x6b, 0xc2, 0x30,
+    0x14, 0x7d, 0xf7, 0x57, 0x5c, 0xf2, 0x52, 0x7d, 0x48, 0xd6, 0xa4, 0x51, 0x5b, 0x34, 0x82, 0x83,
+    0xc1, 0x84, 0x09, 0x7b, 0xf0, 0x0f, 0x94, 0x34, 0xba, 0x42, 0x4d, 0x4b, 0x1b, 0x59, 0xbb, 0xb1,
+    0xff, 0xbe, 0x7c, 0x14, 0x45, 0xd8, 0x07, 0x81, 0x73, 0xf3, 0x71, 0xee, 0xc9, 0xb9, 0xe7, 0x78,
+    0xd1, 0xd2, 0x94, 0xb5, 0x06, 0x53, 0x9f, 0x4e, 0x95, 0x7a, 0xcd, 0xbb, 0xee, 0xbd, 0x6e, 0x8b,
+    0xe9, 0x0c, 0x3e, 0x27, 0xb2, 0xd6, 0x9d, 0x81, 0x66, 0xbc, 0xda, 0xe9, 0xe6, 0x62, 0x40, 0x40,
+    0x51, 0xcb, 0xcb, 0x59, 0x69, 0x43, 0x4e, 0xca, 0x3c, 0x55, 0xca, 0x6d, 0x1f, 0x87, 0x5d, 0x31,
+    0x8d, 0xee, 0x88, 0xd1, 0x6c, 0x35, 0xf6, 0xab, 0x41, 0xed, 0xec, 0xee, 0xaf, 0xce, 0x91, 0xe2,
+    0x7a, 0xca, 0x23, 0x4c, 0xef, 0x84, 0x88, 0x19, 0x1a, 0x05, 0x42, 0x08, 0xb8, 0x7e, 0x10, 0x39,
+    0x73, 0x3f, 0x91, 0x20, 0x32, 0xaa, 0x37, 0xd1, 0x6a, 0x32, 0x0a, 0x92, 0x52, 0x6b, 0xd5, 0x3e,
+    0x1f, 0xf6, 0x2f, 0xee, 0x6d, 0xdd, 0xe4, 0xe6, 0x0d, 0x0a, 0x81, 0xf6, 0x74, 0x49, 0x32, 0x0e,
+    0x1e, 0xb7, 0x34, 0x26, 0xf1, 0x12, 0x02, 0xc6, 0x76, 0x51, 0xa0, 0x0c, 0x58, 0x2c, 0xb1, 0x3d,
+    0x62, 0x4a, 0x71, 0xea, 0x21, 0xa7, 0x29, 0xe1, 0x73, 0x08, 0x18, 0x68, 0x73, 0x12, 0x2f, 0xf0,
+    0xdc, 0x4a, 0xec, 0x33, 0x92, 0x01, 0x27, 0x8c, 0x6f, 0x33, 0x62, 0x7b, 0x3d, 0x5c, 0x95, 0xb8,
+    0x74, 0xb2, 0x94, 0x42, 0xea, 0xc1, 0xe9, 0x78, 0x99, 0x51, 0x05, 0x33, 0x42, 0x17, 0x90, 0x10,
+    0x9a, 0x9d, 0xf1, 0x82, 0x2c, 0x19, 0xa6, 0xd6, 0x47, 0x9e, 0x40, 0x12, 0xfa, 0xb1, 0x93, 0xf5,
+    0x80, 0x36, 0xeb, 0x07, 0xe7, 0x7f, 0xb3, 0xae, 0x4a, 0xad, 0xa0, 0xa7, 0x02, 0x51, 0x04, 0x43,
+    0x28, 0x3d, 0x13, 0x88, 0x25, 0xf6, 0x18, 0xaa, 0xa5, 0x3a, 0xd2, 0xc6, 0x06, 0xf1, 0x05, 0xaa,
+    0xea, 0xd4, 0xaf, 0x71, 0x5d, 0x13, 0xfd, 0x3f, 0x32, 0x3b, 0x4c, 0xc7, 0xb1, 0x9b, 0x02, 0xa7,
+    0xb7, 0x79, 0x30, 0x07, 0x17, 0x10, 0xa4, 0xb7, 0xa8, 0x3e, 0x6e, 0x56, 0x65, 0xd9, 0xca, 0x4a,
+    0x81, 0xec, 0xad, 0x4b, 0x86, 0x40, 0x0e, 0xa1, 0xb6, 0x02, 0x79, 0x93, 0xe1, 0xd9, 0xdb, 0xb4,
+    0xeb, 0x1b, 0x7f, 0xfb, 0xcf, 0x7b, 0x8a, 0x02, 0x00, 0x00,
+};
+
+// style.css: 4773 -> 1394 byte
+static const uint8_t portal_style_css_gz[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xad, 0x58, 0xcb, 0x6e, 0xeb, 0x36,
+    0x10, 0xdd, 0xfb, 0x2b, 0x08, 0x18, 0xc1, 0xb5, 0x2f, 0xcc, 0x40, 0xef, 0x38, 0xf2, 0xa6, 0xe8,
+    0xa2, 0x40, 0x17, 0x5d, 0x5d, 0x74, 0xd1, 0x25, 0x25, 0x52, 0x36, 0x1b, 0x99, 0x14, 0x28, 0x39,
+    0x8e, 0x6f, 0x90, 0x7f, 0xef, 0x90, 0x7a, 0xcb, 0x94, 0xe3, 0xa0, 0x17, 0x06, 0x0c, 0x3d, 0x48,
+    0xce, 0x99, 0x73, 0x66, 0x86, 0x43, 0x7d, 0x47, 0xef, 0x8b, 0x23, 0x51, 0x7b, 0x2e, 0x62, 0xe4,
+    0xec, 0x16, 0x05, 0xa1, 0x94, 0x8b, 0xbd, 0xb9, 0x4e, 0xe4, 0x1b, 0x2e, 0xf9, 0x4f, 0x73, 0x9b,
+    0x48, 0x45, 0x99, 0xc2, 0xf0, 0x68, 0xb7, 0xf8, 0x80, 0x37, 0xf4, 0x02, 0xf3, 0x32, 0x29, 0x2a,
+    0x9c, 0x91, 0x23, 0xcf, 0x2f, 0x31, 0xc2, 0xa4, 0x28, 0x72, 0x86, 0xcb, 0x4b, 0x59, 0xb1, 0xe3,
+    0x06, 0xfd, 0x9e, 0x73, 0xf1, 0xf2, 0x17, 0x49, 0x7f, 0x98, 0xfb, 0x3f, 0x60, 0xe4, 0x06, 0x7d,
+    0xfb, 0xc1, 0xf6, 0x92, 0xa1, 0xbf, 0xff, 0xfc, 0xb6, 0x41, 0x25, 0x11, 0x25, 0x2e, 0x99, 0xe2,
+    0x19, 0x18, 0x22, 0xe9, 0xcb, 0x5e, 0xc9, 0x93, 0xa0, 0x31, 0x82, 0x69, 0x8c, 0x28, 0xbc, 0x57,
+    0x84, 0x72, 0x26, 0xaa, 0x95, 0xeb, 0x87, 0x94, 0xed, 0x37, 0x48, 0xed, 0x13, 0xb2, 0x0a, 0xc2,
+    0x0d, 0x7a, 0x0a, 0x36, 0xc8, 0x8d, 0xa2, 0x0d, 0x72, 0x1e, 0x9f, 0xd7, 0xcd, 0x73, 0xdf, 0xd9,
+    0xa0, 0x70, 0x0b, 0xcf, 0xfd, 0x6d, 0xfd, 0x7c, 0xbd, 0x5b, 0x1c, 0xb9, 0xc0, 0x07, 0xc6, 0xf7,
+    0x87, 0x2a, 0x46, 0xae, 0xe3, 0xbc, 0x1e, 0x76, 0x0b, 0xca, 0xcb, 0x22, 0x27, 0x80, 0x35, 0xcb,
+    0x19, 0xf8, 0x41, 0x72, 0xbe, 0x17, 0x98, 0x03, 0xbc, 0x32, 0x46, 0x29, 0x18, 0x63, 0x6a, 0xb7,
+    0xf8, 0xf7, 0x54, 0x56, 0x3c, 0xbb, 0xe0, 0x14, 0x10, 0xc3, 0xa3, 0xfe, 0x45, 0xc7, 0x8c, 0xe7,
+    0x14, 0x30, 0xb9, 0x90, 0x25, 0xaf, 0xb8, 0x04, 0xd6, 0x14, 0xcb, 0x49, 0xc5, 0x5f, 0xd9, 0x6e,
+    0x21, 0x5f, 0x99, 0xca, 0x72, 0x79, 0xc6, 0x6f, 0x31, 0x3a, 0x70, 0x4a, 0x99, 0xd0, 0x64, 0x3d,
+    0xea, 0xa5, 0x08, 0xb8, 0xa5, 0x80, 0xb2, 0xa1, 0xab, 0x06, 0xba, 0x17, 0x82, 0x4f, 0xfd, 0x1f,
+    0x80, 0x8f, 0xd6, 0x9a, 0x7a, 0x43, 0xb7, 0x26, 0xe1, 0x04, 0xe0, 0x5c, 0x4f, 0x9b, 0x34, 0x7a,
+    0x1c, 0x08, 0x95, 0x67, 0x90, 0x07, 0x86, 0x17, 0x6f, 0x28, 0x04, 0x2c, 0x08, 0xeb, 0xd7, 0xf5,
+    0x6a, 0xce, 0xc6, 0xfc, 0x1e, 0xfd, 0x75, 0x8f, 0xa6, 0xc7, 0x72, 0xe6, 0xb4, 0x3a, 0x18, 0x36,
+    0x1e, 0x80, 0x1f, 0xf2, 0x86, 0x9b, 0x07, 0x81, 0x63, 0x5c, 0xd2, 0xd8, 0xa8, 0x92, 0x05, 0xce,
+    0x78, 0x0e, 0x2e, 0x83, 0xe8, 0xf9, 0x49, 0xad, 0xb4, 0xbb, 0x6b, 0xbb, 0xbf, 0x3f, 0x31, 0x17,
+    0x94, 0x81, 0xb3, 0x6e, 0x8b, 0x18, 0x2e, 0x01, 0x4a, 0x29, 0x73, 0x4e, 0x67, 0xdc, 0xd3, 0xc8,
+    0x80, 0x93, 0x03, 0x23, 0xf4, 0x8a, 0x90, 0x39, 0xed, 0x97, 0x1e, 0x0d, 0x08, 0x01, 0xc9, 0x97,
+    0x2e, 0xf3, 0xc9, 0x96, 0xc0, 0x12, 0xa9, 0xcc, 0x25, 0x58, 0x3b, 0x1f, 0x40, 0xbe, 0x81, 0x36,
+    0xbe, 0xe6, 0x43, 0x33, 0xb3, 0x5b, 0x54, 0xec, 0xad, 0xc2, 0x46, 0xe2, 0x81, 0x86, 0x37, 0x44,
+    0x1b, 0x49, 0xd6, 0xc0, 0x3b, 0xb8, 0x6d, 0x94, 0x43, 0x1e, 0x30, 0x90, 0x3e, 0xd0, 0x2b, 0x9b,
+    0x07, 0xe7, 0x26, 0xb4, 0x9e, 0x1c, 0x67, 0xd7, 0x24, 0x10, 0x64, 0x47, 0x55, 0xc9, 0x63, 0x8c,
+    0xb6, 0x9d, 0xfd, 0x81, 0x5c, 0x00, 0x2c, 0x98, 0xca, 0xe4, 0x8e, 0xc8, 0x28, 0xc0, 0x98, 0x2c,
+    0x48, 0xca, 0x2b, 0x08, 0x51, 0x08, 0x84, 0xdd, 0xd0, 0xb4, 0x1b, 0x58, 0x16, 0xd5, 0x64, 0x7b,
+    0x33, 0x8b, 0x36, 0x01, 0x0c, 0x6b, 0xda, 0xd8, 0xb1, 0x31, 0x01, 0x93, 0x32, 0xa9, 0x8e, 0x58,
+    0xcb, 0x51, 0x74, 0x65, 0xa1, 0xf3, 0xaa, 0x8e, 0xfb, 0x76, 0x50, 0x4e, 0x12, 0x96, 0xc3, 0xa0,
+    0x2e, 0xa7, 0x92, 0x5c, 0xa6, 0x2f, 0x76, 0x2a, 0x46, 0x84, 0x45, 0x9a, 0xb0, 0x46, 0xbe, 0x46,
+    0x4f, 0x8b, 0xa3, 0xad, 0x19, 0x2e, 0x8a, 0x93, 0xf6, 0x61, 0x14, 0xba, 0x9d, 0x43, 0x26, 0xf0,
+    0xdd, 0xa8, 0x4e, 0x8e, 0x3a, 0xfe, 0xbc, 0x2e, 0xfe, 0x96, 0x69, 0x42, 0x43, 0xe6, 0x5e, 0x25,
+    0x53, 0x0f, 0xa9, 0x31, 0x68, 0xe6, 0x57, 0x0a, 0x0a, 0x52, 0x43, 0x09, 0xc9, 0x73, 0x1d, 0xa9,
+    0x25, 0x62, 0xa4, 0x64, 0xbb, 0x7b, 0x72, 0x76, 0x3d, 0x41, 0x1c, 0x67, 0x32, 0x3d, 0x95, 0x5a,
+    0xcf, 0x53, 0xa5, 0xa3, 0x3a, 0x46, 0x42, 0x0a, 0xd6, 0x41, 0x69, 0xdd, 0xaf, 0xe3, 0x7a, 0x9a,
+    0xd9, 0xfa, 0xe7, 0xb7, 0xaa, 0x42, 0xc9, 0x83, 0x8a, 0xa7, 0x0b, 0x5e, 0xad, 0xec, 0x10, 0x4c,
+    0x13, 0xfd, 0x06, 0xba, 0xb6, 0x1d, 0x23, 0x73, 0x09, 0x7a, 0xb2, 0x7f, 0x56, 0xd8, 0x35, 0x79,
+    0x0b, 0xb0, 0x0a, 0x52, 0x96, 0x67, 0x30, 0x8c, 0x87, 0x85, 0x68, 0x26, 0x00, 0x2c, 0x63, 0xc7,
+    0x42, 0x34, 0xdc, 0x63, 0x55, 0xab, 0x19, 0x84, 0x8d, 0x5a, 0xdd, 0xc4, 0x4a, 0xee, 0xf7, 0x39,
+    0x1b, 0x59, 0x20, 0x09, 0x28, 0x72, 0xd2, 0x50, 0x9b, 0x59, 0x75, 0x3d, 0xab, 0x64, 0x11, 0x43,
+    0x05, 0x7b, 0x98, 0xf5, 0x00, 0xde, 0x4d, 0x3c, 0x1e, 0xb2, 0xd8, 0xde, 0xa5, 0x27, 0x55, 0x6a,
+    0x36, 0x0b, 0xc9, 0x27, 0x95, 0x3a, 0xe8, 0x03, 0xa3, 0x53, 0x3f, 0xb0, 0x8b, 0xed, 0xb5, 0x62,
+    0xb7, 0xd2, 0x44, 0xc9, 0x93, 0xb7, 0x75, 0x6c, 0xae, 0xc5, 0x07, 0x5d, 0x32, 0x6c, 0xb5, 0x7c,
+    0xb2, 0x3d, 0xb9, 0x7d, 0x9d, 0xea, 0x94, 0x86, 0xe5, 0xd8, 0x85, 0x61, 0x0e, 0xf4, 0x0e, 0xa2,
+    0xda, 0x84, 0x64, 0xb7, 0x59, 0x99, 0xbb, 0x2e, 0xaf, 0xb8, 0xd0, 0x01, 0x84, 0x9b, 0xf4, 0x82,
+    0xf9, 0x49, 0x25, 0x2c, 0x79, 0x77, 0x23, 0x41, 0xea, 0xc4, 0x1d, 0x93, 0x76, 0x57, 0x4e, 0x58,
+    0xf2, 0x76, 0xca, 0xf5, 0x8d, 0xb4, 0x31, 0xb5, 0x8a, 0xb2, 0x54, 0x2a, 0x52, 0xbf, 0xaf, 0x2d,
+    0xff, 0xaf, 0xba, 0x0c, 0xbe, 0xe3, 0x42, 0x71, 0x28, 0x32, 0x97, 0x5f, 0xb5, 0x77, 0x8c, 0x73,
+    0x4f, 0x97, 0x68, 0x37, 0x1c, 0x24, 0xdf, 0x50, 0xd0, 0x66, 0xef, 0x1a, 0x80, 0xb0, 0xc6, 0xc2,
+    0x2c, 0x94, 0x1a, 0x81, 0xb9, 0x08, 0x1c, 0x92, 0xad, 0x67, 0x03, 0xdf, 0x33, 0xa9, 0x3b, 0x46,
+    0x16, 0x35, 0x4a, 0x5a, 0x91, 0x05, 0xd7, 0xc8, 0x20, 0x40, 0x48, 0x92, 0x33, 0x3a, 0x01, 0xb7,
+    0x7c, 0x4e, 0x89, 0x4f, 0xb2, 0x5e, 0x4a, 0x21, 0xb5, 0x1c, 0x40, 0x34, 0xa3, 0x23, 0x3c, 0x6d,
+    0x9c, 0xf4, 0x18, 0xea, 0x27, 0x8d, 0x99, 0x12, 0x84, 0x15, 0xf4, 0x5a, 0x87, 0x65, 0xe6, 0x67,
+    0x41, 0x16, 0x5d, 0x97, 0xf8, 0x1b, 0x05, 0x7a, 0xba, 0xa4, 0x95, 0xd5, 0x25, 0x0b, 0xd9, 0x13,
+    0x4b, 0x66, 0x6b, 0xe8, 0x67, 0x55, 0x90, 0xe4, 0x4c, 0x8d, 0x76, 0xc3, 0xab, 0xcd, 0x63, 0x9c,
+    0x0d, 0xd6, 0xdd, 0xcf, 0x16, 0xa8, 0xf6, 0xb6, 0x29, 0x1c, 0xd9, 0xc5, 0x4c, 0x29, 0x39, 0xd3,
+    0xff, 0x81, 0x8a, 0x9e, 0x17, 0x35, 0x7f, 0xf5, 0x5e, 0xd2, 0xfa, 0x46, 0x53, 0x2f, 0xf2, 0x22,
+    0x5b, 0x73, 0xb5, 0xcc, 0x52, 0x12, 0x92, 0x70, 0x60, 0x81, 0x8b, 0x4c, 0x7e, 0xb1, 0x28, 0x4d,
+    0xa5, 0x99, 0xf4, 0x6e, 0x93, 0x99, 0x5e, 0xed, 0xcf, 0x99, 0x67, 0xdc, 0x34, 0xcd, 0xc3, 0x22,
+    0x74, 0xa3, 0xa1, 0x1e, 0xf1, 0xfd, 0xe5, 0x7d, 0xda, 0xd6, 0x4e, 0x7c, 0xa5, 0x08, 0x5d, 0xf3,
+    0x1d, 0x3c, 0xeb, 0x6d, 0xdb, 0xd1, 0x7f, 0xae, 0x76, 0x6b, 0xbb, 0xfe, 0x54, 0xc2, 0xce, 0xe5,
+    0x3e, 0x30, 0x67, 0xf6, 0xf1, 0xbb, 0x3a, 0x85, 0x9b, 0x91, 0x6a, 0x29, 0x47, 0xde, 0x4c, 0xd2,
+    0xbb, 0x13, 0x74, 0x8f, 0x25, 0xcb, 0x59, 0x5a, 0xd5, 0x29, 0x7f, 0x27, 0xc0, 0x61, 0x7b, 0xe1,
+    0x84, 0xbf, 0x10, 0xdc, 0x30, 0x5a, 0x04, 0x39, 0xea, 0x86, 0x40, 0x07, 0x89, 0x39, 0x2b, 0x8c,
+    0xf6, 0x95, 0x70, 0xd0, 0x40, 0x8f, 0xda, 0x83, 0x69, 0x94, 0xb6, 0xab, 0x41, 0x99, 0x38, 0x29,
+    0xe8, 0x91, 0xc7, 0xad, 0xf9, 0x78, 0x4e, 0xbb, 0x7b, 0x5f, 0xf9, 0xeb, 0x3a, 0x4f, 0x00, 0xd1,
+    0xd5, 0x38, 0xbd, 0x6d, 0x4b, 0x62, 0x7f, 0xb4, 0x03, 0x67, 0xa2, 0xb9, 0xa6, 0x01, 0xec, 0x9f,
+    0x04, 0x64, 0xbc, 0x82, 0x50, 0xbb, 0xe0, 0x2f, 0x1d, 0x60, 0xec, 0xea, 0xd9, 0x0f, 0xaf, 0xa0,
+    0xc2, 0xda, 0xde, 0xe2, 0xb6, 0xc7, 0x74, 0x6c, 0xfa, 0x78, 0x6c, 0x0e, 0x80, 0x5e, 0x77, 0xd9,
+    0x81, 0x6e, 0x73, 0xe5, 0xf3, 0x6c, 0xbe, 0x77, 0x2b, 0xb6, 0x7a, 0x7e, 0xf0, 0xc1, 0xf9, 0x69,
+    0x7c, 0x5d, 0xf5, 0xf1, 0x83, 0x4f, 0x0b, 0xd7, 0xdd, 0xc4, 0x3d, 0xa7, 0x19, 0x13, 0x94, 0x00,
+    0x20, 0x97, 0x44, 0x13, 0x02, 0x36, 0xad, 0xa8, 0xbb, 0x96, 0xcf, 0xe9, 0x1a, 0x1e, 0x4b, 0x27,
+    0x57, 0x16, 0x5c, 0xd4, 0xed, 0xef, 0x4c, 0x7b, 0xd5, 0x74, 0x51, 0xf5, 0x02, 0x6d, 0x43, 0x36,
+    0xee, 0x9f, 0xfc, 0x9b, 0xb4, 0xba, 0xfd, 0xe1, 0xdd, 0xb4, 0xb7, 0xfd, 0xe8, 0x41, 0xb3, 0x3f,
+    0x8a, 0x2d, 0xd3, 0x00, 0x13, 0x01, 0x9b, 0x76, 0x4d, 0xbb, 0xc6, 0x88, 0xdc, 0xb2, 0x89, 0x25,
+    0xc0, 0x97, 0x71, 0x61, 0x1a, 0x95, 0x49, 0x8e, 0x34, 0xa7, 0xb1, 0xdf, 0x5e, 0xd8, 0x25, 0x53,
+    0x90, 0x60, 0x65, 0x3d, 0xf3, 0x7d, 0xe1, 0x3c, 0xa0, 0x77, 0x34, 0x48, 0x63, 0x25, 0x2b, 0xc8,
+    0xe1, 0x95, 0x03, 0x91, 0xb8, 0xde, 0xa1, 0x8f, 0x85, 0x6e, 0x11, 0xad, 0x23, 0xfc, 0xa8, 0x1b,
+    0x03, 0xeb, 0x1e, 0x19, 0xe5, 0x04, 0xad, 0x86, 0x9f, 0x09, 0xb6, 0xfa, 0x53, 0x00, 0x58, 0x18,
+    0x7d, 0xd1, 0x68, 0x15, 0xae, 0x01, 0x0d, 0x86, 0x77, 0xed, 0x42, 0x97, 0x2a, 0x7d, 0x9e, 0x85,
+    0x9d, 0x4a, 0xf6, 0x93, 0xea, 0x68, 0xc0, 0xc7, 0xe2, 0x3f, 0x6d, 0x45, 0x8f, 0xc7, 0xa5, 0x12,
+    0x00, 0x00,
+};
+
+// index.html: 1322 -> 648 byte
+static const uint8_t portal_index_html_gz[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x8d, 0x54, 0x4d, 0x6f, 0xdb, 0x30,
+    0x0c, 0xbd, 0xf7, 0x57, 0x70, 0x3a, 0x6d, 0xc0, 0xdc, 0xd4, 0x49, 0xfa, 0x31, 0x20, 0xce, 0x80,
+    0x65, 0x2d, 0x56, 0xa0, 0x45, 0x03, 0xac, 0xc5, 0xb0, 0xa3, 0x22, 0x33, 0x31, 0x57, 0x45, 0xf2,
+    0x24, 0x39, 0xad, 0xf7, 0xeb, 0x47, 0x59, 0xc9, 0x9c, 0xb4, 0x3b, 0x14, 0x88, 0xc5, 0xf0, 0x89,
+    0x22, 0x1f, 0x49, 0x51, 0x93, 0x77, 0x5f, 0xef, 0x66, 0xf7, 0x3f, 0xe7, 0x97, 0x50, 0x85, 0xb5,
+    0x9e, 0x1e, 0x4d, 0x76, 0x02, 0x65, 0xc9, 0x62, 0x8d, 0x41, 0x82, 0xaa, 0xa4, 0xf3, 0x18, 0x0a,
+    0xf1, 0x70, 0x7f, 0x95, 0x5d, 0x88, 0x1d, 0x6c, 0xe4, 0x1a, 0x0b, 0xb1, 0x21, 0x7c, 0xaa, 0xad,
+    0x0b, 0x02, 0x94, 0x35, 0x01, 0x0d, 0x9b, 0x3d, 0x51, 0x19, 0xaa, 0xa2, 0xc4, 0x0d, 0x29, 0xcc,
+    0x3a, 0xe5, 0x23, 0x90, 0xa1, 0x40, 0x52, 0x67, 0x5e, 0x49, 0x8d, 0x45, 0x7e, 0x7c, 0x12, 0xdd,
+    0x04, 0x0a, 0x1a, 0xa7, 0x3f, 0xe8, 0x8a, 0x60, 0x66, 0xcd, 0x92, 0x56, 0x93, 0x41, 0x82, 0x8e,
+    0x26, 0x9a, 0xcc, 0x23, 0x38, 0xd4, 0x85, 0xf0, 0xa1, 0xd5, 0xe8, 0x2b, 0x44, 0x0e, 0x51, 0x39,
+    0x5c, 0x16, 0x62, 0xd0, 0x41, 0xc7, 0xca, 0xfb, 0xcf, 0x9b, 0x42, 0xe5, 0x67, 0xc3, 0x33, 0x3c,
+    0xc5, 0x4f, 0xf9, 0xf8, 0x3c, 0xfa, 0x1c, 0x6c, 0x99, 0x2f, 0x6c, 0xd9, 0xb2, 0x28, 0x69, 0x03,
+    0x4a, 0x4b, 0xef, 0x0b, 0x11, 0xf9, 0x49, 0x32, 0xe8, 0xc4, 0x21, 0x1e, 0x0f, 0x24, 0xb0, 0xca,
+    0x0f, 0xc9, 0xb0, 0x7e, 0x34, 0xa9, 0xa7, 0x49, 0x6d, 0x9c, 0x0c, 0x64, 0x0d, 0xcc, 0x39, 0x59,
+    0xa9, 0x27, 0x83, 0x3a, 0x06, 0x63, 0x37, 0xaf, 0x83, 0x70, 0x11, 0x5e, 0x84, 0x68, 0x0c, 0x6d,
+    0xd0, 0x79, 0x0a, 0x6d, 0xb6, 0x17, 0x6d, 0x34, 0xbd, 0x36, 0x65, 0xe3, 0x83, 0xe3, 0xc2, 0xc0,
+    0xc3, 0x3f, 0x13, 0xb0, 0x4b, 0xf8, 0x66, 0x61, 0x56, 0x11, 0xdc, 0x92, 0xa9, 0x60, 0xc6, 0x18,
+    0x73, 0x19, 0xf5, 0xf1, 0x96, 0xd6, 0xad, 0x81, 0x7b, 0x50, 0xd9, 0xb2, 0x10, 0xf3, 0xbb, 0xef,
+    0xf7, 0x02, 0xa4, 0x8a, 0xe4, 0xb8, 0x36, 0xda, 0xae, 0xc8, 0xbc, 0x08, 0x1f, 0xed, 0xb3, 0x95,
+    0xb3, 0x4d, 0x1d, 0x37, 0xb4, 0x5c, 0xa0, 0x3e, 0xd8, 0xea, 0x10, 0x31, 0x7d, 0xf0, 0xe8, 0x62,
+    0x53, 0x27, 0x83, 0x0e, 0x60, 0x53, 0x32, 0x75, 0x13, 0x20, 0xb4, 0x35, 0x37, 0x3a, 0xe0, 0x33,
+    0x77, 0x20, 0x35, 0xbd, 0xd9, 0x5a, 0x8a, 0x03, 0x37, 0x9d, 0xb5, 0x80, 0x5a, 0x4b, 0x85, 0x95,
+    0xd5, 0x9c, 0x66, 0x21, 0x2e, 0xb9, 0x1c, 0x0e, 0x7a, 0x7b, 0x87, 0xbf, 0x1b, 0x72, 0x58, 0xfe,
+    0xb7, 0x78, 0x6f, 0xe4, 0x39, 0x67, 0xe4, 0xc9, 0xba, 0xb2, 0xe7, 0xb9, 0xe7, 0xa3, 0xde, 0x6e,
+    0x66, 0x07, 0xed, 0xde, 0x4f, 0x64, 0x67, 0xb1, 0x4b, 0xa6, 0xd7, 0xa9, 0xec, 0xb5, 0xeb, 0x94,
+    0xcc, 0xdb, 0xf2, 0xeb, 0x5d, 0xec, 0xe5, 0xb7, 0x68, 0x42, 0xe0, 0xfb, 0x92, 0x82, 0x26, 0x45,
+    0xbc, 0x62, 0x19, 0xec, 0x6a, 0xa5, 0xb9, 0x2e, 0xd6, 0x28, 0x4d, 0xea, 0x91, 0xcb, 0xdc, 0x01,
+    0xbb, 0x14, 0xdf, 0x7f, 0x88, 0xec, 0xfd, 0x66, 0xb5, 0x3b, 0x88, 0x2d, 0x66, 0xa4, 0xa2, 0xa7,
+    0x48, 0x96, 0xb5, 0xeb, 0x4e, 0x89, 0x53, 0xf8, 0xc5, 0x3e, 0x17, 0xe2, 0x04, 0x4e, 0x60, 0x38,
+    0xe6, 0x9f, 0x80, 0x25, 0x69, 0x1e, 0x1f, 0x63, 0x0d, 0xbb, 0xe7, 0x4b, 0x66, 0x1f, 0x99, 0x86,
+    0x6a, 0x9c, 0xe3, 0xeb, 0x39, 0xb3, 0xda, 0xba, 0x1d, 0x9a, 0x46, 0xb4, 0x10, 0xc3, 0x18, 0xaa,
+    0x96, 0xa1, 0x02, 0xf6, 0x7c, 0x9b, 0x43, 0x3e, 0xf4, 0xe3, 0xec, 0x02, 0xf2, 0xbc, 0x5b, 0x20,
+    0x2d, 0xd9, 0x98, 0xbf, 0xee, 0x4f, 0xc4, 0xbb, 0xe5, 0x8f, 0x98, 0xf2, 0x34, 0xf0, 0x39, 0x3e,
+    0xae, 0xc8, 0x29, 0x8d, 0xa0, 0x98, 0x49, 0x3e, 0xe4, 0x6c, 0xdb, 0x24, 0xb9, 0x50, 0xa3, 0x68,
+    0x95, 0xb6, 0x63, 0xef, 0x39, 0xa5, 0x28, 0x52, 0x59, 0xfa, 0xcb, 0xb0, 0x15, 0x07, 0xa5, 0xf3,
+    0xcd, 0x62, 0x4d, 0x7d, 0x2b, 0x16, 0xc1, 0x00, 0x7f, 0x59, 0xed, 0x68, 0x2d, 0x5d, 0x2b, 0xa6,
+    0x37, 0xf1, 0xc6, 0xef, 0xbb, 0x8a, 0xcd, 0x7a, 0xe5, 0xd2, 0x2b, 0x47, 0x75, 0x00, 0xef, 0x14,
+    0x0f, 0x49, 0xdd, 0xcd, 0xf0, 0xf1, 0xaf, 0xf8, 0x80, 0xe0, 0xe9, 0xe8, 0xfc, 0xe2, 0x7c, 0xb9,
+    0x3c, 0x2b, 0x31, 0x8f, 0x1c, 0x93, 0x61, 0x47, 0x2e, 0x3d, 0x21, 0x83, 0xf4, 0x24, 0xfe, 0x05,
+    0x7f, 0xbf, 0xc0, 0x28, 0x2a, 0x05, 0x00, 0x00,
+};
+
+// scan.html: 772 -> 467 byte
+static const uint8_t portal_scan_html_gz[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x6d, 0x52, 0x4b, 0x6f, 0xd3, 0x40,
+    0x10, 0xbe, 0xfb, 0x57, 0x0c, 0xe6, 0xd0, 0x56, 0xaa, 0x1f, 0x49, 0x20, 0x2d, 0x89, 0xd7, 0x1c,
+    0x02, 0x15, 0x1c, 0x80, 0x4a, 0xa4, 0x42, 0x1c, 0x37, 0xeb, 0x49, 0x3c, 0xca, 0x66, 0xd7, 0xda,
+    0x9d, 0xd8, 0x8d, 0x10, 0xff, 0x9d, 0x75, 0x1e, 0x2d, 0x29, 0x9c, 0x46, 0xfe, 0x3c, 0x3b, 0xdf,
+    0x43, 0x5f, 0xf1, 0xea, 0xc3, 0xb7, 0xd9, 0xfc, 0xe7, 0xfd, 0x47, 0xa8, 0x79, 0xa3, 0xcb, 0xa8,
+    0x38, 0x0d, 0x94, 0x55, 0x18, 0x1b, 0x64, 0x09, 0xaa, 0x96, 0xce, 0x23, 0x8b, 0xf8, 0x61, 0x7e,
+    0x97, 0xdc, 0xc6, 0x27, 0xd8, 0xc8, 0x0d, 0x8a, 0xb8, 0x25, 0xec, 0x1a, 0xeb, 0x38, 0x06, 0x65,
+    0x0d, 0xa3, 0x09, 0x6b, 0x1d, 0x55, 0x5c, 0x8b, 0x0a, 0x5b, 0x52, 0x98, 0xec, 0x3f, 0xae, 0x81,
+    0x0c, 0x31, 0x49, 0x9d, 0x78, 0x25, 0x35, 0x8a, 0x41, 0x9a, 0xf7, 0x67, 0x98, 0x58, 0x63, 0xf9,
+    0x5d, 0x49, 0x63, 0xc8, 0xac, 0xe0, 0x07, 0xdd, 0x11, 0x7c, 0x45, 0xee, 0xac, 0x5b, 0xfb, 0x22,
+    0x3b, 0xfc, 0x8d, 0x0a, 0x4d, 0x66, 0x0d, 0x0e, 0xb5, 0x88, 0x3d, 0xef, 0x34, 0xfa, 0x1a, 0x31,
+    0xb0, 0xd5, 0x0e, 0x97, 0x22, 0xce, 0xf6, 0x50, 0xaa, 0xbc, 0x7f, 0xdf, 0x0a, 0x35, 0x18, 0x0f,
+    0xc7, 0xf8, 0x16, 0xdf, 0x0d, 0xde, 0xdc, 0xf4, 0xe7, 0xb3, 0xa3, 0x89, 0x85, 0xad, 0x76, 0x61,
+    0x54, 0xd4, 0x82, 0xd2, 0xd2, 0x7b, 0x11, 0xf7, 0x52, 0x25, 0x19, 0x74, 0xf1, 0x39, 0xde, 0x3f,
+    0x38, 0x80, 0xf5, 0xe0, 0x59, 0xd7, 0xb3, 0xa4, 0x80, 0x46, 0x45, 0x53, 0xde, 0x6b, 0x94, 0x1e,
+    0xa1, 0x93, 0xc4, 0x69, 0x9a, 0x16, 0x59, 0xd3, 0x93, 0x85, 0x33, 0xff, 0x92, 0x84, 0x3c, 0x5e,
+    0x50, 0x6c, 0x0d, 0xb5, 0xe8, 0x3c, 0xf1, 0x2e, 0xf9, 0x8b, 0x6d, 0x54, 0x7e, 0x36, 0xd5, 0xd6,
+    0xb3, 0x0b, 0x19, 0xc1, 0xc3, 0xd3, 0x0a, 0xd8, 0x25, 0x7c, 0xb2, 0x30, 0xab, 0x09, 0xbe, 0x90,
+    0xa9, 0x61, 0x16, 0xb0, 0xa0, 0x62, 0xf4, 0x5f, 0x3e, 0x6d, 0x65, 0x15, 0xe4, 0xbe, 0xe0, 0xf3,
+    0x0d, 0x99, 0xbd, 0xd1, 0xe3, 0x8b, 0x27, 0x57, 0x4b, 0xeb, 0x40, 0xb6, 0x92, 0xb4, 0x5c, 0x68,
+    0x3c, 0x64, 0x6f, 0x8e, 0x46, 0x83, 0xa9, 0x33, 0x82, 0x7d, 0xc8, 0x22, 0x66, 0x7c, 0xe4, 0x44,
+    0x6a, 0x5a, 0x99, 0x09, 0xa8, 0xe0, 0x0c, 0xdd, 0x14, 0x36, 0xd2, 0xad, 0xc8, 0x24, 0x6c, 0x9b,
+    0x09, 0x0c, 0xf3, 0xe6, 0x71, 0x1a, 0x6a, 0xa0, 0xad, 0x9b, 0xc0, 0xeb, 0xf1, 0xe2, 0x66, 0x78,
+    0x9b, 0x4f, 0xe3, 0x7d, 0x62, 0xf3, 0x9a, 0x7c, 0xd8, 0xdd, 0x01, 0xcb, 0x35, 0x82, 0x84, 0x25,
+    0x76, 0xe0, 0x31, 0x24, 0x54, 0xf9, 0xb3, 0xf8, 0xce, 0x87, 0x57, 0x8e, 0x1a, 0x2e, 0xa3, 0x50,
+    0xbe, 0x39, 0x6d, 0xd0, 0x6e, 0xf9, 0xf2, 0xf2, 0x0a, 0x44, 0x09, 0xbf, 0xa2, 0x8e, 0x4c, 0x65,
+    0xbb, 0x54, 0x5b, 0x25, 0x99, 0xac, 0x49, 0xfb, 0x3a, 0x80, 0x80, 0x8b, 0x2c, 0x14, 0xcc, 0x24,
+    0x0e, 0xfd, 0x56, 0xb3, 0xbf, 0x98, 0x46, 0xbf, 0xaf, 0x61, 0x94, 0xe7, 0xf9, 0xd5, 0x34, 0x1c,
+    0x3d, 0x9d, 0x2b, 0xb2, 0x63, 0x23, 0xb2, 0x43, 0xd9, 0xff, 0x00, 0xca, 0x78, 0xbd, 0xf7, 0x04,
+    0x03, 0x00, 0x00,
+};
+
+static const portal_asset_t portalAssets[] = {
+    { "/portal.js", "application/javascript", "public, max-age=31536000, immutable", "\"e53787ff6de111f4\"", portal_portal_js_gz, sizeof(portal_portal_js_gz) },
+    { "/style.css", "text/css", "public, max-age=31536000, immutable", "\"c1626e5e91475e51\"", portal_style_css_gz, sizeof(portal_style_css_gz) },
+    { "/", "text/html; charset=utf-8", "no-cache", "\"fc68bf305d85361a\"", portal_index_html_gz, sizeof(portal_index_html_gz) },
+    { "/scan.html", "text/html; charset=utf-8", "no-cache", "\"abade2024a9c0e15\"", portal_scan_html_gz, sizeof(portal_scan_html_gz) },
+};
+
+#define PORTAL_ASSET_COUNT (sizeof(portalAssets) / sizeof(portalAssets[0]))
+
+#endif
@@ -0,0 +1,144 @@
+#include "rtp_jpeg.h"
+
+bool rtpJpegParse(const uint8_t* data, size_t len, rtp_jpeg_t* out)
+{
+    const uint8_t* qtById[4] = {nullptr, nullptr, nullptr, nullptr};
+    uint8_t lumaTq = 0, chromaTq = 1;
+    int sampling = -1;
+
+    memset(out, 0, sizeof(*out));
+
+    size_t pos = 2;
+    while (pos + 4 <= len)
+    {
+        if (data[pos] != 0xFF) return false;
+
+        uint8_t marker = data[pos + 1];
+        if (marker == 0xFF)
+        {
+            pos++;
+            continue;
+        }
+
+        size_t segLen = (data[pos + 2] << 8) | data[pos + 3];
+        size_t segEnd = pos + 2 + segLen;
+        const uint8_t* seg = data + pos + 4;
+        if (segLen < 2 || segEnd > len) return false;
+
+        switch (marker)
+        {
+        case 0xDB:
+            // 1 DQT có thể chứa nhiều bảng; bảng 16 bit không gửi được với precision 0
+            for (const uint8_t* p = seg; p < data + segEnd; p += 65)
+            {
+                if ((*p >> 4) != 0 || (*p & 0x0F) > 3 || p + 65 > data + segEnd) return false;
+                qtById[*p & 0x0F] = p + 1;
+            }
+            break;
+
+        case 0xC0:
+            if (segLen < 17 || seg[5] != 3) return false;
+            out->height = (seg[1] << 8) | seg[2];
+            out->width = (seg[3] << 8) | seg[4];
+            sampling = seg[7];
+            lumaTq = seg[8] & 0x03;
+            chromaTq = seg[11] & 0x03;
+            if (seg[10] != 0x11 || seg[13] != 0x11 || seg[14] != seg[11]) return false;
+            break;
+
+        case 0xC1: case 0xC2: case 0xC3: case 0xC5: case 0xC6: case 0xC7:
+        case 0xC9: case 0xCA: case 0xCB: case 0xCD: case 0xCE: case 0xCF:
+            return false;       // chỉ baseline
+
+        case 0xDD:
+            out->restartInterval = (seg[0] << 8) | seg[1];
+            break;
+
+        case 0xDA:
+        {
+            const uint8_t* scan = data + segEnd;
+            const uint8_t* end = data + len - 2;
+            while (end > scan && !(end[0] == 0xFF && end[1] == 0xD9)) end--;
+            if (end <= scan) return false;
+
+            if (sampling == 0x21) out->type = 0;
+            else if (sampling == 0x22) out->type = 1;
+            else return false;
+            if (out->restartInterval) out->type += 64;
+
+            out->qt[0] = qtById[lumaTq];
+            out->qt[1] = qtById[chromaTq];
+            out->scan = scan;
+            out->scanLen = end - scan;
+            return out->qt[0] && out->qt[1] && out->width <= 2040 && out->height <= 2040;
+        }
+        }
+        pos = segEnd;
+    }
+    return false;
+}
+
+// Chia dữ liệu entropy thành các gói, gói đầu mang bảng lượng tử, gói cuối có last = true
+int rtpJpegPacketize(const rtp_jpeg_t* jpg, size_t maxPayload, rtp_jpeg_emit_fn emit, void* ctx)
+{
+    uint8_t header[RTP_JPEG_MAX_HEADER];
+    size_t offset = 0;
+    int packets = 0;
+
+    while (offset < jpg->scanLen)
+    {
+        uint8_t* p = header + RTP_HEADER_SIZE;
+        *p++ = 0;                                   // type-specific
+        *p++ = offset >> 16;
+        *p++ = offset >> 8;
+        *p++ = offset;
+        *p++ = jpg->type;
+        *p++ = RTP_JPEG_Q_INBAND;                   // Q >= 128: bảng lượng tử in-band
+        *p++ = jpg->width / 8;
+        *p++ = jpg->height / 8;
+
+        if (jpg->type >= 64)
+        {
+            *p++ = jpg->restartInterval >> 8;
+            *p++ = jpg->restartInterval;
+            *p++ = 0xFF;                            // F = L = 1, restart count 0x3FFF
+            *p++ = 0xFF;
+        }
+
+        if (offset == 0)
+        {
+            *p++ = 0;                               // MBZ
+            *p++ = 0;                               // precision 8 bit cho cả 2 bảng
+            *p++ = 0;
+            *p++ = 128;
+            memcpy(p, jpg->qt[0], 64);
+            memcpy(p + 64, jpg->qt[1], 64);
+            p += 128;
+        }
+
+        size_t headerLen = p - header;
+        size_t n = min(jpg->scanLen - offset, maxPayload - (headerLen - RTP_HEADER_SIZE));
+        bool last = offset + n >= jpg->scanLen;
+
+        packets++;
+        if (!emit(header, headerLen, jpg->scan + offset, n, last, ctx)) break;
+        offset += n;
+    }
+    return packets;
+}
+
+void rtpWriteHeader(uint8_t* out, bool marker, uint16_t seq, uint32_t timestamp, uint32_t ssrc)
+{
+    out[0] = 0x80;                                  // V = 2
+    out[1] = (marker ? 0x80 : 0) | RTP_PT_JPEG;
+    out[2] = seq >> 8;
+    out[3] = seq;
+    out[4] = timestamp >> 24;
+    out[5] = timestamp >> 16;
+    out[6] = timestamp >> 8;
+    out[7] = timestamp;
+    out[8] = ssrc >> 24;
+    out[9] = ssrc >> 16;
+    out[10] = ssrc >> 8;
+    out[11] = ssrc;
+}
@@ -0,0 +1,37 @@
+#ifndef RTP_JPEG_H
+#define RTP_JPEG_H
+
+#include "config.h"
+
+// Đóng gói JPEG baseline thành payload RTP theo RFC 2435, không phụ thuộc socket.
+// Bảng lượng tử đi in-band (Q = 255) ở gói đầu, Huffman ngầm dùng bảng chuẩn.
+
+#define RTP_PT_JPEG             26
+#define RTP_HEADER_SIZE         12
+#define RTP_JPEG_HEADER_SIZE    8
+#define RTP_RESTART_HEADER_SIZE 4
+#define RTP_QTABLE_HEADER_SIZE  (4 + 128)
+#define RTP_JPEG_MAX_HEADER     (RTP_HEADER_SIZE + RTP_JPEG_HEADER_SIZE + RTP_RESTART_HEADER_SIZE + RTP_QTABLE_HEADER_SIZE)
+#define RTP_JPEG_Q_INBAND       255
+
+// Các phần của frame cần cho RFC 2435, trỏ thẳng vào dữ liệu gốc
+typedef struct {
+    uint8_t type;                   // 0 = 4:2:2, 1 = 4:2:0, +64 khi có DRI
+    uint16_t width;
+    uint16_t height;
+    uint16_t restartInterval;
+    const uint8_t* qt[2];           // luma, chroma: 64 byte 8 bit, thứ tự zigzag như trong DQT
+    const uint8_t* scan;            // dữ liệu entropy, không gồm EOI
+    size_t scanLen;
+} rtp_jpeg_t;
+
+// Gọi cho mỗi gói: header[0..RTP_HEADER_SIZE) để trống cho caller ghi header RTP
+// (mỗi đích có seq/ssrc riêng), phần sau đã là header JPEG. Trả về false để dừng frame.
+typedef bool (*rtp_jpeg_emit_fn)(uint8_t* header, size_t headerLen, const uint8_t* payload, size_t payloadLen,
+                                 bool last, void* ctx);
+
+bool rtpJpegParse(const uint8_t* data, size_t len, rtp_jpeg_t* out);
+int rtpJpegPacketize(const rtp_jpeg_t* jpg, size_t maxPayload, rtp_jpeg_emit_fn emit, void* ctx);
+void rtpWriteHeader(uint8_t* out, bool marker, uint16_t seq, uint32_t timestamp, uint32_t ssrc);
+
+#endif
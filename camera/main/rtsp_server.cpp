@@ -0,0 +1,451 @@
+#include "rtsp_server.h"
+#include "frame_ring.h"
+#include "rtp_jpeg.h"
+#include <lwip/sockets.h>
+
+typedef enum {
+    RTSP_INIT,
+    RTSP_READY,         // đã SETUP
+    RTSP_PLAYING
+} rtsp_state_t;
+
+typedef struct {
+    int fd;                         // -1 = trống
+    rtsp_state_t state;
+    struct sockaddr_in rtpAddr;     // IP client + client_port từ SETUP
+    uint32_t sessionId;
+    uint32_t ssrc;
+    uint16_t rtpSeq;
+    unsigned long lastActivityMs;
+    char req[RTSP_REQUEST_MAX];
+    size_t reqLen;
+} rtsp_session_t;
+
+rtsp_stats_t rtspStats;
+
+static rtsp_session_t sessions[RTSP_MAX_SESSIONS];
+static int listenFd = -1;
+static int rtpFd = -1;
+static TaskHandle_t rtspTaskHandle = NULL;
+static volatile bool stopRequested = false;
+
+static char response[1024];
+
+static void updateSessionCounts()
+{
+    rtspStats.sessions = 0;
+    rtspStats.playing = 0;
+    for (int i = 0; i < RTSP_MAX_SESSIONS; i++)
+    {
+        if (sessions[i].fd < 0) continue;
+        rtspStats.sessions++;
+        if (sessions[i].state == RTSP_PLAYING) rtspStats.playing++;
+    }
+}
+
+static void closeSession(rtsp_session_t* s)
+{
+    if (s->fd >= 0) close(s->fd);
+    s->fd = -1;
+    s->state = RTSP_INIT;
+    s->reqLen = 0;
+    updateSessionCounts();
+}
+
+static bool sendPacket(rtsp_session_t* s, const uint8_t* header, size_t headerLen,
+                       const uint8_t* payload, size_t payloadLen)
+{
+    struct iovec iov[2];
+    iov[0].iov_base = (void*)header;
+    iov[0].iov_len = headerLen;
+    iov[1].iov_base = (void*)payload;
+    iov[1].iov_len = payloadLen;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &s->rtpAddr;
+    msg.msg_namelen = sizeof(s->rtpAddr);
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+
+    // Hết pbuf khi burst cả frame: chờ WiFi xả bớt rồi thử lại 1 lần
+    if (sendmsg(rtpFd, &msg, 0) >= 0) return true;
+    if (errno != ENOMEM) return false;
+    vTaskDelay(1);
+    return sendmsg(rtpFd, &msg, 0) >= 0;
+}
+
+typedef struct {
+    uint32_t timestamp;
+    bool failed[RTSP_MAX_SESSIONS];
+} rtp_send_ctx_t;
+
+// Gửi 1 gói RTP/JPEG tới mọi session đang PLAYING, mỗi session có seq/ssrc riêng
+static bool sendToSessions(uint8_t* header, size_t headerLen, const uint8_t* payload, size_t payloadLen,
+                           bool last, void* ctx)
+{
+    rtp_send_ctx_t* send = (rtp_send_ctx_t*)ctx;
+    for (int i = 0; i < RTSP_MAX_SESSIONS; i++)
+    {
+        rtsp_session_t* s = &sessions[i];
+        if (s->fd < 0 || s->state != RTSP_PLAYING || send->failed[i]) continue;
+
+        rtpWriteHeader(header, last, s->rtpSeq++, send->timestamp, s->ssrc);
+
+        // Lỗi giữa frame thì bỏ phần còn lại, client tự nhận ra qua số thứ tự
+        if (sendPacket(s, header, headerLen, payload, payloadLen)) rtspStats.packetsSent++;
+        else
+        {
+            rtspStats.sendErrors++;
+            send->failed[i] = true;
+        }
+    }
+    return true;
+}
+
+static void sendFrame(const frame_slot_t* slot)
+{
+    rtp_jpeg_t jpg;
+    if (!rtpJpegParse(slot->data, slot->len, &jpg))
+    {
+        rtspStats.unsupportedFrames++;
+        return;
+    }
+
+    rtp_send_ctx_t send;
+    memset(&send, 0, sizeof(send));
+    send.timestamp = (uint32_t)(slot->captureUs * 9 / 100);     // clock 90 kHz
+
+    rtpJpegPacketize(&jpg, RTP_MAX_PAYLOAD, sendToSessions, &send);
+    rtspStats.framesSent++;
+}
+
+// Giá trị header RTSP (không phân biệt hoa thường), "" nếu không có
+static const char* getHeader(const char* req, const char* name, char* out, size_t outSize)
+{
+    size_t nameLen = strlen(name);
+    out[0] = '\0';
+
+    for (const char* line = strstr(req, "\r\n"); line != nullptr; line = strstr(line, "\r\n"))
+    {
+        line += 2;
+        if (strncasecmp(line, name, nameLen) != 0 || line[nameLen] != ':') continue;
+
+        const char* v = line + nameLen + 1;
+        while (*v == ' ') v++;
+        size_t n = 0;
+        while (v[n] && v[n] != '\r' && n < outSize - 1) n++;
+        memcpy(out, v, n);
+        out[n] = '\0';
+        break;
+    }
+    return out;
+}
+
+static void sendResponse(rtsp_session_t* s, int cseq, const char* status, const char* extra, const char* body)
+{
+    int n = snprintf(response, sizeof(response), "RTSP/1.0 %s\r\nCSeq: %d\r\n%s", status, cseq, extra ? extra : "");
+    n = min(n, (int)sizeof(response) - 1);
+    if (body)
+    {
+        n += snprintf(response + n, sizeof(response) - n, "Content-Length: %u\r\n\r\n%s", (unsigned)strlen(body), body);
+    }
+    else
+    {
+        n += snprintf(response + n, sizeof(response) - n, "\r\n");
+    }
+    send(s->fd, response, min(n, (int)sizeof(response) - 1), 0);
+}
+
+static void handleRequest(rtsp_session_t* s, const char* req)
+{
+    char method[16];
+    char value[128];
+    char extra[256];
+
+    s->lastActivityMs = millis();
+
+    int cseq = atoi(getHeader(req, "CSeq", value, sizeof(value)));
+    if (sscanf(req, "%15s", method) != 1)
+    {
+        sendResponse(s, cseq, "400 Bad Request", nullptr, nullptr);
+        return;
+    }
+
+    struct sockaddr_in local;
+    socklen_t addrLen = sizeof(local);
+    getsockname(s->fd, (struct sockaddr*)&local, &addrLen);
+    const char* localIp = inet_ntoa(local.sin_addr);
+
+    if (strcmp(method, "OPTIONS") == 0)
+    {
+        sendResponse(s, cseq, "200 OK", "Public: OPTIONS, DESCRIBE, SETUP, PLAY, TEARDOWN, GET_PARAMETER\r\n", nullptr);
+    }
+    else if (strcmp(method, "DESCRIBE") == 0)
+    {
+        char sdp[256];
+        snprintf(sdp, sizeof(sdp),
+                 "v=0\r\no=- %lu 1 IN IP4 %s\r\ns=%s\r\nc=IN IP4 0.0.0.0\r\nt=0 0\r\n"
+                 "m=video 0 RTP/AVP %d\r\na=control:track1\r\n",
+                 (unsigned long)s->sessionId, localIp, MDNS_HOSTNAME, RTP_PT_JPEG);
+        snprintf(extra, sizeof(extra), "Content-Base: rtsp://%s:%d/mjpeg/\r\nContent-Type: application/sdp\r\n",
+                 localIp, RTSP_PORT);
+        sendResponse(s, cseq, "200 OK", extra, sdp);
+    }
+    else if (strcmp(method, "SETUP") == 0)
+    {
+        // Chỉ RTP/UDP unicast, không hỗ trợ interleaved qua TCP
+        getHeader(req, "Transport", value, sizeof(value));
+        const char* cp = strstr(value, "client_port=");
+        int rtpPort = cp ? atoi(cp + 12) : 0;
+        if (strstr(value, "/TCP") || rtpPort <= 0)
+        {
+            sendResponse(s, cseq, "461 Unsupported Transport", nullptr, nullptr);
+            return;
+        }
+
+        addrLen = sizeof(s->rtpAddr);
+        getpeername(s->fd, (struct sockaddr*)&s->rtpAddr, &addrLen);
+        s->rtpAddr.sin_port = htons(rtpPort);
+        s->ssrc = esp_random();
+        s->rtpSeq = (uint16_t)esp_random();
+        s->state = RTSP_READY;
+
+        snprintf(extra, sizeof(extra),
+                 "Transport: RTP/AVP;unicast;client_port=%d-%d;server_port=%d-%d;ssrc=%08lX\r\nSession: %08lX;timeout=%d\r\n",
+                 rtpPort, rtpPort + 1, RTSP_RTP_PORT, RTSP_RTP_PORT + 1, (unsigned long)s->ssrc,
+                 (unsigned long)s->sessionId, RTSP_SESSION_TIMEOUT_S);
+        sendResponse(s, cseq, "200 OK", extra, nullptr);
+    }
+    else if (strcmp(method, "PLAY") == 0)
+    {
+        if (s->state == RTSP_INIT)
+        {
+            sendResponse(s, cseq, "455 Method Not Valid in This State", nullptr, nullptr);
+            return;
+        }
+
+        s->state = RTSP_PLAYING;
+        updateSessionCounts();
+        snprintf(extra, sizeof(extra), "Session: %08lX\r\nRange: npt=0.000-\r\n", (unsigned long)s->sessionId);
+        sendResponse(s, cseq, "200 OK", extra, nullptr);
+        Serial.printf("[RTSP] Playing to %s:%u\n", inet_ntoa(s->rtpAddr.sin_addr), ntohs(s->rtpAddr.sin_port));
+    }
+    else if (strcmp(method, "TEARDOWN") == 0)
+    {
+        snprintf(extra, sizeof(extra), "Session: %08lX\r\n", (unsigned long)s->sessionId);
+        sendResponse(s, cseq, "200 OK", extra, nullptr);
+        closeSession(s);
+    }
+    else if (strcmp(method, "GET_PARAMETER") == 0 || strcmp(method, "SET_PARAMETER") == 0)
+    {
+        // keepalive
+        snprintf(extra, sizeof(extra), "Session: %08lX\r\n", (unsigned long)s->sessionId);
+        sendResponse(s, cseq, "200 OK", extra, nullptr);
+    }
+    else
+    {
+        sendResponse(s, cseq, "501 Not Implemented", nullptr, nullptr);
+    }
+}
+
+static void readSession(rtsp_session_t* s)
+{
+    int n = recv(s->fd, s->req + s->reqLen, RTSP_REQUEST_MAX - 1 - s->reqLen, 0);
+    if (n <= 0)
+    {
+        closeSession(s);
+        return;
+    }
+    s->reqLen += n;
+    s->req[s->reqLen] = '\0';
+
+    char* end;
+    while (s->fd >= 0 && (end = strstr(s->req, "\r\n\r\n")) != nullptr)
+    {
+        char value[16];
+        end[2] = '\0';
+        size_t total = end + 4 - s->req + atoi(getHeader(s->req, "Content-Length", value, sizeof(value)));
+        end[2] = '\r';
+        if (total > s->reqLen) break;       // chờ đủ body (bỏ qua nội dung)
+
+        end[2] = '\0';
+        handleRequest(s, s->req);
+        if (s->fd < 0) return;
+
+        s->reqLen -= total;
+        memmove(s->req, s->req + total, s->reqLen + 1);
+    }
+
+    if (s->reqLen >= RTSP_REQUEST_MAX - 1)
+    {
+        Serial.println("[RTSP] Request too large, closing");
+        closeSession(s);
+    }
+}
+
+static void acceptSession()
+{
+    struct sockaddr_in addr;
+    socklen_t addrLen = sizeof(addr);
+    int fd = accept(listenFd, (struct sockaddr*)&addr, &addrLen);
+    if (fd < 0) return;
+
+    for (int i = 0; i < RTSP_MAX_SESSIONS; i++)
+    {
+        rtsp_session_t* s = &sessions[i];
+        if (s->fd >= 0) continue;
+
+        s->fd = fd;
+        s->state = RTSP_INIT;
+        s->sessionId = esp_random();
+        s->reqLen = 0;
+        s->lastActivityMs = millis();
+        updateSessionCounts();
+        Serial.printf("[RTSP] Client %s connected\n", inet_ntoa(addr.sin_addr));
+        return;
+    }
+
+    const char* busy = "RTSP/1.0 503 Service Unavailable\r\n\r\n";
+    send(fd, busy, strlen(busy), 0);
+    close(fd);
+}
+
+void rtspServerTask(void* pvParameters)
+{
+    uint32_t lastSeq = 0;
+
+    // Thoát giữa 2 frame: không bao giờ mang theo ref của slot khi task kết thúc
+    while (!stopRequested)
+    {
+        fd_set rfds;
+        FD_ZERO(&rfds);
+        FD_SET(listenFd, &rfds);
+        int maxFd = listenFd;
+        for (int i = 0; i < RTSP_MAX_SESSIONS; i++)
+        {
+            if (sessions[i].fd < 0) continue;
+            FD_SET(sessions[i].fd, &rfds);
+            if (sessions[i].fd > maxFd) maxFd = sessions[i].fd;
+        }
+
+        struct timeval tv = {0, RTSP_POLL_MS * 1000};
+        int ready = select(maxFd + 1, &rfds, NULL, NULL, &tv);
+        if (ready < 0)
+        {
+            vTaskDelay(pdMS_TO_TICKS(RTSP_POLL_MS));
+            continue;
+        }
+
+        if (ready > 0)
+        {
+            if (FD_ISSET(listenFd, &rfds)) acceptSession();
+            for (int i = 0; i < RTSP_MAX_SESSIONS; i++)
+            {
+                if (sessions[i].fd >= 0 && FD_ISSET(sessions[i].fd, &rfds)) readSession(&sessions[i]);
+            }
+        }
+
+        for (int i = 0; i < RTSP_MAX_SESSIONS; i++)
+        {
+            rtsp_session_t* s = &sessions[i];
+            if (s->fd >= 0 && millis() - s->lastActivityMs > RTSP_SESSION_TIMEOUT_S * 1000UL)
+            {
+                Serial.println("[RTSP] Session timed out");
+                closeSession(s);
+            }
+        }
+
+        if (rtspStats.playing == 0) continue;
+
+        // Chỉ gửi frame mới nhất; gateway tự bỏ frame trễ / thiếu gói
+        frame_slot_t* slot = frameRingAcquire(lastSeq);
+        if (slot && slot->len > 0)
+        {
+            if (lastSeq != 0 && slot->seq > lastSeq + 1) rtspStats.framesSkipped += slot->seq - lastSeq - 1;
+            lastSeq = slot->seq;
+            sendFrame(slot);
+        }
+        frameRingRelease(slot);
+    }
+
+    rtspTaskHandle = NULL;
+    vTaskDelete(NULL);
+}
+
+bool startRtspServer()
+{
+    if (rtspTaskHandle != NULL) return true;
+
+    for (int i = 0; i < RTSP_MAX_SESSIONS; i++) sessions[i].fd = -1;
+    memset(&rtspStats, 0, sizeof(rtspStats));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    rtpFd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (listenFd < 0 || rtpFd < 0)
+    {
+        Serial.println("[RTSP] ERROR: Failed to create sockets");
+        stopRtspServer();
+        return false;
+    }
+
+    int yes = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    addr.sin_port = htons(RTSP_PORT);
+    bool ok = bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) == 0 && listen(listenFd, 2) == 0;
+    addr.sin_port = htons(RTSP_RTP_PORT);
+    ok = ok && bind(rtpFd, (struct sockaddr*)&addr, sizeof(addr)) == 0;
+    if (!ok)
+    {
+        Serial.println("[RTSP] ERROR: Failed to bind ports");
+        stopRtspServer();
+        return false;
+    }
+
+    stopRequested = false;
+    BaseType_t result = xTaskCreatePinnedToCore(
+        rtspServerTask,
+        "RtspServer",
+        4096,
+        NULL,
+        2,
+        &rtspTaskHandle,
+        APP_CPU
+    );
+
+    if (result != pdPASS)
+    {
+        Serial.println("[RTSP] ERROR: Failed to create task!");
+        rtspTaskHandle = NULL;
+        stopRtspServer();
+        return false;
+    }
+
+    Serial.printf("[RTSP] Server: rtsp://%s:%d/mjpeg\n", WiFi.localIP().toString().c_str(), RTSP_PORT);
+    return true;
+}
+
+void stopRtspServer()
+{
+    if (listenFd < 0 && rtpFd < 0) return;
+
+    // Chờ task tự trả slot và thoát rồi mới đóng socket nó đang dùng
+    if (rtspTaskHandle != NULL)
+    {
+        stopRequested = true;
+        while (rtspTaskHandle != NULL) vTaskDelay(pdMS_TO_TICKS(RTSP_POLL_MS));
+    }
+
+    for (int i = 0; i < RTSP_MAX_SESSIONS; i++) closeSession(&sessions[i]);
+
+    if (listenFd >= 0) close(listenFd);
+    if (rtpFd >= 0) close(rtpFd);
+    listenFd = -1;
+    rtpFd = -1;
+}
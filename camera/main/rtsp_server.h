@@ -0,0 +1,34 @@
+#ifndef RTSP_SERVER_H
+#define RTSP_SERVER_H
+
+#include "config.h"
+
+// RTSP (RFC 2326) + RTP/JPEG (RFC 2435) qua UDP cho gateway: rtsp://cameraiuh.local:8554/mjpeg
+// Gửi nguyên frame MJPEG từ ring, chỉ tách header: bảng lượng tử đi in-band (Q = 255),
+// Huffman dùng bảng chuẩn nên camera phải dùng bảng mặc định (UVC MJPEG thường bỏ DHT).
+
+#define RTSP_PORT               8554
+#define RTSP_RTP_PORT           5004    // RTCP = RTSP_RTP_PORT + 1, không xử lý
+#define RTSP_MAX_SESSIONS       2
+#define RTSP_REQUEST_MAX        768
+#define RTSP_SESSION_TIMEOUT_S  60      // không có request keepalive thì đóng session
+#define RTP_MAX_PAYLOAD         1400    // vừa 1 datagram, không bị IP fragment
+#define RTSP_POLL_MS            5
+
+typedef struct {
+    uint32_t framesSent;
+    uint32_t packetsSent;
+    uint32_t framesSkipped;     // ring có frame mới hơn trước khi gửi xong frame trước
+    uint32_t unsupportedFrames; // sampling/bảng lượng tử không gửi được theo RFC 2435
+    uint32_t sendErrors;
+    uint8_t sessions;
+    uint8_t playing;
+} rtsp_stats_t;
+
+extern rtsp_stats_t rtspStats;
+
+bool startRtspServer();
+void stopRtspServer();
+void rtspServerTask(void* pvParameters);
+
+#endif
@@ -0,0 +1,227 @@
+#include "security_fsm.h"
+#include <string.h>
+
+#define SEC_ANY         SECURITY_STATE_COUNT    // dòng áp dụng cho mọi trạng thái
+#define SEC_SAME        SECURITY_STATE_COUNT    // giữ nguyên trạng thái
+
+#define SEC_ACTIVE_ROWS(evt, arm) \
+    { SECURITY_WAITING_OWNER_SMS,    evt, SEC_SAME, 0, arm, NULL }, \
+    { SECURITY_WAITING_NEIGHBOR_SMS, evt, SEC_SAME, 0, arm, NULL }, \
+    { SECURITY_ALARM_ACTIVE,         evt, SEC_SAME, 0, arm, NULL }
+
+typedef struct {
+    uint8_t state;
+    uint8_t event;
+    uint8_t next;
+    uint16_t actions;
+    uint8_t arm;                    // timer (re)arm khi chạy dòng này; về IDLE thì huỷ hết
+    const char* status;
+} security_rule_t;
+
+// Dòng cụ thể đứng trước dòng SEC_ANY: dòng khớp đầu tiên thắng
+static const security_rule_t rules[] = {
+    { SECURITY_IDLE, SEC_EVT_MOTION_START, SECURITY_WAITING_OWNER_SMS, SEC_ACT_START_WARNING,
+      SEC_TIMER_BIT(SEC_TIMER_OWNER) | SEC_TIMER_BIT(SEC_TIMER_NEIGHBOR) | SEC_TIMER_BIT(SEC_TIMER_NO_MOTION), "Motion detected" },
+
+    // Còn thấy motion thì lùi hạn tự reset
+    SEC_ACTIVE_ROWS(SEC_EVT_MOTION_START, SEC_TIMER_BIT(SEC_TIMER_NO_MOTION)),
+    SEC_ACTIVE_ROWS(SEC_EVT_MOTION_SEEN, SEC_TIMER_BIT(SEC_TIMER_NO_MOTION)),
+
+    { SECURITY_WAITING_OWNER_SMS, SEC_EVT_OWNER_TIMEOUT, SECURITY_WAITING_NEIGHBOR_SMS,
+      SEC_ACT_OWNER_SMS | SEC_ACT_BUZZER_ON, 0, "Owner SMS sent" },
+    { SECURITY_WAITING_NEIGHBOR_SMS, SEC_EVT_NEIGHBOR_TIMEOUT, SECURITY_ALARM_ACTIVE,
+      SEC_ACT_NEIGHBOR_SMS | SEC_ACT_LOCK | SEC_ACT_ALARM_CLIP, 0, "Neighbor SMS sent" },
+
+    // Motion dừng trước khi báo động thì huỷ; đã báo động thì giữ cửa khóa
+    { SECURITY_IDLE, SEC_EVT_MOTION_END, SEC_SAME, SEC_ACT_BUZZER_OFF, 0, NULL },
+    { SECURITY_WAITING_OWNER_SMS, SEC_EVT_MOTION_END, SECURITY_IDLE, SEC_ACT_BUZZER_OFF, 0, "IDLE" },
+    { SECURITY_WAITING_NEIGHBOR_SMS, SEC_EVT_MOTION_END, SECURITY_IDLE, SEC_ACT_BUZZER_OFF, 0, "IDLE" },
+    { SECURITY_ALARM_ACTIVE, SEC_EVT_MOTION_END, SEC_SAME, SEC_ACT_BUZZER_OFF, 0, "Motion ended - Door locked" },
+
+    { SECURITY_WAITING_OWNER_SMS, SEC_EVT_NO_MOTION_TIMEOUT, SECURITY_IDLE, SEC_ACT_BUZZER_OFF, 0, "IDLE" },
+    { SECURITY_WAITING_NEIGHBOR_SMS, SEC_EVT_NO_MOTION_TIMEOUT, SECURITY_IDLE, SEC_ACT_BUZZER_OFF, 0, "IDLE" },
+    { SECURITY_ALARM_ACTIVE, SEC_EVT_NO_MOTION_TIMEOUT, SECURITY_IDLE, SEC_ACT_BUZZER_OFF, 0, "IDLE" },
+
+    { SEC_ANY, SEC_EVT_FAMILY, SECURITY_IDLE, SEC_ACT_STOP_AUDIO | SEC_ACT_BUZZER_OFF | SEC_ACT_UNLOCK, 0, "Family confirmed" },
+    { SEC_ANY, SEC_EVT_RESET, SECURITY_IDLE, 0, 0, "IDLE" },
+};
+
+static const uint32_t timerDelayMs[SEC_TIMER_COUNT] = {
+    OWNER_SMS_BUZZER_DELAY, NEIGHBOR_SMS_LOCK_DELAY, AUTO_RESET_NO_MOTION
+};
+
+static const security_event_t timerEvent[SEC_TIMER_COUNT] = {
+    SEC_EVT_OWNER_TIMEOUT, SEC_EVT_NEIGHBOR_TIMEOUT, SEC_EVT_NO_MOTION_TIMEOUT
+};
+
+static void unlinkTimer(security_fsm_t* fsm, security_timer_t* t)
+{
+    if (t->prev) t->prev->next = t->next;
+    else fsm->wheel[t->slot] = t->next;
+    if (t->next) t->next->prev = t->prev;
+    t->next = t->prev = NULL;
+    t->armed = false;
+    fsm->armedCount--;
+}
+
+static void cancelTimer(security_fsm_t* fsm, int id)
+{
+    security_timer_t* t = &fsm->timers[id];
+    t->generation++;
+    if (t->armed) unlinkTimer(fsm, t);
+}
+
+static void armTimer(security_fsm_t* fsm, int id, uint32_t now)
+{
+    cancelTimer(fsm, id);
+
+    // Tính từ tick hiện tại, làm tròn lên: không bao giờ hết hạn sớm hơn delay
+    uint32_t span = timerDelayMs[id] + (now - fsm->tickMs);
+    uint32_t ticks = (span + SEC_WHEEL_TICK_MS - 1) / SEC_WHEEL_TICK_MS;
+    if (ticks == 0) ticks = 1;
+
+    security_timer_t* t = &fsm->timers[id];
+    t->slot = (fsm->tick + ticks) & (SEC_WHEEL_SLOTS - 1);
+    t->rounds = (ticks - 1) / SEC_WHEEL_SLOTS;
+    t->armed = true;
+    t->prev = NULL;
+    t->next = fsm->wheel[t->slot];
+    if (t->next) t->next->prev = t;
+    fsm->wheel[t->slot] = t;
+    fsm->armedCount++;
+}
+
+void securityFsmInit(security_fsm_t* fsm, security_clock_fn clock, security_action_fn action, void* ctx)
+{
+    memset(fsm, 0, sizeof(*fsm));
+    fsm->state = SECURITY_IDLE;
+    fsm->clock = clock;
+    fsm->action = action;
+    fsm->ctx = ctx;
+    fsm->tickMs = clock(ctx);
+
+    // Tra bảng O(1) theo (trạng thái, sự kiện)
+    memset(fsm->index, -1, sizeof(fsm->index));
+    for (int r = (int)(sizeof(rules) / sizeof(rules[0])) - 1; r >= 0; r--)
+    {
+        for (int s = 0; s < SECURITY_STATE_COUNT; s++)
+        {
+            if (rules[r].state == s || rules[r].state == SEC_ANY) fsm->index[s][rules[r].event] = (int8_t)r;
+        }
+    }
+}
+
+// now: thời điểm logic của sự kiện (tick của timer hết hạn, hoặc đồng hồ với sự kiện ngoài)
+static void dispatchAt(security_fsm_t* fsm, security_event_t event, uint32_t now)
+{
+    int r = fsm->index[fsm->state][event];
+    if (r < 0)
+    {
+        fsm->stats.ignored++;
+        return;
+    }
+
+    const security_rule_t* rule = &rules[r];
+
+    security_transition_t t;
+    t.event = event;
+    t.from = fsm->state;
+    t.to = rule->next == SEC_SAME ? fsm->state : (SecurityState)rule->next;
+    t.actions = rule->actions;
+    t.status = rule->status;
+
+    fsm->state = t.to;
+    fsm->stats.transitions++;
+
+    if (t.to == SECURITY_IDLE)
+    {
+        for (int i = 0; i < SEC_TIMER_COUNT; i++) cancelTimer(fsm, i);
+    }
+    for (int i = 0; i < SEC_TIMER_COUNT; i++)
+    {
+        if (rule->arm & SEC_TIMER_BIT(i)) armTimer(fsm, i, now);
+    }
+
+    if (fsm->action) fsm->action(fsm->ctx, &t);
+}
+
+void securityFsmDispatch(security_fsm_t* fsm, security_event_t event)
+{
+    // Timer đã hết hạn trước sự kiện này phải chạy trước (loop() có thể bị trễ)
+    securityFsmPoll(fsm);
+    dispatchAt(fsm, event, fsm->clock(fsm->ctx));
+}
+
+// Tiến wheel tới đồng hồ hiện tại và phát sự kiện timeout theo thứ tự thời gian
+void securityFsmPoll(security_fsm_t* fsm)
+{
+    uint32_t now = fsm->clock(fsm->ctx);
+
+    while (now - fsm->tickMs >= SEC_WHEEL_TICK_MS)
+    {
+        // Không còn timer: nhảy thẳng tới tick cuối, đồng hồ ảo chạy vài giờ cũng không tốn vòng lặp
+        if (fsm->armedCount == 0)
+        {
+            uint32_t skip = (now - fsm->tickMs) / SEC_WHEEL_TICK_MS;
+            fsm->tick += skip;
+            fsm->tickMs += skip * SEC_WHEEL_TICK_MS;
+            break;
+        }
+
+        fsm->tick++;
+        fsm->tickMs += SEC_WHEEL_TICK_MS;
+        uint32_t slot = fsm->tick & (SEC_WHEEL_SLOTS - 1);
+
+        // Tách timer hết hạn ra trước: hành động có thể arm/cancel timer khác trong cùng slot
+        int expired[SEC_TIMER_COUNT];
+        uint32_t expiredGen[SEC_TIMER_COUNT];
+        int n = 0;
+
+        security_timer_t* t = fsm->wheel[slot];
+        while (t)
+        {
+            security_timer_t* next = t->next;
+            if (t->rounds == 0)
+            {
+                unlinkTimer(fsm, t);
+                expired[n] = (int)(t - fsm->timers);
+                expiredGen[n] = t->generation;
+                n++;
+            }
+            else
+            {
+                t->rounds--;
+            }
+            t = next;
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            if (fsm->timers[expired[i]].generation != expiredGen[i]) continue;
+            fsm->stats.timersFired++;
+            dispatchAt(fsm, timerEvent[expired[i]], fsm->tickMs);
+        }
+    }
+}
+
+const char* securityStateName(SecurityState state)
+{
+    switch (state)
+    {
+        case SECURITY_IDLE:                 return "IDLE";
+        case SECURITY_MOTION_DETECTED:      return "MOTION_DETECTED";
+        case SECURITY_WAITING_OWNER_SMS:    return "WAITING_OWNER_SMS";
+        case SECURITY_WAITING_NEIGHBOR_SMS: return "WAITING_NEIGHBOR_SMS";
+        case SECURITY_ALARM_ACTIVE:         return "ALARM_ACTIVE";
+        default:                            return "?";
+    }
+}
+
+const char* securityEventName(security_event_t event)
+{
+    static const char* const names[SEC_EVT_COUNT] = {
+        "motion_start", "motion_seen", "motion_end", "family", "reset",
+        "owner_timeout", "neighbor_timeout", "no_motion_timeout"
+    };
+    return event < SEC_EVT_COUNT ? names[event] : "?";
+}
@@ -0,0 +1,108 @@
+#ifndef SECURITY_FSM_H
+#define SECURITY_FSM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Máy trạng thái an ninh dạng bảng: (trạng thái, sự kiện) -> trạng thái mới + hành động + timer.
+// Không phụ thuộc Arduino: đồng hồ và hành động được truyền vào, chạy được trên Linux với đồng hồ ảo
+// để chạy hàng loạt kịch bản xâm nhập mà không phải chờ thời gian thật.
+
+#define OWNER_SMS_BUZZER_DELAY   20000
+#define NEIGHBOR_SMS_LOCK_DELAY  40000
+#define AUTO_RESET_NO_MOTION     5000
+
+#define SEC_WHEEL_SLOTS     64      // lũy thừa của 2
+#define SEC_WHEEL_TICK_MS   10      // bằng chu kỳ loop() cũ
+
+enum SecurityState {
+    SECURITY_IDLE = 0,
+    SECURITY_MOTION_DETECTED,
+    SECURITY_WAITING_OWNER_SMS,
+    SECURITY_WAITING_NEIGHBOR_SMS,
+    SECURITY_ALARM_ACTIVE,
+    SECURITY_STATE_COUNT
+};
+
+typedef enum {
+    SEC_EVT_MOTION_START = 0,
+    SEC_EVT_MOTION_SEEN,            // motion vẫn còn (nhịp 500ms từ sensors_handler)
+    SEC_EVT_MOTION_END,
+    SEC_EVT_FAMILY,
+    SEC_EVT_RESET,                  // tắt thủ công (Blynk, khởi động)
+    SEC_EVT_OWNER_TIMEOUT,
+    SEC_EVT_NEIGHBOR_TIMEOUT,
+    SEC_EVT_NO_MOTION_TIMEOUT,
+    SEC_EVT_COUNT
+} security_event_t;
+
+typedef enum {
+    SEC_TIMER_OWNER = 0,
+    SEC_TIMER_NEIGHBOR,
+    SEC_TIMER_NO_MOTION,
+    SEC_TIMER_COUNT
+} security_timer_id_t;
+
+#define SEC_TIMER_BIT(id)   (1u << (id))
+
+// Hành động, chạy theo thứ tự bit
+#define SEC_ACT_STOP_AUDIO      (1u << 0)
+#define SEC_ACT_START_WARNING   (1u << 1)   // phát âm cảnh báo, ghi clip "motion", publish alert
+#define SEC_ACT_OWNER_SMS       (1u << 2)
+#define SEC_ACT_NEIGHBOR_SMS    (1u << 3)
+#define SEC_ACT_BUZZER_OFF      (1u << 4)
+#define SEC_ACT_BUZZER_ON       (1u << 5)
+#define SEC_ACT_LOCK            (1u << 6)
+#define SEC_ACT_UNLOCK          (1u << 7)
+#define SEC_ACT_ALARM_CLIP      (1u << 8)
+
+typedef struct {
+    security_event_t event;
+    SecurityState from;
+    SecurityState to;
+    uint16_t actions;
+    const char* status;             // publish MQTT status sau khi chạy hành động, NULL = không
+} security_transition_t;
+
+typedef uint32_t (*security_clock_fn)(void* ctx);
+typedef void (*security_action_fn)(void* ctx, const security_transition_t* t);
+
+typedef struct security_timer_s {
+    struct security_timer_s* next;
+    struct security_timer_s* prev;
+    uint32_t rounds;                // số vòng wheel còn lại trước khi hết hạn
+    uint32_t slot;
+    uint32_t generation;            // tăng mỗi lần arm/cancel, bỏ timer đã bị huỷ trong lúc xử lý slot
+    bool armed;
+} security_timer_t;
+
+typedef struct {
+    uint32_t transitions;
+    uint32_t timersFired;
+    uint32_t ignored;               // sự kiện không có dòng trong bảng ở trạng thái hiện tại
+} security_fsm_stats_t;
+
+typedef struct {
+    SecurityState state;
+    int8_t index[SECURITY_STATE_COUNT][SEC_EVT_COUNT];
+
+    security_timer_t timers[SEC_TIMER_COUNT];
+    security_timer_t* wheel[SEC_WHEEL_SLOTS];
+    uint32_t tick;
+    uint32_t tickMs;                // thời điểm của tick hiện tại
+    uint8_t armedCount;
+
+    security_clock_fn clock;
+    security_action_fn action;
+    void* ctx;
+
+    security_fsm_stats_t stats;
+} security_fsm_t;
+
+void securityFsmInit(security_fsm_t* fsm, security_clock_fn clock, security_action_fn action, void* ctx);
+void securityFsmDispatch(security_fsm_t* fsm, security_event_t event);
+void securityFsmPoll(security_fsm_t* fsm);
+const char* securityStateName(SecurityState state);
+const char* securityEventName(security_event_t event);
+
+#endif
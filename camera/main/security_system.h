@@ -4,6 +4,8 @@
 #include "config.h"
 #include <PubSubClient.h>
 #include <ArduinoJson.h>
+#include "mqtt_task.h"
+#include "security_fsm.h"
 
 #define MQTT_SERVER         "camera-monitor.local"
 #define MQTT_PORT           1883
@@ -16,44 +18,24 @@
 #define MQTT_TOPIC_ALERT         "security/camera/alert"
 #define MQTT_TOPIC_FAMILY_DETECT "security/camera/family_detected"
 #define MQTT_TOPIC_CONFIRMATION  "security/camera/confirmation"
+#define MQTT_TOPIC_STATS         "security/camera/stats"
+#define MQTT_TOPIC_OUTBOX_ACK    "security/camera/outbox_ack"    // marker tự gửi - tự nhận của mqtt_outbox
+
+#define MQTT_BUFFER_SIZE         2048
+#define STATS_PUBLISH_INTERVAL   60000
 
 #define PHONE_NUMBER_OWNER    "0976168240"
 #define PHONE_NUMBER_NEIGHBOR "0976168240"
 
-#define OWNER_SMS_BUZZER_DELAY   20000
-#define NEIGHBOR_SMS_LOCK_DELAY  40000
-#define AUTO_RESET_NO_MOTION     5000
-
-enum SecurityState {
-    SECURITY_IDLE = 0,
-    SECURITY_MOTION_DETECTED,
-    SECURITY_WAITING_OWNER_SMS,
-    SECURITY_WAITING_NEIGHBOR_SMS,
-    SECURITY_ALARM_ACTIVE
-};
-
-struct SMSData {
-    char phoneNumber[16];
-    char message[160];
-};
-
 extern SecurityState currentSecurityState;
-extern unsigned long motionDetectedTime;
-extern unsigned long lastMotionSeenTime;
-extern bool ownerSmsAlreadySent;
-extern bool neighborSmsAlreadySent;
-extern bool familyMemberDetected;
 
-extern bool mqttConnected;
-extern PubSubClient mqttClient;
 extern HardwareSerial simSerial;
 
 void initSecuritySystem();
 void initSIM();
 void initMQTT();
 
-void connectMQTT();
-void mqttCallback(char* topic, byte* payload, unsigned int length);
+void handleMqttMessage(const char* topic, const char* message);
 void publishMQTTStatus(const char* message);
 void sendNodeCommand(const char* device, const char* action);
 
@@ -65,10 +47,5 @@ void onFamilyMemberDetected();
 void resetSecurityState();
 void checkSecurityTimers();
 
-bool sendCommand(const char* command, const char* expectedResponse, unsigned long timeout);
-bool sendSMS(const char* phoneNumber, const char* message);
-
-void sendSMSTask(void* parameter);
-void sendSMSAsync(const char* phone, const char* msg);
 
 #endif
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "sensors_handler.h"
 #include "audio_handler.h"
 #include "security_system.h"
+#include "motion_detector.h"
 #include "driver/gpio.h"
 
 bool systemReady = false;
@@ -156,11 +157,36 @@ void resetMotionCooldown()
     Serial.println("[MOTION] Cooldown reset");
 }
 
+#if MOTION_VIDEO_CONFIRM
+// Bắt đầu: PIR phải được video xác nhận (nếu video đang chạy), hoặc video motion kéo dài (PIR bỏ sót).
+// Đang motion: PIR hoặc video còn thấy chuyển động là giữ.
+static int fusedMotionLevel(int pir)
+{
+    if (radarState == HIGH) return (pir == HIGH || motionVideoActive()) ? HIGH : LOW;
+
+    bool confirmed = motionVideoActive() || !motionVideoHealthy();
+    if (pir == HIGH && !confirmed)
+    {
+        static unsigned long lastRejectLog = 0;
+        if (millis() - lastRejectLog > 5000)
+        {
+            Serial.println("[MOTION] PIR trigger not confirmed by video");
+            lastRejectLog = millis();
+        }
+        return LOW;
+    }
+    return (pir == HIGH || motionVideoSustained()) ? HIGH : LOW;
+}
+#endif
+
 void handleMotionLoop() 
 {
     if (!systemReady) return;
     
     radarVal = digitalRead(PIR_PIN);
+#if MOTION_VIDEO_CONFIRM
+    radarVal = fusedMotionLevel(radarVal);
+#endif
     unsigned long currentTime = millis();
     
     // Nếu phát hiện chuyển sang HIGH => reset candidate end
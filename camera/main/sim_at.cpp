@@ -0,0 +1,290 @@
+#include "sim_at.h"
+
+typedef struct {
+    char cmd[SIM_AT_CMD_MAX];
+    char payload[SIM_AT_PAYLOAD_MAX];   // rỗng = lệnh thường, có = chờ '>' rồi gửi kèm Ctrl-Z
+    char expect[16];                    // dòng bắt buộc có trước OK, rỗng = chỉ cần OK
+    uint32_t timeoutMs;
+    sim_at_cb cb;
+    void* ctx;
+} sim_at_cmd_t;
+
+typedef enum {
+    AT_IDLE,
+    AT_WAIT_PROMPT,
+    AT_WAIT_FINAL
+} at_state_t;
+
+typedef struct {
+    char prefix[12];
+    sim_urc_fn fn;
+} urc_handler_t;
+
+sim_at_stats_t simAtStats;
+
+static HardwareSerial* simPort = nullptr;
+static TaskHandle_t simAtTaskHandle = NULL;
+static QueueHandle_t cmdQueue = NULL;
+
+// Ring 1 producer (callback UART) / 1 consumer (task SimAT), không cần khóa
+static uint8_t rxRing[SIM_AT_RX_RING];
+static volatile uint32_t rxHead = 0;
+static volatile uint32_t rxTail = 0;
+
+static urc_handler_t urcHandlers[SIM_AT_MAX_URC];
+static int urcCount = 0;
+
+// Chỉ task SimAT đụng vào
+static sim_at_cmd_t current;
+static at_state_t state = AT_IDLE;
+static bool expectSeen = false;
+static uint32_t deadlineMs = 0;
+static char line[SIM_AT_LINE_MAX];
+static size_t lineLen = 0;
+static char response[SIM_AT_RESPONSE_MAX];
+static size_t responseLen = 0;
+
+// Chạy trong task sự kiện UART của HardwareSerial
+static void onUartReceive()
+{
+    while (simPort->available())
+    {
+        int c = simPort->read();
+        if (c < 0) break;
+        if (rxHead - rxTail >= SIM_AT_RX_RING)
+        {
+            simAtStats.rxOverflows++;
+            continue;
+        }
+        rxRing[rxHead & (SIM_AT_RX_RING - 1)] = (uint8_t)c;
+        rxHead++;
+    }
+
+    if (simAtTaskHandle) xTaskNotifyGive(simAtTaskHandle);
+}
+
+static void finish(sim_at_result_t result)
+{
+    if (result == SIM_AT_ERROR) simAtStats.errors++;
+    else if (result == SIM_AT_TIMEOUT) simAtStats.timeouts++;
+
+    state = AT_IDLE;
+    response[responseLen] = '\0';
+    if (current.cb) current.cb(result, response, current.ctx);
+}
+
+static void startNext()
+{
+    if (state != AT_IDLE || xQueueReceive(cmdQueue, &current, 0) != pdTRUE) return;
+
+    simAtStats.commands++;
+    responseLen = 0;
+    expectSeen = false;
+    deadlineMs = millis() + current.timeoutMs;
+    state = current.payload[0] ? AT_WAIT_PROMPT : AT_WAIT_FINAL;
+
+    simPort->print(current.cmd);
+    simPort->print("\r");
+}
+
+static bool isFinalError(const char* s)
+{
+    return strcmp(s, "ERROR") == 0 || strncmp(s, "+CME ERROR", 10) == 0 || strncmp(s, "+CMS ERROR", 10) == 0;
+}
+
+static void handleLine(const char* s)
+{
+    if (s[0] == '\0') return;
+
+    // Echo lệnh khi modem chưa nhận ATE0
+    if (strncmp(s, "AT", 2) == 0) return;
+
+    bool urc = false;
+    for (int i = 0; i < urcCount; i++)
+    {
+        if (strncmp(s, urcHandlers[i].prefix, strlen(urcHandlers[i].prefix)) == 0)
+        {
+            simAtStats.urcs++;
+            urcHandlers[i].fn(s);
+            urc = true;
+        }
+    }
+
+    if (state == AT_IDLE) return;
+
+    // URC chèn giữa lệnh không thuộc response, trừ khi chính là dòng lệnh đang chờ (vd +CMGS)
+    bool expected = current.expect[0] && strncmp(s, current.expect, strlen(current.expect)) == 0;
+    if (urc && !expected) return;
+
+    if (strcmp(s, "OK") == 0)
+    {
+        finish(current.expect[0] && !expectSeen ? SIM_AT_ERROR : SIM_AT_OK);
+        return;
+    }
+    if (isFinalError(s))
+    {
+        size_t n = strlen(s);
+        if (n >= SIM_AT_RESPONSE_MAX) n = SIM_AT_RESPONSE_MAX - 1;
+        memcpy(response, s, n);
+        responseLen = n;
+        finish(SIM_AT_ERROR);
+        return;
+    }
+
+    if (current.expect[0] && strstr(s, current.expect)) expectSeen = true;
+
+    // Giữ các dòng trả lời trung gian (vd "+CMGS: 12"), cách nhau bởi '\n'
+    size_t n = strlen(s);
+    if (responseLen + n + 1 < SIM_AT_RESPONSE_MAX)
+    {
+        if (responseLen) response[responseLen++] = '\n';
+        memcpy(response + responseLen, s, n);
+        responseLen += n;
+    }
+}
+
+static void drainRx()
+{
+    while (rxTail != rxHead)
+    {
+        char c = (char)rxRing[rxTail & (SIM_AT_RX_RING - 1)];
+        rxTail++;
+
+        // Dấu nhắc "> " của AT+CMGS không có xuống dòng
+        if (state == AT_WAIT_PROMPT && lineLen == 0 && c == '>')
+        {
+            simPort->print(current.payload);
+            simPort->write(26);
+            state = AT_WAIT_FINAL;
+            continue;
+        }
+
+        if (c == '\r' || (c == ' ' && lineLen == 0)) continue;
+        if (c == '\n')
+        {
+            line[lineLen] = '\0';
+            handleLine(line);
+            lineLen = 0;
+            continue;
+        }
+        if (lineLen < SIM_AT_LINE_MAX - 1) line[lineLen++] = c;
+    }
+}
+
+void simAtPoll()
+{
+    drainRx();
+
+    if (state != AT_IDLE && (int32_t)(deadlineMs - millis()) <= 0)
+    {
+        // Đang chờ '>' mà hết giờ thì hủy phần nhập tin để modem không giữ chế độ soạn
+        if (state == AT_WAIT_PROMPT) simPort->write(27);
+        lineLen = 0;
+        finish(SIM_AT_TIMEOUT);
+    }
+
+    startNext();
+}
+
+static void simAtTask(void* pvParameters)
+{
+    while (true)
+    {
+        TickType_t wait = pdMS_TO_TICKS(1000);
+        if (state != AT_IDLE)
+        {
+            int32_t left = (int32_t)(deadlineMs - millis());
+            wait = left > 0 ? pdMS_TO_TICKS(left) : 0;
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+
+        simAtPoll();
+    }
+}
+
+bool startSimAt(HardwareSerial* serial)
+{
+    if (simAtTaskHandle != NULL) return true;
+
+    simPort = serial;
+    cmdQueue = xQueueCreate(SIM_AT_QUEUE_LEN, sizeof(sim_at_cmd_t));
+    if (cmdQueue == NULL)
+    {
+        Serial.println("[SIM] ERROR: Failed to create command queue");
+        return false;
+    }
+
+    BaseType_t result = xTaskCreatePinnedToCore(
+        simAtTask,
+        "SimAT",
+        3072,
+        NULL,
+        2,
+        &simAtTaskHandle,
+        PRO_CPU
+    );
+
+    if (result != pdPASS)
+    {
+        Serial.println("[SIM] ERROR: Failed to create AT task");
+        vQueueDelete(cmdQueue);
+        cmdQueue = NULL;
+        simAtTaskHandle = NULL;
+        return false;
+    }
+
+    simPort->onReceive(onUartReceive);
+    return true;
+}
+
+// Không chặn: đưa vào hàng đợi, false nếu hàng đợi đầy
+static bool enqueue(const sim_at_cmd_t* c)
+{
+    if (xQueueSend(cmdQueue, c, 0) != pdTRUE)
+    {
+        simAtStats.queueFull++;
+        return false;
+    }
+    xTaskNotifyGive(simAtTaskHandle);
+    return true;
+}
+
+bool simAtSubmit(const char* cmd, const char* expect, uint32_t timeoutMs, sim_at_cb cb, void* ctx)
+{
+    if (cmdQueue == NULL) return false;
+
+    sim_at_cmd_t c;
+    memset(&c, 0, sizeof(c));
+    strlcpy(c.cmd, cmd, sizeof(c.cmd));
+    if (expect) strlcpy(c.expect, expect, sizeof(c.expect));
+    c.timeoutMs = timeoutMs;
+    c.cb = cb;
+    c.ctx = ctx;
+    return enqueue(&c);
+}
+
+bool simAtSendSms(const char* phone, const char* text, sim_at_cb cb, void* ctx)
+{
+    if (cmdQueue == NULL) return false;
+
+    sim_at_cmd_t c;
+    memset(&c, 0, sizeof(c));
+    snprintf(c.cmd, sizeof(c.cmd), "AT+CMGS=\"%s\"", phone);
+    strlcpy(c.payload, text, sizeof(c.payload));
+    strlcpy(c.expect, "+CMGS:", sizeof(c.expect));
+    c.timeoutMs = SIM_AT_SMS_TIMEOUT;
+    c.cb = cb;
+    c.ctx = ctx;
+    return enqueue(&c);
+}
+
+// Đăng ký lúc khởi tạo (initSIM), trước khi có lệnh nào chạy
+bool simAtOnUrc(const char* prefix, sim_urc_fn fn)
+{
+    if (urcCount >= SIM_AT_MAX_URC) return false;
+
+    strlcpy(urcHandlers[urcCount].prefix, prefix, sizeof(urcHandlers[urcCount].prefix));
+    urcHandlers[urcCount].fn = fn;
+    urcCount++;
+    return true;
+}
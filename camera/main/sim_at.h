@@ -0,0 +1,50 @@
+#ifndef SIM_AT_H
+#define SIM_AT_H
+
+#include "config.h"
+
+// Engine lệnh AT cho SIM800 không chặn: UART báo có dữ liệu (onReceive) -> ring cố định ->
+// task SimAT tách dòng, chạy lần lượt các lệnh trong hàng đợi với timeout riêng từng lệnh,
+// chuyển URC (+CMTI, RING, +CMGS...) tới handler. Người gọi chỉ nhận callback khi xong.
+
+#define SIM_AT_RX_RING          1024    // lũy thừa 2
+#define SIM_AT_LINE_MAX         128
+#define SIM_AT_RESPONSE_MAX     128
+#define SIM_AT_QUEUE_LEN        8
+#define SIM_AT_MAX_URC          8
+#define SIM_AT_CMD_MAX          48
+#define SIM_AT_PAYLOAD_MAX      161     // 1 SMS 160 ký tự GSM
+#define SIM_AT_DEFAULT_TIMEOUT  2000
+#define SIM_AT_SMS_TIMEOUT      30000   // mạng yếu +CMGS có thể mất vài chục giây
+
+typedef enum {
+    SIM_AT_OK = 0,
+    SIM_AT_ERROR,       // ERROR, +CME ERROR, +CMS ERROR hoặc thiếu dòng expect
+    SIM_AT_TIMEOUT
+} sim_at_result_t;
+
+// Chạy trong task SimAT: không được chặn, response chỉ hợp lệ trong lúc gọi
+typedef void (*sim_at_cb)(sim_at_result_t result, const char* response, void* ctx);
+typedef void (*sim_urc_fn)(const char* line);
+
+typedef struct {
+    uint32_t commands;
+    uint32_t errors;
+    uint32_t timeouts;
+    uint32_t urcs;
+    uint32_t rxOverflows;
+    uint32_t queueFull;
+} sim_at_stats_t;
+
+extern sim_at_stats_t simAtStats;
+
+bool startSimAt(HardwareSerial* serial);
+bool simAtSubmit(const char* cmd, const char* expect, uint32_t timeoutMs, sim_at_cb cb, void* ctx);
+bool simAtSendSms(const char* phone, const char* text, sim_at_cb cb, void* ctx);
+bool simAtOnUrc(const char* prefix, sim_urc_fn fn);
+
+// 1 vòng của task SimAT: tách dòng đã nhận, xử lý timeout, gửi lệnh kế tiếp.
+// Test trên host gọi trực tiếp với đồng hồ ảo thay cho task.
+void simAtPoll();
+
+#endif
@@ -0,0 +1,245 @@
+#include "sms_outbox.h"
+#include <Preferences.h>
+
+#define SMS_NVS_NAMESPACE   "sms_outbox"
+#define SMS_NVS_VERSION     1
+
+sms_outbox_stats_t smsOutboxStats;
+
+// Chỉ loop() (handleSmsOutbox) sửa hàng đợi; callback của SimAT chỉ ghi kết quả vào các biến volatile
+static sms_entry_t outbox[SMS_OUTBOX_MAX];
+static uint32_t enqueuedMs[SMS_OUTBOX_MAX];
+static uint32_t nextAttemptMs[SMS_OUTBOX_MAX];
+static uint32_t nextId = 1;
+
+static Preferences prefs;
+
+static int inFlight = -1;
+static volatile bool sendDone = false;
+static volatile sim_at_result_t sendResult = SIM_AT_OK;
+
+static volatile bool modemReady = false;
+static volatile bool setupPending = false;
+static volatile bool setupFailed = false;
+static uint32_t setupAtMs = 0;
+static uint8_t consecutiveFailures = 0;
+
+static void updateDepth()
+{
+    uint8_t depth = 0;
+    for (int i = 0; i < SMS_OUTBOX_MAX; i++)
+        if (outbox[i].id) depth++;
+
+    smsOutboxStats.depth = depth;
+    if (depth > smsOutboxStats.maxDepth) smsOutboxStats.maxDepth = depth;
+}
+
+static void persist()
+{
+    prefs.putUChar("v", SMS_NVS_VERSION);
+    prefs.putUInt("next", nextId);
+    prefs.putBytes("q", outbox, sizeof(outbox));
+}
+
+static void restore()
+{
+    if (prefs.getUChar("v", 0) != SMS_NVS_VERSION || prefs.getBytesLength("q") != sizeof(outbox)) return;
+
+    prefs.getBytes("q", outbox, sizeof(outbox));
+    nextId = prefs.getUInt("next", 1);
+
+    uint32_t now = millis();
+    for (int i = 0; i < SMS_OUTBOX_MAX; i++)
+    {
+        enqueuedMs[i] = now;
+        nextAttemptMs[i] = now;
+    }
+    updateDepth();
+
+    if (smsOutboxStats.depth) Serial.printf("[SMS] Restored %u queued message(s)\n", smsOutboxStats.depth);
+}
+
+static void onSetupStep(sim_at_result_t result, const char* response, void* ctx)
+{
+    if (result == SIM_AT_OK) return;
+    setupFailed = true;
+    Serial.printf("[SIM] %s failed (%s)\n", (const char*)ctx, result == SIM_AT_TIMEOUT ? "timeout" : response);
+}
+
+static void onSetupDone(sim_at_result_t result, const char* response, void* ctx)
+{
+    onSetupStep(result, response, ctx);
+    modemReady = !setupFailed;
+    setupPending = false;
+    Serial.printf("[SIM] %s\n", modemReady ? "Initialized" : "Init failed");
+}
+
+// Cấu hình chế độ text 1 lần cho cả phiên, chỉ chạy lại khi modem lỗi liên tiếp
+static void setupModem()
+{
+    setupPending = true;
+    setupFailed = false;
+    setupAtMs = millis();
+    consecutiveFailures = 0;
+
+    simAtSubmit("ATE0", nullptr, SIM_AT_DEFAULT_TIMEOUT, onSetupStep, (void*)"ATE0");
+    simAtSubmit("AT+CPIN?", "+CPIN: READY", SIM_AT_DEFAULT_TIMEOUT, onSetupStep, (void*)"AT+CPIN?");
+    simAtSubmit("AT+CMGF=1", nullptr, SIM_AT_DEFAULT_TIMEOUT, onSetupStep, (void*)"AT+CMGF=1");
+    simAtSubmit("AT+CSCS=\"GSM\"", nullptr, SIM_AT_DEFAULT_TIMEOUT, onSetupDone, (void*)"AT+CSCS");
+}
+
+void smsOutboxBegin()
+{
+    prefs.begin(SMS_NVS_NAMESPACE, false);
+    restore();
+    setupModem();
+}
+
+bool smsOutboxEnqueue(const char* phone, const char* text, sms_priority_t priority)
+{
+    int slot = -1;
+    int worst = -1;
+    for (int i = 0; i < SMS_OUTBOX_MAX; i++)
+    {
+        if (outbox[i].id == 0)
+        {
+            slot = i;
+            break;
+        }
+        if (i == inFlight) continue;
+        if (worst < 0 || outbox[i].priority > outbox[worst].priority ||
+            (outbox[i].priority == outbox[worst].priority && outbox[i].id > outbox[worst].id))
+            worst = i;
+    }
+
+    // Đầy: chỉ đẩy tin kém ưu tiên nhất (mới nhất trong mức đó) ra nếu tin mới ưu tiên hơn
+    if (slot < 0)
+    {
+        if (worst < 0 || outbox[worst].priority <= priority)
+        {
+            smsOutboxStats.rejected++;
+            Serial.printf("[SMS] Outbox full, rejected message to %s\n", phone);
+            return false;
+        }
+        Serial.printf("[SMS] Outbox full, evicted message to %s\n", outbox[worst].phone);
+        smsOutboxStats.evicted++;
+        slot = worst;
+    }
+
+    sms_entry_t* e = &outbox[slot];
+    memset(e, 0, sizeof(*e));
+    e->id = nextId++;
+    e->priority = priority;
+    strlcpy(e->phone, phone, sizeof(e->phone));
+    strlcpy(e->text, text, sizeof(e->text));
+    enqueuedMs[slot] = millis();
+    nextAttemptMs[slot] = enqueuedMs[slot];
+
+    updateDepth();
+    persist();
+    Serial.printf("[SMS] Queued to %s (prio %d, depth %u)\n", phone, priority, smsOutboxStats.depth);
+    return true;
+}
+
+// Mỗi người nhận 1 entry, bỏ số trùng trong cùng lô; trả về số entry đã xếp hàng
+int smsOutboxEnqueueMulti(const char* const* phones, int count, const char* text, sms_priority_t priority)
+{
+    int queued = 0;
+    for (int i = 0; i < count; i++)
+    {
+        bool duplicate = false;
+        for (int k = 0; k < i; k++)
+            if (strcmp(phones[k], phones[i]) == 0) duplicate = true;
+
+        if (!duplicate && smsOutboxEnqueue(phones[i], text, priority)) queued++;
+    }
+    return queued;
+}
+
+static void onSmsSent(sim_at_result_t result, const char* response, void* ctx)
+{
+    if (result != SIM_AT_OK) Serial.printf("[SMS] FAILED (%s)\n", result == SIM_AT_TIMEOUT ? "timeout" : response);
+    sendResult = result;
+    sendDone = true;
+}
+
+static void completeInFlight()
+{
+    sms_entry_t* e = &outbox[inFlight];
+    uint32_t now = millis();
+
+    if (sendResult == SIM_AT_OK)
+    {
+        uint32_t latency = now - enqueuedMs[inFlight];
+        smsOutboxStats.sent++;
+        smsOutboxStats.lastLatencyMs = latency;
+        smsOutboxStats.totalLatencyMs += latency;
+        if (latency > smsOutboxStats.maxLatencyMs) smsOutboxStats.maxLatencyMs = latency;
+        Serial.printf("[SMS] OK to %s in %lu ms (attempt %u)\n", e->phone, (unsigned long)latency, e->attempts + 1);
+
+        e->id = 0;
+        consecutiveFailures = 0;
+    }
+    else
+    {
+        e->attempts++;
+        if (++consecutiveFailures >= SMS_MODEM_FAIL_LIMIT) modemReady = false;
+
+        if (e->attempts >= SMS_MAX_ATTEMPTS)
+        {
+            smsOutboxStats.failed++;
+            Serial.printf("[SMS] Giving up on %s after %u attempts\n", e->phone, e->attempts);
+            e->id = 0;
+        }
+        else
+        {
+            uint32_t backoff = min((uint32_t)SMS_RETRY_MAX_MS, (uint32_t)SMS_RETRY_BASE_MS << (e->attempts - 1));
+            nextAttemptMs[inFlight] = now + backoff;
+            smsOutboxStats.retries++;
+        }
+    }
+
+    inFlight = -1;
+    updateDepth();
+    persist();
+}
+
+// Gọi mỗi vòng loop(): xử lý kết quả tin vừa gửi, gửi tin kế tiếp ngay nếu đến hạn
+void handleSmsOutbox()
+{
+    if (sendDone)
+    {
+        sendDone = false;
+        if (inFlight >= 0) completeInFlight();
+    }
+
+    if (inFlight >= 0 || smsOutboxStats.depth == 0) return;
+
+    if (!modemReady)
+    {
+        if (!setupPending && millis() - setupAtMs >= SMS_SETUP_RETRY_MS) setupModem();
+        return;
+    }
+
+    uint32_t now = millis();
+    int best = -1;
+    int due = 0;
+    for (int i = 0; i < SMS_OUTBOX_MAX; i++)
+    {
+        if (outbox[i].id == 0 || (int32_t)(now - nextAttemptMs[i]) < 0) continue;
+        due++;
+        if (best < 0 || outbox[i].priority < outbox[best].priority ||
+            (outbox[i].priority == outbox[best].priority && outbox[i].id < outbox[best].id))
+            best = i;
+    }
+    if (best < 0) return;
+
+    // Còn tin khác phía sau: giữ link SMS relay mở giữa các tin (tự tắt sau vài giây rảnh)
+    if (due > 1) simAtSubmit("AT+CMMS=1", nullptr, SIM_AT_DEFAULT_TIMEOUT, nullptr, nullptr);
+
+    if (simAtSendSms(outbox[best].phone, outbox[best].text, onSmsSent, nullptr))
+    {
+        inFlight = best;
+        Serial.printf("[SMS] Sending to %s (depth %u)\n", outbox[best].phone, smsOutboxStats.depth);
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef SMS_OUTBOX_H
+#define SMS_OUTBOX_H
+
+#include "config.h"
+#include "sim_at.h"
+
+// Hàng đợi SMS có ưu tiên, lưu NVS để không mất cảnh báo khi reset.
+// Mỗi người nhận là 1 entry (retry riêng), gửi liên tiếp trong cùng phiên modem:
+// cấu hình CMGF/CSCS chỉ chạy 1 lần, AT+CMMS=1 giữ link SMS giữa các tin liên tiếp.
+
+#define SMS_OUTBOX_MAX          8
+#define SMS_MAX_ATTEMPTS        5
+#define SMS_RETRY_BASE_MS       5000    // 5s, 10s, 20s, 40s...
+#define SMS_RETRY_MAX_MS        120000
+#define SMS_MODEM_FAIL_LIMIT    3       // lỗi liên tiếp thì chạy lại cấu hình modem
+#define SMS_SETUP_RETRY_MS      30000
+#define SMS_PHONE_MAX           16
+
+typedef enum {
+    SMS_PRIO_CRITICAL = 0,      // báo động, leo thang
+    SMS_PRIO_HIGH,
+    SMS_PRIO_NORMAL
+} sms_priority_t;
+
+typedef struct {
+    uint32_t id;                // tăng dần, FIFO trong cùng mức ưu tiên; 0 = slot trống
+    uint8_t priority;
+    uint8_t attempts;
+    char phone[SMS_PHONE_MAX];
+    char text[SIM_AT_PAYLOAD_MAX];
+} sms_entry_t;
+
+typedef struct {
+    uint8_t depth;
+    uint8_t maxDepth;
+    uint32_t sent;
+    uint32_t retries;
+    uint32_t failed;            // bỏ sau SMS_MAX_ATTEMPTS lần
+    uint32_t evicted;           // bị tin ưu tiên cao hơn đẩy ra khi đầy
+    uint32_t rejected;          // đầy và tin mới không ưu tiên hơn
+    uint32_t lastLatencyMs;     // từ lúc xếp hàng (hoặc nạp lại sau reset) tới khi modem nhận
+    uint32_t maxLatencyMs;
+    uint64_t totalLatencyMs;
+} sms_outbox_stats_t;
+
+extern sms_outbox_stats_t smsOutboxStats;
+
+void smsOutboxBegin();
+bool smsOutboxEnqueue(const char* phone, const char* text, sms_priority_t priority);
+int smsOutboxEnqueueMulti(const char* const* phones, int count, const char* text, sms_priority_t priority);
+void handleSmsOutbox();
+
+#endif
@@ -0,0 +1,631 @@
+#include "stream_mux.h"
+#include "web_server.h"
+#include "camera_handler.h"
+#include "stream_stats.h"
+#include "ws_stream.h"
+#include "trace.h"
+#include <lwip/sockets.h>
+
+#define STREAM_SEND_CHUNK (STREAM_SEND_SEGMENTS * TCP_MSS)
+
+#if STREAM_SEND_GATHER
+#define STREAM_FIRST_STATE STREAM_BODY      // cả part gửi chung, không có bước header riêng
+#else
+#define STREAM_FIRST_STATE STREAM_HEADER
+#endif
+
+stream_mux_stats_t streamMuxStats;
+
+// Chỉ Content-Length thay đổi theo frame
+static const char partPrefix[] = "--frame\r\nContent-Type: image/jpeg\r\nContent-Length: ";
+static const size_t partPrefixLen = sizeof(partPrefix) - 1;
+
+static stream_client_t* streamClients[MAX_CLIENTS];
+static TaskHandle_t streamMuxHandle = NULL;
+static volatile bool stopRequested = false;
+static int wsListenFd = -1;
+
+// Mux -> PreviewScaler: client cần frame thu nhỏ mới; PreviewScaler -> mux: client đã có kết quả.
+// Client nằm trong 2 queue này (state STREAM_SCALING) chỉ do PreviewScaler đụng vào.
+static TaskHandle_t scalerHandle = NULL;
+static QueueHandle_t scaleRequests = NULL;
+static QueueHandle_t scaleResults = NULL;
+static int scalesInFlight = 0;     // chỉ mux task sửa
+
+static void closeClient(stream_client_t* sc)
+{
+    Serial.printf("[STREAM] Client %s disconnected, cleaning up\n",
+                  IPAddress(clientStats[sc->slot].ip).toString().c_str());
+
+    frameRingRelease(sc->frame);
+    streamStatsClientEnd(sc->slot);
+    sc->client.stop();
+    if (sc->scaled) jpegScalerFree(&sc->scaler);
+    free(sc->rx);
+
+    streamClients[sc->slot] = nullptr;
+    streamMuxStats.clients--;
+    delete sc;
+}
+
+static void acceptClient(stream_client_t* sc)
+{
+    int slot = -1;
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        if (streamClients[i] == nullptr)
+        {
+            slot = i;
+            break;
+        }
+    }
+
+    sc->fd = sc->client.fd();
+    if (sc->proto == STREAM_PROTO_WS && sc->rx == nullptr) sc->rx = (uint8_t*)malloc(WS_RX_MAX + 1);
+
+    if (slot < 0 || sc->fd < 0 || (sc->proto == STREAM_PROTO_WS && sc->rx == nullptr))
+    {
+        Serial.println("[STREAM] Max clients reached, rejecting");
+        streamMuxStats.rejected++;
+        sc->client.stop();
+        free(sc->rx);
+        delete sc;
+        return;
+    }
+
+    int flags = fcntl(sc->fd, F_GETFL, 0);
+    fcntl(sc->fd, F_SETFL, flags | O_NONBLOCK);
+
+    if (sc->proto == STREAM_PROTO_WS)
+    {
+        sc->state = STREAM_WS_HANDSHAKE;
+        sc->trailerLen = 0;
+    }
+    else
+    {
+        memcpy(sc->header, partPrefix, partPrefixLen);
+        sc->state = STREAM_IDLE;
+        sc->trailerLen = 2;
+    }
+    sc->rxLen = 0;
+    sc->credits = 0;
+    sc->pongPending = false;
+    sc->acceptedMs = millis();
+
+    sc->slot = slot;
+    sc->frame = nullptr;
+    sc->sent = 0;
+    sc->lastSeq = 0;
+    sc->windowFrames = 0;
+    sc->windowBytes = 0;
+    sc->windowSkipped = 0;
+    sc->windowStartMs = millis();
+
+    sc->scaled = false;
+    if (sc->scaleDiv > 1)
+    {
+        sc->scaled = jpegScalerInit(&sc->scaler, sc->scaleDiv);
+        if (!sc->scaled) Serial.println("[STREAM] Scaler alloc failed, sending full frames");
+    }
+
+    streamClients[slot] = sc;
+    streamStatsClientBegin(slot, (uint32_t)sc->client.remoteIP());
+    clientStats[slot].websocket = sc->proto == STREAM_PROTO_WS;
+
+    streamMuxStats.clients++;
+    if (streamMuxStats.clients > streamMuxStats.maxClients) streamMuxStats.maxClients = streamMuxStats.clients;
+
+    Serial.printf("[STREAM] Streaming client %s (slot %d, %u active)\n",
+                  sc->client.remoteIP().toString().c_str(), slot, streamMuxStats.clients);
+}
+
+// Chuẩn bị header cho frame (gốc hoặc đã thu nhỏ) và bắt đầu gửi
+static void beginPart(stream_client_t* sc, const uint8_t* data, size_t len)
+{
+    if (sc->lastSeq != 0 && sc->info.seq > sc->lastSeq + 1)
+    {
+        uint32_t skipped = sc->info.seq - sc->lastSeq - 1;
+        clientStats[sc->slot].framesSkipped += skipped;
+        sc->windowSkipped += skipped;
+    }
+
+    sc->data = data;
+    sc->len = len;
+
+    if (sc->proto == STREAM_PROTO_WS)
+    {
+        sc->headerLen = wsFrameHeader((uint8_t*)sc->header, &sc->info, len);
+        sc->credits--;
+    }
+    else
+    {
+        char* p = sc->header + partPrefixLen;
+        utoa(len, p, 10);
+        p += strlen(p);
+        memcpy(p, "\r\n\r\n", 4);
+        sc->headerLen = p + 4 - sc->header;
+    }
+
+    sc->sent = 0;
+    sc->state = STREAM_FIRST_STATE;
+}
+
+// Lấy frame mới nhất; socket đã ghi được nên client không bị tụt lại phía sau.
+// Client preview chuyển cho PreviewScaler, mux tiếp tục phục vụ client khác trong lúc thu nhỏ.
+static void startFrame(stream_client_t* sc)
+{
+    if (sc->scaled)
+    {
+        sc->state = STREAM_SCALING;
+        scalesInFlight++;
+        xQueueSend(scaleRequests, &sc, portMAX_DELAY);      // tối đa MAX_CLIENTS phần tử, không bao giờ đầy
+        return;
+    }
+
+    frame_slot_t* slot = frameRingAcquire(sc->lastSeq);
+    if (slot == nullptr) return;
+
+    if (slot->len == 0)
+    {
+        sc->lastSeq = slot->seq;
+        frameRingRelease(slot);
+        return;
+    }
+
+    sc->frame = slot;
+    sc->info = *slot;
+    beginPart(sc, slot->data, slot->len);
+}
+
+// Kết quả từ PreviewScaler: slot đã được trả về ring, chỉ còn bản thu nhỏ trong scaler.out
+static void finishScaling(stream_client_t* sc)
+{
+    scalesInFlight--;
+    sc->state = STREAM_IDLE;
+
+    // info.seq = 0: chưa có frame mới; len = 0: frame lỗi giải mã, bỏ qua và chờ frame sau
+    if (sc->len == 0)
+    {
+        if (sc->info.seq != 0) sc->lastSeq = sc->info.seq;
+        return;
+    }
+    beginPart(sc, sc->scaler.out, sc->len);
+}
+
+// Thu nhỏ frame cho client preview, tách khỏi StreamMux để 1 lần thu nhỏ không chặn select() của client khác
+static void previewScalerTask(void* pvParameters)
+{
+    stream_client_t* sc;
+    while (true)
+    {
+        if (xQueueReceive(scaleRequests, &sc, portMAX_DELAY) != pdTRUE) continue;
+
+        sc->info.seq = 0;
+        sc->len = 0;
+
+        frame_slot_t* slot = frameRingAcquire(sc->lastSeq);
+        if (slot != nullptr)
+        {
+            sc->info = *slot;
+            {
+                TRACE_SCOPE("stream_scale");
+                if (slot->len > 0 && jpegScaleFrame(&sc->scaler, slot->data, slot->len)) sc->len = sc->scaler.outLen;
+            }
+            // Trả slot ngay, không giữ frame gốc trong lúc gửi bản thu nhỏ qua WiFi
+            frameRingRelease(slot);
+        }
+
+        xQueueSend(scaleResults, &sc, portMAX_DELAY);
+    }
+}
+
+static inline void recordSend(stream_client_t* sc, int n)
+{
+    client_stats_t* stats = &clientStats[sc->slot];
+    stats->sendCalls++;
+    stats->segments += (n + TCP_MSS - 1) / TCP_MSS;
+}
+
+static void finishFrame(stream_client_t* sc)
+{
+    client_stats_t* stats = &clientStats[sc->slot];
+    int64_t lastByteUs = esp_timer_get_time();
+
+    latencyRecord(&stats->publishToFirstByte, (uint32_t)(sc->firstByteUs - sc->info.publishUs));
+    latencyRecord(&stats->firstToLastByte, (uint32_t)(lastByteUs - sc->firstByteUs));
+    latencyRecord(&stats->captureToLastByte, (uint32_t)(lastByteUs - sc->info.captureUs));
+    stats->framesSent++;
+    stats->bytesSent += sc->len;
+    frame_cnt_sent++;
+    sc->windowFrames++;
+    sc->windowBytes += sc->headerLen + sc->len + sc->trailerLen;
+
+    sc->lastSeq = sc->info.seq;
+    frameRingRelease(sc->frame);
+    sc->frame = nullptr;
+    sc->state = STREAM_IDLE;
+}
+
+#if STREAM_SEND_GATHER
+// iovec cho phần còn lại của part bắt đầu từ offset, tổng tối đa limit bytes
+static int buildIov(stream_client_t* sc, struct iovec* iov, size_t limit)
+{
+    const uint8_t* parts[3] = {(const uint8_t*)sc->header, sc->data, (const uint8_t*)"\r\n"};
+    size_t lens[3] = {sc->headerLen, sc->len, sc->trailerLen};
+
+    size_t offset = sc->sent;
+    int cnt = 0;
+    for (int i = 0; i < 3 && limit > 0; i++)
+    {
+        if (offset >= lens[i])
+        {
+            offset -= lens[i];
+            continue;
+        }
+
+        size_t n = min(lens[i] - offset, limit);
+        iov[cnt].iov_base = (void*)(parts[i] + offset);
+        iov[cnt].iov_len = n;
+        cnt++;
+        limit -= n;
+        offset = 0;
+    }
+    return cnt;
+}
+
+// Header + JPEG + "\r\n" trong 1 writev, chia khối bội số MSS để lwIP đóng segment đầy
+static bool pumpClient(stream_client_t* sc)
+{
+    size_t total = sc->headerLen + sc->len + sc->trailerLen;
+    if (sc->sent == 0) sc->firstByteUs = esp_timer_get_time();
+
+    while (sc->sent < total)
+    {
+        struct iovec iov[3];
+        int cnt = buildIov(sc, iov, STREAM_SEND_CHUNK);
+        int n = writev(sc->fd, iov, cnt);
+        if (n > 0)
+        {
+            recordSend(sc, n);
+            sc->sent += n;
+            continue;
+        }
+        return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+
+    sc->sent = 0;
+    finishFrame(sc);
+    return true;
+}
+#else
+// Gửi tiếp phần hiện tại đến khi xong hoặc send buffer đầy; false = socket lỗi
+static bool sendPart(stream_client_t* sc, const uint8_t* buf, size_t len)
+{
+    while (sc->sent < len)
+    {
+        int n = send(sc->fd, buf + sc->sent, len - sc->sent, MSG_DONTWAIT);
+        if (n > 0)
+        {
+            recordSend(sc, n);
+            sc->sent += n;
+            continue;
+        }
+        return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+    return true;
+}
+
+static bool pumpClient(stream_client_t* sc)
+{
+    if (sc->state == STREAM_HEADER)
+    {
+        if (sc->sent == 0) sc->firstByteUs = esp_timer_get_time();
+        if (!sendPart(sc, (const uint8_t*)sc->header, sc->headerLen)) return false;
+        if (sc->sent < sc->headerLen) return true;
+        sc->sent = 0;
+        sc->state = STREAM_BODY;
+    }
+
+    if (sc->state == STREAM_BODY)
+    {
+        if (!sendPart(sc, sc->data, sc->len)) return false;
+        if (sc->sent < sc->len) return true;
+        sc->sent = 0;
+        sc->state = STREAM_TRAILER;
+    }
+
+    if (sc->state == STREAM_TRAILER)
+    {
+        if (!sendPart(sc, (const uint8_t*)"\r\n", sc->trailerLen)) return false;
+        if (sc->sent < sc->trailerLen) return true;
+        sc->sent = 0;
+        finishFrame(sc);
+    }
+    return true;
+}
+#endif
+
+// Client MJPEG không gửi gì sau request, đọc được 0 byte nghĩa là đã đóng kết nối
+static bool drainInput(stream_client_t* sc)
+{
+    if (sc->proto == STREAM_PROTO_WS)
+    {
+        int n = recv(sc->fd, sc->rx + sc->rxLen, WS_RX_MAX - sc->rxLen, MSG_DONTWAIT);
+        if (n == 0) return false;
+        if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK;
+
+        sc->rxLen += n;
+        return sc->state == STREAM_WS_HANDSHAKE ? wsHandshake(sc) : wsHandleInput(sc);
+    }
+
+    uint8_t buf[64];
+    int n = recv(sc->fd, buf, sizeof(buf), MSG_DONTWAIT);
+    if (n > 0) return true;
+    return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+static void acceptWsClient()
+{
+    struct sockaddr_in addr;
+    socklen_t addrLen = sizeof(addr);
+    int fd = accept(wsListenFd, (struct sockaddr*)&addr, &addrLen);
+    if (fd < 0) return;
+
+    stream_client_t* sc = new stream_client_t;
+    sc->client = WiFiClient(fd);
+    sc->active = true;
+    sc->slot = -1;
+    sc->scaleDiv = 1;
+    sc->proto = STREAM_PROTO_WS;
+    sc->rx = nullptr;
+    acceptClient(sc);
+}
+
+// Client rảnh chỉ lấy frame mới khi socket ghi được (backpressure), WebSocket còn cần credit
+static bool clientWantsWrite(const stream_client_t* sc, uint32_t latestSeq)
+{
+    if (sc->state == STREAM_WS_HANDSHAKE || sc->state == STREAM_SCALING) return false;
+    if (sc->state != STREAM_IDLE || sc->pongPending) return true;
+    if (latestSeq == sc->lastSeq) return false;
+    return sc->proto != STREAM_PROTO_WS || sc->credits > 0;
+}
+
+static void updateWindow(stream_client_t* sc)
+{
+    unsigned long elapsed = millis() - sc->windowStartMs;
+    if (elapsed < STREAM_FPS_WINDOW_MS) return;
+
+    client_stats_t* stats = &clientStats[sc->slot];
+    stats->fps = (uint16_t)(sc->windowFrames * 1000UL / elapsed);
+    stats->kbps = (uint32_t)(sc->windowBytes * 8 / elapsed);
+    if (sc->windowSkipped > 0)
+    {
+        Serial.printf("[STREAM] Client %s: %u fps, skipped %lu frames (slow receiver)\n",
+                      IPAddress(stats->ip).toString().c_str(), stats->fps, (unsigned long)sc->windowSkipped);
+    }
+    sc->windowFrames = 0;
+    sc->windowBytes = 0;
+    sc->windowSkipped = 0;
+    sc->windowStartMs = millis();
+}
+
+void streamMuxTask(void* pvParameters)
+{
+    bool wantWrite[MAX_CLIENTS];
+
+    // Chỉ thoát ở đầu vòng lặp: không client nào đang dở giữa 2 bước, scalesInFlight đúng
+    while (!stopRequested)
+    {
+        stream_client_t* incoming;
+        while (clientQueue != NULL && xQueueReceive(clientQueue, &incoming, 0) == pdTRUE)
+        {
+            incoming->proto = STREAM_PROTO_MJPEG;
+            incoming->rx = nullptr;
+            acceptClient(incoming);
+        }
+
+        bool progress = false;
+        stream_client_t* scaled;
+        while (xQueueReceive(scaleResults, &scaled, 0) == pdTRUE)
+        {
+            finishScaling(scaled);
+            progress = true;
+        }
+
+        fd_set rfds, wfds;
+        FD_ZERO(&rfds);
+        FD_ZERO(&wfds);
+        int maxFd = -1;
+        uint32_t latestSeq = frameRingLatestSeq;
+
+        if (wsListenFd >= 0)
+        {
+            FD_SET(wsListenFd, &rfds);
+            maxFd = wsListenFd;
+        }
+
+        for (int i = 0; i < MAX_CLIENTS; i++)
+        {
+            stream_client_t* sc = streamClients[i];
+            wantWrite[i] = false;
+            if (sc == nullptr || sc->state == STREAM_SCALING) continue;
+
+            FD_SET(sc->fd, &rfds);
+            if (clientWantsWrite(sc, latestSeq))
+            {
+                FD_SET(sc->fd, &wfds);
+                wantWrite[i] = true;
+            }
+            if (sc->fd > maxFd) maxFd = sc->fd;
+        }
+
+        if (maxFd < 0)
+        {
+            // Mọi client đều đang chờ PreviewScaler
+            vTaskDelay(pdMS_TO_TICKS(scalesInFlight > 0 ? STREAM_MUX_POLL_MS : STREAM_MUX_IDLE_MS));
+            continue;
+        }
+
+        // Không có client thì chỉ chờ kết nối WebSocket, client MJPEG đến qua queue
+        struct timeval tv = {0, (streamMuxStats.clients > 0 ? STREAM_MUX_POLL_MS : STREAM_MUX_IDLE_MS) * 1000};
+        int ready;
+        {
+            TRACE_SCOPE("stream_select");
+            ready = select(maxFd + 1, &rfds, &wfds, NULL, &tv);
+        }
+        streamMuxStats.selectCalls++;
+        if (ready < 0)
+        {
+            vTaskDelay(pdMS_TO_TICKS(STREAM_MUX_POLL_MS));
+            continue;
+        }
+
+        if (wsListenFd >= 0 && FD_ISSET(wsListenFd, &rfds)) acceptWsClient();
+
+        for (int i = 0; i < MAX_CLIENTS; i++)
+        {
+            stream_client_t* sc = streamClients[i];
+            if (sc == nullptr || sc->state == STREAM_SCALING) continue;
+
+            bool ok = true;
+            if (FD_ISSET(sc->fd, &rfds)) ok = drainInput(sc);
+
+            if (ok && sc->state == STREAM_WS_HANDSHAKE && millis() - sc->acceptedMs > WS_HANDSHAKE_TIMEOUT_MS) ok = false;
+
+            if (ok && wantWrite[i])
+            {
+                if (FD_ISSET(sc->fd, &wfds))
+                {
+                    size_t before = sc->sent;
+                    stream_state_t state = sc->state;
+                    if (sc->state == STREAM_IDLE && sc->pongPending)
+                    {
+                        ok = wsSendPong(sc);
+                        progress = true;
+                    }
+                    if (ok && sc->state == STREAM_IDLE && clientWantsWrite(sc, latestSeq)) startFrame(sc);
+                    if (ok && sc->state != STREAM_IDLE && sc->state != STREAM_SCALING)
+                    {
+                        TRACE_SCOPE("stream_send");
+                        ok = pumpClient(sc);
+                    }
+                    if (sc->sent != before || sc->state != state) progress = true;
+                }
+                else if (sc->state == STREAM_IDLE)
+                {
+                    clientStats[i].sendBlocked++;
+                }
+            }
+
+            if (!ok)
+            {
+                closeClient(sc);
+                continue;
+            }
+            updateWindow(sc);
+        }
+
+        // select báo ghi được nhưng không có gì để gửi (vd ring vừa reset), tránh quay vòng
+        if (ready > 0 && !progress) vTaskDelay(1);
+
+        uint32_t stackFree = uxTaskGetStackHighWaterMark(NULL);
+        if (streamMuxStats.stackFreeMin == 0 || stackFree < streamMuxStats.stackFreeMin) streamMuxStats.stackFreeMin = stackFree;
+    }
+
+    streamMuxHandle = NULL;
+    vTaskDelete(NULL);
+}
+
+bool startStreamMux()
+{
+    if (streamMuxHandle != NULL) return true;
+
+    if (scaleRequests == NULL) scaleRequests = xQueueCreate(MAX_CLIENTS, sizeof(stream_client_t*));
+    if (scaleResults == NULL) scaleResults = xQueueCreate(MAX_CLIENTS, sizeof(stream_client_t*));
+    if (scaleRequests == NULL || scaleResults == NULL)
+    {
+        Serial.println("[STREAM] ERROR: Failed to create scaler queues!");
+        return false;
+    }
+
+    if (scalerHandle == NULL)
+    {
+        // Ưu tiên thấp hơn StreamMux: thu nhỏ chỉ chạy khi mux đang chờ select()
+        BaseType_t scalerResult = xTaskCreatePinnedToCore(
+            previewScalerTask,
+            "PreviewScaler",
+            STREAM_SCALER_STACK,
+            NULL,
+            1,
+            &scalerHandle,
+            APP_CPU
+        );
+
+        if (scalerResult != pdPASS)
+        {
+            Serial.println("[STREAM] ERROR: Failed to create scaler task!");
+            scalerHandle = NULL;
+            return false;
+        }
+    }
+
+#if WS_STREAM_ENABLED
+    wsListenFd = wsListen();
+    if (wsListenFd < 0) Serial.println("[STREAM] ERROR: Cannot listen for WebSocket clients");
+    else Serial.printf("[STREAM] WebSocket: ws://%s:%d%s\n", WiFi.localIP().toString().c_str(), WS_PORT, WS_PATH);
+#endif
+
+    stopRequested = false;
+    BaseType_t result = xTaskCreatePinnedToCore(
+        streamMuxTask,
+        "StreamMux",
+        STREAM_MUX_STACK,
+        NULL,
+        3,
+        &streamMuxHandle,
+        APP_CPU
+    );
+
+    if (result != pdPASS)
+    {
+        Serial.println("[STREAM] ERROR: Failed to create mux task!");
+        streamMuxHandle = NULL;
+        return false;
+    }
+    return true;
+}
+
+void stopStreamMux()
+{
+    // Để StreamMux tự thoát thay vì vTaskDelete: không bị ngắt giữa lúc giữ slot hay gửi request
+    if (streamMuxHandle != NULL)
+    {
+        stopRequested = true;
+        while (streamMuxHandle != NULL) vTaskDelay(pdMS_TO_TICKS(STREAM_MUX_POLL_MS));
+    }
+
+    // Request PreviewScaler chưa nhận thì lấy lại; request đang xử lý thì chờ xong,
+    // PreviewScaler không còn giữ con trỏ nào tới client trước khi client bị giải phóng
+    stream_client_t* scaled;
+    while (scalesInFlight > 0 && xQueueReceive(scaleRequests, &scaled, 0) == pdTRUE)
+    {
+        scaled->state = STREAM_IDLE;
+        scalesInFlight--;
+    }
+    while (scalesInFlight > 0 && xQueueReceive(scaleResults, &scaled, portMAX_DELAY) == pdTRUE)
+    {
+        scaled->state = STREAM_IDLE;
+        scalesInFlight--;
+    }
+
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        if (streamClients[i] != nullptr) closeClient(streamClients[i]);
+    }
+
+    if (wsListenFd >= 0)
+    {
+        close(wsListenFd);
+        wsListenFd = -1;
+    }
+}
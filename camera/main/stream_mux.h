@@ -0,0 +1,87 @@
+#ifndef STREAM_MUX_H
+#define STREAM_MUX_H
+
+#include "config.h"
+#include "frame_ring.h"
+#include "jpeg_scaler.h"
+
+// Một task duy nhất phục vụ mọi client /stream qua socket non-blocking và select().
+// Mỗi client là 1 state machine: header multipart -> thân JPEG -> "\r\n" -> chờ frame mới.
+// Với STREAM_SEND_GATHER cả 3 phần đi chung 1 writev, state chỉ còn IDLE / BODY.
+// Client WebSocket (ws_stream) dùng chung state machine, header là header WS + metadata, không có trailer.
+// Client preview (scaleDiv > 1) được thu nhỏ ở task PreviewScaler, slot trả về ring ngay sau khi thu nhỏ.
+
+#define STREAM_MUX_POLL_MS      2       // chờ frame mới khi không socket nào cần ghi
+#define STREAM_MUX_IDLE_MS      20      // chưa có client nào
+#define STREAM_MUX_STACK        4096
+#define STREAM_SCALER_STACK     4096
+#define STREAM_PART_HEADER_MAX  96
+#define STREAM_SEND_SEGMENTS    4       // mỗi writev tối đa 4 * TCP_MSS
+
+typedef enum {
+    STREAM_PROTO_MJPEG,     // multipart/x-mixed-replace qua WebServer /stream
+    STREAM_PROTO_WS         // WebSocket /ws/stream, nhận trực tiếp trên WS_PORT
+} stream_proto_t;
+
+typedef enum {
+    STREAM_WS_HANDSHAKE,    // chờ request HTTP Upgrade
+    STREAM_IDLE,        // chờ frame mới
+    STREAM_SCALING,     // đang chờ PreviewScaler, mux không đụng vào client
+    STREAM_HEADER,
+    STREAM_BODY,
+    STREAM_TRAILER
+} stream_state_t;
+
+typedef struct {
+    WiFiClient client;
+    bool active;
+    int slot;           // index trong streamClients / clientStats
+    uint8_t scaleDiv;   // 1 = gốc, 2 / 4 / 8 = preview thu nhỏ (/stream?scale=1/2|1/4|1/8)
+
+    int fd;
+    stream_proto_t proto;
+    stream_state_t state;
+    frame_slot_t* frame;        // slot đang gửi, giữ 1 ref trong ring; nullptr khi gửi bản thu nhỏ
+    frame_slot_t info;          // bản sao descriptor của frame đang gửi (seq, thời điểm)
+    const uint8_t* data;        // slot->data hoặc scaler.out
+    size_t len;
+    size_t sent;                // bytes đã gửi của phần hiện tại (gather: của cả part)
+    char header[STREAM_PART_HEADER_MAX];    // MJPEG: tiền tố cố định chép sẵn khi nhận client; WS: header WS + metadata
+    size_t headerLen;
+    size_t trailerLen;          // "\r\n" cho MJPEG, 0 cho WebSocket
+    uint32_t lastSeq;
+    int64_t firstByteUs;
+
+    jpeg_scaler_t scaler;
+    bool scaled;
+
+    // chỉ dùng cho WebSocket
+    uint8_t* rx;                // request handshake / message từ client, cấp khi nhận client
+    size_t rxLen;
+    int16_t credits;            // số message còn được phép gửi
+    bool pongPending;
+    uint8_t pongLen;
+    uint8_t pong[125];
+    unsigned long acceptedMs;
+
+    uint32_t windowFrames;
+    uint64_t windowBytes;
+    uint32_t windowSkipped;
+    unsigned long windowStartMs;
+} stream_client_t;
+
+typedef struct {
+    uint8_t clients;
+    uint8_t maxClients;         // số client đồng thời lớn nhất từng phục vụ
+    uint32_t rejected;
+    uint32_t selectCalls;
+    uint32_t stackFreeMin;      // bytes
+} stream_mux_stats_t;
+
+extern stream_mux_stats_t streamMuxStats;
+
+bool startStreamMux();
+void stopStreamMux();
+void streamMuxTask(void* pvParameters);
+
+#endif
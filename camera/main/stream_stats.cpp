@@ -0,0 +1,201 @@
+#include "stream_stats.h"
+#include "camera_handler.h"
+#include "frame_ring.h"
+#include "jpeg_validator.h"
+#include "motion_detector.h"
+#include "event_buffer.h"
+#include "avi_recorder.h"
+#include "stream_mux.h"
+#include "rtsp_server.h"
+#include "mcast_stream.h"
+
+latency_hist_t captureToPublishHist;
+client_stats_t clientStats[MAX_CLIENTS];
+
+// Cận trên (us) của từng bucket, bucket cuối không giới hạn
+static const uint32_t bucketLimitUs[LATENCY_BUCKETS] = {
+    250, 500, 1000, 2000, 4000, 8000, 16000, 32000,
+    64000, 128000, 256000, 512000, 1024000, 2048000, UINT32_MAX
+};
+
+void latencyRecord(latency_hist_t* hist, uint32_t us)
+{
+    int b = 0;
+    while (b < LATENCY_BUCKETS - 1 && us > bucketLimitUs[b]) b++;
+
+    hist->buckets[b]++;
+    hist->count++;
+    hist->sumUs += us;
+    if (us > hist->maxUs) hist->maxUs = us;
+}
+
+// Ước lượng theo cận trên của bucket chứa phân vị
+uint32_t latencyPercentile(const latency_hist_t* hist, uint8_t pct)
+{
+    if (hist->count == 0) return 0;
+
+    uint32_t target = ((uint64_t)hist->count * pct + 99) / 100;
+    uint32_t seen = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++)
+    {
+        seen += hist->buckets[b];
+        if (seen >= target) return min(bucketLimitUs[b], hist->maxUs);
+    }
+    return hist->maxUs;
+}
+
+void latencyReset(latency_hist_t* hist)
+{
+    memset(hist, 0, sizeof(*hist));
+}
+
+void streamStatsClientBegin(int slot, uint32_t ip)
+{
+    if (slot < 0 || slot >= MAX_CLIENTS) return;
+
+    client_stats_t* st = &clientStats[slot];
+    memset(st, 0, sizeof(*st));
+    st->ip = ip;
+    st->active = true;
+}
+
+void streamStatsClientEnd(int slot)
+{
+    if (slot < 0 || slot >= MAX_CLIENTS) return;
+    clientStats[slot].active = false;
+}
+
+// Không đủ chỗ thì đặt pos = size, hàm gọi trả về 0 thay vì gửi JSON bị cắt
+static void appendf(char* buf, size_t size, size_t* pos, const char* fmt, ...)
+{
+    if (*pos >= size) return;
+
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf + *pos, size - *pos, fmt, args);
+    va_end(args);
+
+    if (n < 0 || *pos + (size_t)n >= size) *pos = size;
+    else *pos += n;
+}
+
+static size_t finishJson(char* buf, size_t size, size_t pos)
+{
+    if (pos < size) return pos;
+    if (size > 0) buf[0] = '\0';
+    return 0;
+}
+
+static void appendHist(char* buf, size_t size, size_t* pos, const char* name, const latency_hist_t* h)
+{
+    appendf(buf, size, pos, "\"%s\":{\"n\":%lu,\"p50\":%lu,\"p99\":%lu,\"max\":%lu}",
+            name, (unsigned long)h->count,
+            (unsigned long)latencyPercentile(h, 50),
+            (unsigned long)latencyPercentile(h, 99),
+            (unsigned long)h->maxUs);
+}
+
+static void appendSummary(char* buf, size_t size, size_t* pos)
+{
+    uint32_t jpegDropped = 0;
+    for (int i = 1; i < JPEG_CHECK_COUNT; i++) jpegDropped += jpegDropCount[i];
+
+    appendf(buf, size, pos, "{\"frames\":{\"recv\":%lu,\"sent\":%lu,\"ring_dropped\":%lu,\"jpeg_dropped\":%lu},",
+            (unsigned long)frame_cnt_recv, (unsigned long)frame_cnt_sent,
+            (unsigned long)frameRingDropped, (unsigned long)jpegDropped);
+
+    appendf(buf, size, pos, "\"latency_us\":{");
+    appendHist(buf, size, pos, "capture_publish", &captureToPublishHist);
+    appendf(buf, size, pos, "},\"motion\":{\"score\":%u,\"active\":%s,\"grid\":\"%012llx\",\"analyzed\":%lu,\"errors\":%lu,\"overruns\":%lu,\"analyze_us\":%lu,\"analyze_us_max\":%lu",
+            motionStats.score, motionVideoActive() ? "true" : "false",
+            (unsigned long long)motionStats.gridMask,
+            (unsigned long)motionStats.framesAnalyzed, (unsigned long)motionStats.decodeErrors,
+            (unsigned long)motionStats.budgetOverruns,
+            (unsigned long)motionStats.lastAnalyzeUs, (unsigned long)motionStats.maxAnalyzeUs);
+    appendf(buf, size, pos, "},\"event\":{\"recording\":%s,\"buffered\":%lu,\"dropped\":%lu,\"written\":%lu,\"clips\":%lu,\"write_errors\":%lu,\"block_write_us_max\":%lu",
+            eventBufferRecording() ? "true" : "false",
+            (unsigned long)eventStats.framesBuffered, (unsigned long)eventStats.framesDropped,
+            (unsigned long)eventStats.framesWritten, (unsigned long)eventStats.clipsWritten,
+            (unsigned long)eventStats.writeErrors, (unsigned long)eventStats.maxBlockWriteUs);
+    appendf(buf, size, pos, "},\"avi\":{\"recording\":%s,\"frames\":%lu,\"skipped\":%lu,\"files\":%lu,\"write_errors\":%lu,\"kb\":%lu,\"block_write_us\":%lu,\"block_write_us_max\":%lu",
+            aviRecorderActive() ? "true" : "false",
+            (unsigned long)aviStats.framesWritten, (unsigned long)aviStats.framesSkipped,
+            (unsigned long)aviStats.filesWritten, (unsigned long)aviStats.writeErrors,
+            (unsigned long)(aviStats.bytesWritten / 1024),
+            (unsigned long)aviStats.lastBlockWriteUs, (unsigned long)aviStats.maxBlockWriteUs);
+    appendf(buf, size, pos, "},\"mux\":{\"gather\":%s,\"clients\":%u,\"max_clients\":%u,\"limit\":%d,\"rejected\":%lu,\"stack_free_min\":%lu,\"heap_internal_free\":%u",
+            STREAM_SEND_GATHER ? "true" : "false",
+            streamMuxStats.clients, streamMuxStats.maxClients, MAX_CLIENTS,
+            (unsigned long)streamMuxStats.rejected, (unsigned long)streamMuxStats.stackFreeMin,
+            (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+    appendf(buf, size, pos, "},\"rtsp\":{\"sessions\":%u,\"playing\":%u,\"frames\":%lu,\"packets\":%lu,\"skipped\":%lu,\"unsupported\":%lu,\"send_errors\":%lu",
+            rtspStats.sessions, rtspStats.playing,
+            (unsigned long)rtspStats.framesSent, (unsigned long)rtspStats.packetsSent,
+            (unsigned long)rtspStats.framesSkipped, (unsigned long)rtspStats.unsupportedFrames,
+            (unsigned long)rtspStats.sendErrors);
+    appendf(buf, size, pos, "},\"mcast\":{\"group\":\"%s\",\"port\":%d,\"frames\":%lu,\"datagrams\":%lu,\"skipped\":%lu,\"send_errors\":%lu,\"leases\":%lu,\"lease_ms\":%lu",
+            MCAST_GROUP, MCAST_PORT,
+            (unsigned long)mcastStats.framesSent, (unsigned long)mcastStats.datagramsSent,
+            (unsigned long)mcastStats.framesSkipped, (unsigned long)mcastStats.sendErrors,
+            (unsigned long)mcastStats.leases, (unsigned long)mcastStreamLeaseRemainingMs());
+    appendf(buf, size, pos, "}");   // đóng mcast, object ngoài do hàm gọi đóng
+}
+
+static void appendClient(char* buf, size_t size, size_t* pos, int i)
+{
+    const client_stats_t* st = &clientStats[i];
+    float frames = st->framesSent ? (float)st->framesSent : 1.0f;
+
+    appendf(buf, size, pos, "{\"slot\":%d,\"ip\":\"%s\",\"ws\":%s,\"frames\":%lu,\"skipped\":%lu,\"blocked\":%lu,\"fps\":%u,\"kbps\":%lu,\"bytes\":%llu,",
+            i, IPAddress(st->ip).toString().c_str(), st->websocket ? "true" : "false",
+            (unsigned long)st->framesSent, (unsigned long)st->framesSkipped,
+            (unsigned long)st->sendBlocked, st->fps, (unsigned long)st->kbps,
+            (unsigned long long)st->bytesSent);
+    appendf(buf, size, pos, "\"calls_per_frame\":%.1f,\"segs_per_frame\":%.1f,",
+            st->sendCalls / frames, st->segments / frames);
+    appendHist(buf, size, pos, "publish_first_byte", &st->publishToFirstByte);
+    appendf(buf, size, pos, ",");
+    appendHist(buf, size, pos, "first_last_byte", &st->firstToLastByte);
+    appendf(buf, size, pos, ",");
+    appendHist(buf, size, pos, "capture_last_byte", &st->captureToLastByte);
+    appendf(buf, size, pos, "}");
+}
+
+// Toàn bộ /stats: tổng hợp + mảng clients. Trả về 0 nếu buffer không đủ.
+size_t streamStatsToJson(char* buf, size_t size)
+{
+    size_t pos = 0;
+    appendSummary(buf, size, &pos);
+    appendf(buf, size, &pos, ",\"clients\":[");
+
+    bool first = true;
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        if (!clientStats[i].active) continue;
+        if (!first) appendf(buf, size, &pos, ",");
+        appendClient(buf, size, &pos, i);
+        first = false;
+    }
+
+    appendf(buf, size, &pos, "]}");
+    return finishJson(buf, size, pos);
+}
+
+// Chỉ phần tổng hợp, kích thước không phụ thuộc số client
+size_t streamStatsSummaryToJson(char* buf, size_t size)
+{
+    size_t pos = 0;
+    appendSummary(buf, size, &pos);
+    appendf(buf, size, &pos, "}");
+    return finishJson(buf, size, pos);
+}
+
+// 1 client, trả về 0 nếu slot không hoạt động hoặc buffer không đủ
+size_t streamStatsClientToJson(int slot, char* buf, size_t size)
+{
+    if (slot < 0 || slot >= MAX_CLIENTS || !clientStats[slot].active) return 0;
+
+    size_t pos = 0;
+    appendClient(buf, size, &pos, slot);
+    return finishJson(buf, size, pos);
+}
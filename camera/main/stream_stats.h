@@ -0,0 +1,53 @@
+#ifndef STREAM_STATS_H
+#define STREAM_STATS_H
+
+#include "config.h"
+
+#define STREAM_FPS_WINDOW_MS 5000
+
+// Kích thước JSON lớn nhất khi mọi số đạt giá trị tối đa (tổng ~1.3 KB, mỗi client ~0.53 KB)
+#define STREAM_STATS_SUMMARY_JSON_MAX 1536
+#define STREAM_STATS_CLIENT_JSON_MAX  576
+#define STREAM_STATS_JSON_MAX (STREAM_STATS_SUMMARY_JSON_MAX + MAX_CLIENTS * (STREAM_STATS_CLIENT_JSON_MAX + 1) + 16)
+
+// Histogram cố định, bucket theo lũy thừa 2 từ 250us đến ~2s (bucket cuối = còn lại)
+#define LATENCY_BUCKETS 15
+
+typedef struct {
+    uint32_t count;
+    uint32_t maxUs;
+    uint64_t sumUs;
+    uint32_t buckets[LATENCY_BUCKETS];
+} latency_hist_t;
+
+typedef struct {
+    bool active;
+    bool websocket;
+    uint32_t ip;
+    uint32_t framesSent;
+    uint32_t framesSkipped;     // frame bị bỏ qua vì client nhận chậm
+    uint32_t sendBlocked;       // số lần socket chưa đủ chỗ trống để gửi frame mới
+    uint16_t fps;               // fps thực tế trong cửa sổ STREAM_FPS_WINDOW_MS gần nhất
+    uint32_t kbps;              // throughput trong cùng cửa sổ
+    uint32_t sendCalls;         // số lần gọi send/writev
+    uint32_t segments;          // ước lượng số TCP segment (mỗi lần gọi làm tròn lên theo MSS)
+    uint64_t bytesSent;
+    latency_hist_t publishToFirstByte;
+    latency_hist_t firstToLastByte;
+    latency_hist_t captureToLastByte;
+} client_stats_t;
+
+extern latency_hist_t captureToPublishHist;
+extern client_stats_t clientStats[MAX_CLIENTS];
+
+void latencyRecord(latency_hist_t* hist, uint32_t us);
+uint32_t latencyPercentile(const latency_hist_t* hist, uint8_t pct);
+void latencyReset(latency_hist_t* hist);
+
+void streamStatsClientBegin(int slot, uint32_t ip);
+void streamStatsClientEnd(int slot);
+size_t streamStatsToJson(char* buf, size_t size);
+size_t streamStatsSummaryToJson(char* buf, size_t size);
+size_t streamStatsClientToJson(int slot, char* buf, size_t size);
+
+#endif
@@ -0,0 +1,115 @@
+#include "trace.h"
+
+#if TRACE_ENABLED
+
+#include "web_server.h"
+
+static trace_event_t* traceRing[portNUM_PROCESSORS];
+static uint32_t traceHead[portNUM_PROCESSORS];     // internal RAM: atomic không dùng được trên PSRAM
+static volatile bool tracePaused = false;
+
+// Tên hiển thị cho các task đã biết, task khác hiện theo địa chỉ handle
+static const char* const knownTasks[] = {
+    "loopTask", "StreamMux", "RtspServer", "McastStream",
+    "MotionDetect", "EventBuffer", "AviRecorder", "SimAT", "MqttTask"
+};
+
+bool initializeTrace()
+{
+    for (int core = 0; core < portNUM_PROCESSORS; core++)
+    {
+        traceRing[core] = (trace_event_t*)heap_caps_calloc(TRACE_EVENTS_PER_CORE, sizeof(trace_event_t), MALLOC_CAP_SPIRAM);
+        if (traceRing[core] == nullptr)
+        {
+            Serial.println("[TRACE] ERROR: Failed to allocate ring");
+            return false;
+        }
+        traceHead[core] = 0;
+    }
+
+    Serial.printf("[TRACE] %d events/core, GET /trace\n", TRACE_EVENTS_PER_CORE);
+    return true;
+}
+
+// Nhiều task trên cùng core giành slot bằng fetch_add, không cần critical section
+void traceRecord(const char* name, int64_t startUs, int64_t endUs)
+{
+    int core = xPortGetCoreID();
+    if (tracePaused || traceRing[core] == nullptr) return;
+
+    uint32_t idx = __atomic_fetch_add(&traceHead[core], 1, __ATOMIC_RELAXED);
+    trace_event_t* e = &traceRing[core][idx & (TRACE_EVENTS_PER_CORE - 1)];
+    e->name = name;
+    e->task = xTaskGetCurrentTaskHandle();
+    e->startUs = startUs;
+    e->durUs = (uint32_t)(endUs - startUs);
+}
+
+void traceClear()
+{
+    tracePaused = true;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) traceHead[core] = 0;
+    tracePaused = false;
+}
+
+static void flush(char* buf, size_t* len)
+{
+    if (*len == 0) return;
+    server.sendContent(buf, *len);
+    *len = 0;
+}
+
+// Chrome trace-event JSON: pid = core, tid = task, mỗi span là 1 event "X" (begin + duration)
+void traceSendJson()
+{
+    char buf[1024];
+    size_t len = 0;
+
+    // Dừng ghi trong lúc xuất để không đọc event đang ghi dở
+    tracePaused = true;
+    vTaskDelay(1);
+
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.sendHeader("Content-Disposition", "attachment; filename=\"trace.json\"");
+    server.send(200, "application/json", "");
+
+    len += snprintf(buf + len, sizeof(buf) - len, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    bool first = true;
+
+    for (int core = 0; core < portNUM_PROCESSORS; core++)
+    {
+        len += snprintf(buf + len, sizeof(buf) - len, "%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"CPU%d\"}}",
+                        first ? "" : ",", core, core);
+        first = false;
+
+        for (size_t t = 0; t < sizeof(knownTasks) / sizeof(knownTasks[0]); t++)
+        {
+            TaskHandle_t task = xTaskGetHandle(knownTasks[t]);
+            if (task == nullptr) continue;
+            BaseType_t affinity = xTaskGetAffinity(task);
+            if (affinity != tskNO_AFFINITY && affinity != core) continue;
+            if (len > sizeof(buf) - 160) flush(buf, &len);
+            len += snprintf(buf + len, sizeof(buf) - len, ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%lu,\"args\":{\"name\":\"%s\"}}",
+                            core, (unsigned long)(uintptr_t)task, knownTasks[t]);
+        }
+
+        uint32_t head = traceHead[core];
+        uint32_t count = min(head, (uint32_t)TRACE_EVENTS_PER_CORE);
+        for (uint32_t i = head - count; i != head; i++)
+        {
+            const trace_event_t* e = &traceRing[core][i & (TRACE_EVENTS_PER_CORE - 1)];
+            if (e->name == nullptr) continue;
+            if (len > sizeof(buf) - 160) flush(buf, &len);
+            len += snprintf(buf + len, sizeof(buf) - len, ",{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%lu,\"ts\":%lld,\"dur\":%lu}",
+                            e->name, core, (unsigned long)(uintptr_t)e->task, (long long)e->startUs, (unsigned long)e->durUs);
+        }
+    }
+
+    len += snprintf(buf + len, sizeof(buf) - len, "]}");
+    flush(buf, &len);
+    server.sendContent("");
+
+    tracePaused = false;
+}
+
+#endif
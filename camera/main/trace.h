@@ -0,0 +1,47 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "config.h"
+
+// Trace timeline để tìm chỗ giật hình (USB, critical section, WiFi, loop() bị chặn).
+// Mỗi core 1 ring trong PSRAM, ghi không khóa; tải về qua GET /trace rồi mở bằng
+// chrome://tracing hoặc ui.perfetto.dev. Tắt hẳn khi TRACE_ENABLED = 0.
+
+#if TRACE_ENABLED
+
+#define TRACE_EVENTS_PER_CORE 4096      // lũy thừa 2, 24 byte/event
+
+typedef struct {
+    const char* name;       // chuỗi hằng, chỉ lưu con trỏ
+    TaskHandle_t task;
+    int64_t startUs;
+    uint32_t durUs;
+} trace_event_t;
+
+bool initializeTrace();
+void traceRecord(const char* name, int64_t startUs, int64_t endUs);
+void traceClear();
+void traceSendJson();
+
+// Ghi 1 span từ lúc khởi tạo tới khi ra khỏi scope
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : name(name), startUs(esp_timer_get_time()) {}
+    ~TraceScope() { traceRecord(name, startUs, esp_timer_get_time()); }
+
+private:
+    const char* name;
+    int64_t startUs;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(name)
+
+#else
+
+#define TRACE_SCOPE(name) do { } while (0)
+
+#endif
+
+#endif
@@ -6,21 +6,23 @@
 extern WebServer server;
 extern bool serverRunning;
 
-typedef struct {
-    WiFiClient client;
-    bool active;
-} stream_client_t;
-
+// Client mới được đẩy vào queue, streamMuxTask nhận và phục vụ
 extern QueueHandle_t clientQueue;
-extern TaskHandle_t streamTaskHandle[MAX_CLIENTS];
-
-extern void stream_task(void *pvParameters);
 
 void startMJPEGStreamingServer();
 void stopMJPEGStreamingServer();
 void handleWebServerLoop();
 
 void handle_stream();
+void handle_stats();
+void handle_record();
+void handle_metrics();
+#if TRACE_ENABLED
+void handle_trace();
+#endif
+#if MCAST_STREAM_ENABLED
+void handle_mcast();
+#endif
 
 void startAPWebServer();
 
@@ -28,8 +30,9 @@ void handleRootAP();
 void handleLoginAP();
 void handleScanAP();
 void handleStyleCSS();
+void handlePortalJS();
 void handleScanResults();
 
-String getErrorPage(String message);
+void sendErrorPage(int code, const char* message);
 
 #endif
\ No newline at end of file
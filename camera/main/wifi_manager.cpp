@@ -3,6 +3,9 @@
 #include "camera_handler.h"
 #include "blynk_handler.h"
 #include "audio_handler.h"
+#include "rtsp_server.h"
+#include "mcast_stream.h"
+#include "wifi_scan.h"
 
 extern WebServer server;
 extern bool serverRunning;
@@ -248,6 +251,9 @@ void startAPConfigPortal()
     WiFi.setSleep(false);
     startAPWebServer();
     wifiState = WIFI_AP_MODE;
+
+    // Quét sẵn để trang chọn WiFi có kết quả ngay khi admin đăng nhập
+    wifiScanRequest(false);
     
     Serial.printf("[AP] IP: %s\n", apIP.toString().c_str());
 }
@@ -257,6 +263,8 @@ void startAPConfigPortal()
 void handleWiFiLoop() 
 {
     static String lastProcessedSSID = "";
+    wifiScanPoll();
+
     if (connecting && connectingSSID.length() > 0 && connectingSSID != lastProcessedSSID)
     {
         lastProcessedSSID = connectingSSID; //avoid continuous loops
@@ -322,6 +330,18 @@ void initializeMDNS()
     {
         mdnsInitialized = true;
         MDNS.addService("http", "tcp", 80);
+#if RTSP_ENABLED
+        MDNS.addService("rtsp", "tcp", RTSP_PORT);
+#endif
+#if MCAST_STREAM_ENABLED
+        // Consumer duyệt _mjpeg-mcast._udp để biết nhóm và cổng cần join
+        MDNS.addService("mjpeg-mcast", "udp", MCAST_PORT);
+        MDNS.addServiceTxt("mjpeg-mcast", "udp", "group", MCAST_GROUP);
+        MDNS.addServiceTxt("mjpeg-mcast", "udp", "port", String(MCAST_PORT));
+        MDNS.addServiceTxt("mjpeg-mcast", "udp", "ver", String(MCAST_VERSION));
+        MDNS.addServiceTxt("mjpeg-mcast", "udp", "payload", String((unsigned)MCAST_PAYLOAD_MAX));
+        MDNS.addServiceTxt("mjpeg-mcast", "udp", "lease", "/mcast?lease=30");
+#endif
         
         Serial.println("[mDNS] Started successfully");
         Serial.printf("[mDNS] Stream: http://%s.local/stream\n", MDNS_HOSTNAME);
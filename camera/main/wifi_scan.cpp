@@ -0,0 +1,119 @@
+#include "wifi_scan.h"
+#include "wifi_manager.h"
+
+wifi_scan_cache_t wifiScanCache;
+
+static bool scanRunning = false;
+static unsigned long scanStartMs = 0;
+
+bool wifiScanRunning()
+{
+    return scanRunning;
+}
+
+// Bắt đầu quét nếu cache đã cũ; force = người dùng bấm "Scan Again"
+void wifiScanRequest(bool force)
+{
+    if (scanRunning || connecting) return;
+
+    unsigned long age = millis() - wifiScanCache.updatedMs;
+    if (wifiScanCache.valid && age < (force ? WIFI_SCAN_MIN_INTERVAL_MS : WIFI_SCAN_MAX_AGE_MS)) return;
+
+    // Quét cần interface STA, AP vẫn giữ kết nối với client
+    if (WiFi.getMode() != WIFI_AP_STA) WiFi.mode(WIFI_AP_STA);
+
+    if (WiFi.scanNetworks(true, true, false, WIFI_SCAN_MS_PER_CHANNEL) == WIFI_SCAN_FAILED)
+    {
+        Serial.println("[SCAN] ERROR: Failed to start scan");
+        return;
+    }
+
+    scanRunning = true;
+    scanStartMs = millis();
+}
+
+static void storeResults(int n)
+{
+    wifi_scan_cache_t* cache = &wifiScanCache;
+    cache->count = 0;
+
+    for (int i = 0; i < n; i++)
+    {
+        const wifi_ap_record_t* ap = (const wifi_ap_record_t*)WiFi.getScanInfoByIndex(i);
+        if (ap == nullptr || ap->ssid[0] == '\0') continue;
+
+        // Cùng SSID (mesh, nhiều AP) chỉ giữ bản RSSI cao nhất
+        int slot = -1;
+        for (int k = 0; k < cache->count; k++)
+        {
+            if (strcmp(cache->entries[k].ssid, (const char*)ap->ssid) == 0)
+            {
+                slot = k;
+                break;
+            }
+        }
+
+        if (slot >= 0)
+        {
+            if (ap->rssi <= cache->entries[slot].rssi) continue;
+        }
+        else if (cache->count < WIFI_SCAN_MAX_RESULTS)
+        {
+            slot = cache->count++;
+        }
+        else
+        {
+            // Đầy: thay AP yếu nhất nếu AP mới mạnh hơn
+            slot = 0;
+            for (int k = 1; k < cache->count; k++)
+                if (cache->entries[k].rssi < cache->entries[slot].rssi) slot = k;
+            if (ap->rssi <= cache->entries[slot].rssi) continue;
+        }
+
+        wifi_scan_entry_t* e = &cache->entries[slot];
+        strlcpy(e->ssid, (const char*)ap->ssid, sizeof(e->ssid));
+        e->rssi = ap->rssi;
+        e->authmode = ap->authmode;
+    }
+
+    // Insertion sort, tối đa WIFI_SCAN_MAX_RESULTS phần tử
+    for (int i = 1; i < cache->count; i++)
+    {
+        wifi_scan_entry_t e = cache->entries[i];
+        int k = i - 1;
+        while (k >= 0 && cache->entries[k].rssi < e.rssi)
+        {
+            cache->entries[k + 1] = cache->entries[k];
+            k--;
+        }
+        cache->entries[k + 1] = e;
+    }
+
+    cache->valid = true;
+    cache->updatedMs = millis();
+}
+
+// Gọi mỗi vòng loop: lấy kết quả khi quét xong, không chờ
+void wifiScanPoll()
+{
+    if (!scanRunning) return;
+
+    int n = WiFi.scanComplete();
+    if (n == WIFI_SCAN_RUNNING) return;
+
+    scanRunning = false;
+
+    if (n >= 0)
+    {
+        storeResults(n);
+        Serial.printf("[SCAN] %d APs, %u networks in %lu ms\n", n, wifiScanCache.count, millis() - scanStartMs);
+    }
+    else
+    {
+        Serial.println("[SCAN] ERROR: Scan failed");
+    }
+    WiFi.scanDelete();
+
+    // connectWiFiSTA() đã tự chuyển sang STA thì không đụng vào mode
+    if (wifiState == WIFI_AP_MODE && !connecting) WiFi.mode(WIFI_AP);
+}
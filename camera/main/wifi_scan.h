@@ -0,0 +1,33 @@
+#ifndef WIFI_SCAN_H
+#define WIFI_SCAN_H
+
+#include "config.h"
+
+// Quét WiFi nền (async) cho portal AP: handler HTTP chỉ đọc cache, không chặn handleClient().
+// Kết quả đã bỏ SSID trùng (giữ AP mạnh nhất) và sắp xếp theo RSSI giảm dần.
+
+#define WIFI_SCAN_MAX_RESULTS       20
+#define WIFI_SCAN_MAX_AGE_MS        30000   // cache cũ hơn thì quét lại khi có request
+#define WIFI_SCAN_MIN_INTERVAL_MS   5000    // "Scan Again" không quét dồn dập
+#define WIFI_SCAN_MS_PER_CHANNEL    300
+
+typedef struct {
+    char ssid[33];
+    int8_t rssi;
+    wifi_auth_mode_t authmode;
+} wifi_scan_entry_t;
+
+typedef struct {
+    wifi_scan_entry_t entries[WIFI_SCAN_MAX_RESULTS];
+    uint8_t count;
+    bool valid;                 // đã có ít nhất 1 lần quét xong
+    unsigned long updatedMs;
+} wifi_scan_cache_t;
+
+extern wifi_scan_cache_t wifiScanCache;
+
+void wifiScanRequest(bool force);
+void wifiScanPoll();
+bool wifiScanRunning();
+
+#endif
@@ -0,0 +1,192 @@
+#include "ws_stream.h"
+#include <lwip/sockets.h>
+#include <mbedtls/sha1.h>
+#include <mbedtls/base64.h>
+
+static const char wsGuid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+int wsListen()
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(WS_PORT);
+
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 2) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    return fd;
+}
+
+// Giá trị header HTTP (không phân biệt hoa thường), "" nếu không có
+static const char* headerValue(const char* req, const char* name, char* out, size_t outSize)
+{
+    size_t nameLen = strlen(name);
+    out[0] = '\0';
+
+    for (const char* line = strstr(req, "\r\n"); line != nullptr; line = strstr(line, "\r\n"))
+    {
+        line += 2;
+        if (strncasecmp(line, name, nameLen) != 0 || line[nameLen] != ':') continue;
+
+        const char* v = line + nameLen + 1;
+        while (*v == ' ') v++;
+        size_t n = 0;
+        while (v[n] && v[n] != '\r' && n < outSize - 1) n++;
+        memcpy(out, v, n);
+        out[n] = '\0';
+        break;
+    }
+    return out;
+}
+
+// Đọc request Upgrade trong sc->rx, trả 101 rồi chuyển client sang STREAM_IDLE; false = đóng
+bool wsHandshake(stream_client_t* sc)
+{
+    sc->rx[sc->rxLen] = '\0';
+    const char* req = (const char*)sc->rx;
+    if (strstr(req, "\r\n\r\n") == nullptr) return sc->rxLen < WS_RX_MAX;
+
+    char upgrade[16];
+    char key[40];
+    size_t pathLen = strlen(WS_PATH);
+    bool pathOk = strncmp(req, "GET " WS_PATH, 4 + pathLen) == 0 &&
+                  (req[4 + pathLen] == ' ' || req[4 + pathLen] == '?');
+
+    headerValue(req, "Upgrade", upgrade, sizeof(upgrade));
+    headerValue(req, "Sec-WebSocket-Key", key, sizeof(key));
+
+    if (!pathOk || strcasecmp(upgrade, "websocket") != 0 || key[0] == '\0')
+    {
+        const char* bad = "HTTP/1.1 400 Bad Request\r\nConnection: close\r\n\r\n";
+        send(sc->fd, bad, strlen(bad), 0);
+        return false;
+    }
+
+    // Sec-WebSocket-Accept = base64(sha1(key + GUID))
+    char buf[160];
+    snprintf(buf, sizeof(buf), "%s%s", key, wsGuid);
+    uint8_t sha[20];
+    mbedtls_sha1((const unsigned char*)buf, strlen(buf), sha);
+
+    unsigned char accept[32];
+    size_t acceptLen = 0;
+    mbedtls_base64_encode(accept, sizeof(accept) - 1, &acceptLen, sha, sizeof(sha));
+    accept[acceptLen] = '\0';
+
+    int n = snprintf(buf, sizeof(buf),
+                     "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                     "Sec-WebSocket-Accept: %s\r\n\r\n", accept);
+    if (send(sc->fd, buf, n, 0) != n) return false;
+
+    sc->rxLen = 0;
+    sc->credits = WS_INITIAL_CREDITS;
+    sc->state = STREAM_IDLE;
+    return true;
+}
+
+// Message từ client luôn có mask và chỉ là message điều khiển nhỏ (<= 125 byte)
+bool wsHandleInput(stream_client_t* sc)
+{
+    size_t pos = 0;
+
+    while (sc->rxLen - pos >= 2)
+    {
+        const uint8_t* f = sc->rx + pos;
+        uint8_t opcode = f[0] & 0x0F;
+        size_t plen = f[1] & 0x7F;
+        if (!(f[1] & 0x80) || plen > 125) return false;
+        if (sc->rxLen - pos < 6 + plen) break;
+
+        char msg[126];
+        for (size_t i = 0; i < plen; i++) msg[i] = f[6 + i] ^ f[2 + (i & 3)];
+        msg[plen] = '\0';
+
+        switch (opcode)
+        {
+        case 0x1:
+        case 0x2:
+        {
+            // Chỉ cộng số dương, cộng trong long rồi kẹp về 0..WS_MAX_CREDITS để không âm/tràn int16
+            long grant = 0;
+            if (strcmp(msg, "ack") == 0) grant = 1;
+            else if (strncmp(msg, "credit ", 7) == 0) grant = strtol(msg + 7, nullptr, 10);
+            if (grant > 0)
+            {
+                long total = (long)sc->credits + min(grant, (long)WS_MAX_CREDITS);
+                sc->credits = (int16_t)constrain(total, 0L, (long)WS_MAX_CREDITS);
+            }
+            break;
+        }
+
+        case 0x8:
+            return false;
+
+        case 0x9:
+            memcpy(sc->pong, msg, plen);
+            sc->pongLen = plen;
+            sc->pongPending = true;
+            break;
+
+        default:
+            break;
+        }
+        pos += 6 + plen;
+    }
+
+    sc->rxLen -= pos;
+    memmove(sc->rx, sc->rx + pos, sc->rxLen);
+    return sc->rxLen < WS_RX_MAX;
+}
+
+// Chỉ gọi giữa 2 message (STREAM_IDLE), control frame không được chen vào giữa message
+bool wsSendPong(stream_client_t* sc)
+{
+    uint8_t frame[2 + 125];
+    frame[0] = 0x8A;
+    frame[1] = sc->pongLen;
+    memcpy(frame + 2, sc->pong, sc->pongLen);
+    sc->pongPending = false;
+
+    int len = 2 + sc->pongLen;
+    return send(sc->fd, frame, len, MSG_DONTWAIT) == len;
+}
+
+size_t wsFrameHeader(uint8_t* out, const frame_slot_t* slot, size_t jpegLen)
+{
+    uint64_t payload = WS_META_SIZE + jpegLen;
+    size_t n = 0;
+
+    out[n++] = 0x82;                        // FIN + binary
+    if (payload < 126)
+    {
+        out[n++] = payload;
+    }
+    else if (payload < 65536)
+    {
+        out[n++] = 126;
+        out[n++] = payload >> 8;
+        out[n++] = payload;
+    }
+    else
+    {
+        out[n++] = 127;
+        for (int i = 7; i >= 0; i--) out[n++] = payload >> (i * 8);
+    }
+
+    for (int i = 3; i >= 0; i--) out[n++] = slot->seq >> (i * 8);
+    uint64_t captureUs = (uint64_t)slot->captureUs;
+    for (int i = 7; i >= 0; i--) out[n++] = captureUs >> (i * 8);
+    return n;
+}
@@ -0,0 +1,27 @@
+#ifndef WS_STREAM_H
+#define WS_STREAM_H
+
+#include "config.h"
+#include "stream_mux.h"
+
+// WebSocket (RFC 6455) cho dashboard: ws://cameraiuh.local:81/ws/stream
+// Nhận trên cổng riêng để WebServer không đọc mất message của client sau khi upgrade.
+// Mỗi frame JPEG là 1 binary message: [seq u32 BE][captureUs u64 BE][JPEG].
+// Flow control theo credit: mỗi message tiêu 1 credit, client gửi text "ack" (+1) hoặc "credit N" (+N).
+
+#define WS_PORT                 81
+#define WS_PATH                 "/ws/stream"
+#define WS_RX_MAX               768     // đủ cho request handshake của trình duyệt
+#define WS_INITIAL_CREDITS      2
+#define WS_MAX_CREDITS          16
+#define WS_HANDSHAKE_TIMEOUT_MS 5000
+#define WS_META_SIZE            12
+#define WS_HEADER_MAX           (10 + WS_META_SIZE)
+
+int wsListen();
+bool wsHandshake(stream_client_t* sc);
+bool wsHandleInput(stream_client_t* sc);
+bool wsSendPong(stream_client_t* sc);
+size_t wsFrameHeader(uint8_t* out, const frame_slot_t* slot, size_t jpegLen);
+
+#endif
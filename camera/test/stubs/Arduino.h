@@ -0,0 +1,132 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Shim tối thiểu để biên dịch các module thuần logic của camera/main trên Linux.
+// Thời gian là đồng hồ ảo: test tự đặt hostNowUs, không có gì chạy song song nên lock là no-op.
+// Task không bao giờ chạy: test gọi hàm poll của module thay cho vòng lặp của task.
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdarg>
+#include <cmath>
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+using std::min;
+using std::max;
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+inline int64_t hostNowUs = 0;
+
+inline int64_t esp_timer_get_time() { return hostNowUs; }
+inline unsigned long millis() { return (unsigned long)(hostNowUs / 1000); }
+inline unsigned long micros() { return (unsigned long)hostNowUs; }
+
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(m) ((void)(m))
+#define portEXIT_CRITICAL(m) ((void)(m))
+#define portENTER_CRITICAL_ISR(m) ((void)(m))
+#define portEXIT_CRITICAL_ISR(m) ((void)(m))
+
+typedef void* TaskHandle_t;
+typedef void* SemaphoreHandle_t;
+typedef void* QueueHandle_t;
+typedef int BaseType_t;
+typedef uint32_t TickType_t;
+#define pdPASS 1
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdMS_TO_TICKS(ms) (ms)
+#define portMAX_DELAY 0xffffffffu
+#define APP_CPU 1
+#define PRO_CPU 0
+inline void vTaskDelay(TickType_t) {}
+
+inline BaseType_t xTaskCreatePinnedToCore(void (*)(void*), const char*, uint32_t, void*, int, TaskHandle_t* handle, int)
+{
+    static int hostTask;
+    if (handle) *handle = &hostTask;
+    return pdPASS;
+}
+inline void xTaskNotifyGive(TaskHandle_t) {}
+inline uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) { return 0; }
+
+// Queue FIFO chép theo giá trị như FreeRTOS; đầy / rỗng thì trả về ngay (không ai khác lấy ra / đưa vào)
+struct HostQueue {
+    size_t itemSize;
+    size_t capacity;
+    std::deque<std::vector<uint8_t>> items;
+};
+
+inline QueueHandle_t xQueueCreate(size_t length, size_t itemSize) { return new HostQueue{itemSize, length, {}}; }
+inline void vQueueDelete(QueueHandle_t q) { delete (HostQueue*)q; }
+
+inline BaseType_t xQueueSend(QueueHandle_t handle, const void* item, TickType_t)
+{
+    HostQueue* q = (HostQueue*)handle;
+    if (q->items.size() >= q->capacity) return pdFALSE;
+    q->items.emplace_back((const uint8_t*)item, (const uint8_t*)item + q->itemSize);
+    return pdTRUE;
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t handle, void* item, TickType_t)
+{
+    HostQueue* q = (HostQueue*)handle;
+    if (q->items.empty()) return pdFALSE;
+    memcpy(item, q->items.front().data(), q->itemSize);
+    q->items.pop_front();
+    return pdTRUE;
+}
+
+inline size_t strlcpy(char* dst, const char* src, size_t size)
+{
+    size_t len = strlen(src);
+    if (size > 0)
+    {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+
+#define MALLOC_CAP_SPIRAM 1
+#define MALLOC_CAP_DMA 2
+#define MALLOC_CAP_INTERNAL 4
+#define MALLOC_CAP_8BIT 8
+inline void* heap_caps_malloc(size_t size, uint32_t) { return malloc(size); }
+inline void* heap_caps_aligned_alloc(size_t align, size_t size, uint32_t) { return aligned_alloc(align, (size + align - 1) / align * align); }
+inline void heap_caps_free(void* p) { free(p); }
+
+class HostEsp {
+public:
+    uint32_t getCycleCount() { return (uint32_t)(hostNowUs * 240); }
+    uint32_t getCpuFreqMHz() { return 240; }
+};
+inline HostEsp ESP;
+
+class HostSerial {
+public:
+    bool quiet = true;
+    int printf(const char* fmt, ...)
+    {
+        if (quiet) return 0;
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vprintf(fmt, ap);
+        va_end(ap);
+        return n;
+    }
+    void println(const char* s = "") { if (!quiet) puts(s); }
+    void print(const char* s) { if (!quiet) fputs(s, stdout); }
+};
+inline HostSerial Serial;
+
+#include "HardwareSerial.h"
+
+#endif
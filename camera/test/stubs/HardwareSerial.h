@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+
+// UART giả: test đẩy byte vào như modem gửi (hostReceive), đọc lại những gì firmware đã ghi (tx)
+class HardwareSerial {
+public:
+    std::string tx;
+
+    explicit HardwareSerial(int uart = 0) {}
+
+    void onReceive(void (*cb)()) { receiveCb = cb; }
+    int available() { return (int)(rx.size() - rxPos); }
+    int read() { return rxPos < rx.size() ? (uint8_t)rx[rxPos++] : -1; }
+    size_t print(const char* s) { tx += s; return strlen(s); }
+    size_t write(uint8_t c) { tx += (char)c; return 1; }
+
+    // Như task sự kiện UART: có dữ liệu mới thì gọi callback onReceive
+    void hostReceive(const char* s)
+    {
+        rx += s;
+        if (receiveCb) receiveCb();
+    }
+
+private:
+    void (*receiveCb)() = nullptr;
+    std::string rx;
+    size_t rxPos = 0;
+};
@@ -0,0 +1,9 @@
+#pragma once
+#include "Arduino.h"
+
+class USB_STREAM {};
+
+typedef struct {
+    uint8_t* data;
+    size_t data_bytes;
+} uvc_frame_t;
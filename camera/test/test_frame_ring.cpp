@@ -0,0 +1,186 @@
+// Frame ring + arena: 1 reader giữ frame cũ nhất không được làm nghẽn các frame mới
+#include "test_main.h"
+#include "frame_ring.h"
+#include "stream_stats.h"
+
+portMUX_TYPE frameMux = portMUX_INITIALIZER_UNLOCKED;
+latency_hist_t captureToPublishHist;
+void latencyRecord(latency_hist_t*, uint32_t) {}
+
+static uint8_t src[FRAME_ARENA_SIZE];
+
+static size_t pushFrame(uint32_t n, size_t len)
+{
+    memset(src, (uint8_t)n, len);
+    hostNowUs += 33000;
+    frameRingPush(src, len, hostNowUs);
+    return len;
+}
+
+static bool slotIntact(const frame_slot_t* slot, uint8_t fill)
+{
+    for (size_t i = 0; i < slot->len; i++)
+        if (slot->data[i] != fill) return false;
+    return true;
+}
+
+static void test_pinned_tail_does_not_block_pushes()
+{
+    frameRingReset();
+    frameRingDropped = 0;
+
+    pushFrame(1, 60000);
+    frame_slot_t* pinned = frameRingAcquire(0);
+    CHECK(pinned != nullptr);
+
+    // ~40 lần vòng arena 1.9 MB trong khi frame đầu tiên vẫn bị giữ
+    for (uint32_t n = 2; n < 1300; n++) pushFrame(n, 40000 + (n * 7919) % 40000);
+
+    CHECK_EQ(frameRingDropped, 0);
+    CHECK(slotIntact(pinned, 1));
+
+    // Các reader khác vẫn nhận được frame mới nhất
+    frame_slot_t* latest = frameRingAcquire(pinned->seq);
+    CHECK(latest != nullptr);
+    CHECK(latest != pinned);
+    CHECK(latest->seq == frameRingLatestSeq);
+    CHECK(slotIntact(latest, (uint8_t)1299));
+    frameRingRelease(latest);
+
+    frameRingRelease(pinned);
+}
+
+static void test_many_pinned_readers()
+{
+    frameRingReset();
+    frameRingDropped = 0;
+
+    // Mỗi reader giữ 1 frame ở các thời điểm khác nhau, rải khắp arena
+    frame_slot_t* held[FRAME_RING_READERS] = {};
+    uint8_t fill[FRAME_RING_READERS];
+    uint32_t n = 1;
+    for (int r = 0; r < FRAME_RING_READERS; r++)
+    {
+        for (int k = 0; k < 5; k++) pushFrame(n++, 70000);
+        held[r] = frameRingAcquire(0);
+        fill[r] = (uint8_t)(n - 1);
+        CHECK(held[r] != nullptr);
+    }
+
+    uint32_t before = frameRingDropped;
+    for (int k = 0; k < 500; k++) pushFrame(n++, 70000);
+    CHECK_EQ(frameRingDropped, before);
+
+    for (int r = 0; r < FRAME_RING_READERS; r++)
+    {
+        CHECK(slotIntact(held[r], fill[r]));
+        frameRingRelease(held[r]);
+    }
+}
+
+static void test_unpinned_history_kept_when_push_cannot_fit()
+{
+    frameRingReset();
+    frameRingDropped = 0;
+
+    // 3 frame bị giữ chiếm gần hết arena, chỗ trống còn lại nhỏ hơn frame mới
+    size_t third = frameArena.capacity / 3;
+    frame_slot_t* held[3];
+    for (int i = 0; i < 3; i++)
+    {
+        pushFrame(10 + i, third - 2 * FRAME_ARENA_ALIGN - 4096);
+        held[i] = frameRingAcquire(i == 0 ? 0 : held[i - 1]->seq);
+    }
+
+    // 1 frame nhỏ chưa bị giữ, là frame mới nhất
+    pushFrame(20, 1000);
+    uint32_t latestBefore = frameRingLatestSeq;
+
+    pushFrame(21, 20000);
+    CHECK_EQ(frameRingDropped, 1);
+    CHECK_EQ(frameRingLatestSeq, latestBefore);
+
+    frame_slot_t* latest = frameRingAcquire(held[2]->seq);
+    CHECK(latest != nullptr && latest->seq == latestBefore && slotIntact(latest, 20));
+    frameRingRelease(latest);
+
+    for (int i = 0; i < 3; i++) frameRingRelease(held[i]);
+    pushFrame(22, 20000);
+    CHECK_EQ(frameRingDropped, 1);
+}
+
+static void test_reset_keeps_held_frames()
+{
+    frameRingReset();
+    frameRingDropped = 0;
+
+    pushFrame(30, 50000);
+    frame_slot_t* held = frameRingAcquire(0);
+    CHECK(held != nullptr);
+
+    // stopStream() reset ring trong khi event buffer / AVI vẫn đang đọc
+    frameRingReset();
+    CHECK(frameRingAcquire(0) == nullptr);
+    CHECK_EQ(held->refcnt, 1);
+
+    for (uint32_t n = 31; n < 200; n++) pushFrame(n, 60000);
+    CHECK(slotIntact(held, 30));
+    CHECK_EQ(frameRingDropped, 0);
+
+    frame_slot_t* latest = frameRingAcquire(0);
+    CHECK(latest != nullptr && latest != held);
+    CHECK_EQ(latest->refcnt, 1);
+    frameRingRelease(latest);
+    frameRingRelease(held);
+    CHECK_EQ(held->refcnt, 0);
+    CHECK_EQ(latest->refcnt, 0);
+}
+
+static bool evictAll(const uint8_t*, void*) { return true; }
+static bool evictNone(const uint8_t*, void*) { return false; }
+
+static void test_arena_free_coalesces()
+{
+    frame_arena_t a;
+    CHECK(frameArenaInit(&a, 64 * 1024));
+
+    uint8_t* p[8];
+    for (int i = 0; i < 8; i++) p[i] = frameArenaAlloc(&a, 8000);
+    for (int i = 0; i < 8; i++) CHECK(p[i] != nullptr);
+    CHECK(frameArenaAlloc(&a, 8000) == nullptr);
+
+    // Giải phóng xen kẽ rồi lấp lại: các lỗ 2 block liền nhau phải gộp lại
+    frameArenaFree(&a, p[2]);
+    frameArenaFree(&a, p[4]);
+    CHECK(frameArenaAlloc(&a, 12000) == nullptr);
+    frameArenaFree(&a, p[3]);
+    uint8_t* big = frameArenaAlloc(&a, 20000);
+    CHECK(big == p[2]);
+
+    uint8_t* victims[8];
+    CHECK_EQ(frameArenaPlanEvict(&a, 40000, evictNone, nullptr, victims, 8), -1);
+    int n = frameArenaPlanEvict(&a, 26000, evictAll, nullptr, victims, 8);
+    CHECK_EQ(n, 2);
+
+    for (int i = 0; i < 8; i++) if (i < 2 || i > 4) frameArenaFree(&a, p[i]);
+    frameArenaFree(&a, big);
+    CHECK_EQ(a.live, 0);
+    CHECK_EQ(frameArenaLargestFree(&a), a.capacity);
+    free(a.base);
+}
+
+int main()
+{
+    if (!initializeFrameRing())
+    {
+        printf("FAIL cannot allocate arena\n");
+        return 1;
+    }
+
+    RUN_TEST(test_arena_free_coalesces);
+    RUN_TEST(test_pinned_tail_does_not_block_pushes);
+    RUN_TEST(test_many_pinned_readers);
+    RUN_TEST(test_unpinned_history_kept_when_push_cannot_fit);
+    RUN_TEST(test_reset_keeps_held_frames);
+    TEST_EXIT();
+}
@@ -0,0 +1,283 @@
+#ifndef TEST_JPEG_H
+#define TEST_JPEG_H
+
+// Tạo JPEG baseline hợp lệ từ hệ số ngẫu nhiên (bảng Huffman chuẩn) và giải mã lại tới mức hệ số
+
+#include "jpeg_decoder.h"
+#include <vector>
+
+typedef std::vector<uint8_t> bytes_t;
+
+static uint32_t rng = 1;
+
+static uint32_t nextRandom()
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+typedef struct {
+    uint16_t code[256];
+    uint8_t size[256];
+} huff_code_t;
+
+static void buildCodes(huff_code_t* t, const uint8_t bits[16], const uint8_t* vals)
+{
+    uint16_t code = 0;
+    int k = 0;
+    for (int len = 1; len <= 16; len++)
+    {
+        for (int i = 0; i < bits[len - 1]; i++, k++, code++)
+        {
+            t->code[vals[k]] = code;
+            t->size[vals[k]] = len;
+        }
+        code <<= 1;
+    }
+}
+
+typedef struct {
+    bytes_t* out;
+    uint32_t acc;
+    int bits;
+} bit_writer_t;
+
+static void putBits(bit_writer_t* w, uint32_t value, int n)
+{
+    for (int i = n - 1; i >= 0; i--)
+    {
+        w->acc = (w->acc << 1) | ((value >> i) & 1);
+        if (++w->bits == 8)
+        {
+            w->out->push_back((uint8_t)w->acc);
+            if ((uint8_t)w->acc == 0xFF) w->out->push_back(0x00);
+            w->acc = 0;
+            w->bits = 0;
+        }
+    }
+}
+
+static void flushBits(bit_writer_t* w)
+{
+    if (w->bits) putBits(w, 0x7F, 8 - w->bits);
+}
+
+static int category(int v)
+{
+    int s = 0;
+    for (int a = v < 0 ? -v : v; a; a >>= 1) s++;
+    return s;
+}
+
+static void putValue(bit_writer_t* w, const huff_code_t* t, int symbol, int v, int s)
+{
+    putBits(w, t->code[symbol], t->size[symbol]);
+    if (s) putBits(w, v < 0 ? v + (1 << s) - 1 : v, s);
+}
+
+static void encodeBlock(bit_writer_t* w, const int16_t coef[64], int* pred, const huff_code_t* dc, const huff_code_t* ac)
+{
+    int diff = coef[0] - *pred;
+    *pred = coef[0];
+    int s = category(diff);
+    putValue(w, dc, s, diff, s);
+
+    int run = 0;
+    for (int k = 1; k < 64; k++)
+    {
+        if (coef[k] == 0)
+        {
+            run++;
+            continue;
+        }
+        for (; run > 15; run -= 16) putBits(w, ac->code[0xF0], ac->size[0xF0]);
+        s = category(coef[k]);
+        putValue(w, ac, (run << 4) | s, coef[k], s);
+        run = 0;
+    }
+    if (run) putBits(w, ac->code[0x00], ac->size[0x00]);
+}
+
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    uint8_t sampling;           // h/v của Y: 0x21 = 4:2:2, 0x22 = 4:2:0, 0x11 = 4:4:4
+    uint16_t restartInterval;
+    uint8_t sof;                // 0xC0 baseline, 0xC2 progressive
+    bool dqtPerSegment;         // mỗi bảng 1 segment DQT thay vì chung 1 segment
+    bool withDht;
+} jpeg_spec_t;
+
+typedef struct {
+    bytes_t data;
+    uint8_t qt[2][64];
+    size_t scanStart;
+    size_t scanLen;
+    std::vector<int16_t> coefs;  // theo thứ tự giải mã: MCU, component, block
+} test_jpeg_t;
+
+static void putU16(bytes_t* b, uint16_t v)
+{
+    b->push_back(v >> 8);
+    b->push_back(v & 0xFF);
+}
+
+static void putSegment(bytes_t* b, uint8_t marker, const bytes_t& body)
+{
+    b->push_back(0xFF);
+    b->push_back(marker);
+    putU16(b, body.size() + 2);
+    b->insert(b->end(), body.begin(), body.end());
+}
+
+static void putDht(bytes_t* body, uint8_t tcth, const uint8_t bits[16], const uint8_t* vals)
+{
+    int total = 0;
+    body->push_back(tcth);
+    for (int i = 0; i < 16; i++)
+    {
+        body->push_back(bits[i]);
+        total += bits[i];
+    }
+    body->insert(body->end(), vals, vals + total);
+}
+
+static bytes_t makeHeaders(uint16_t width, uint16_t height, uint8_t sampling, uint16_t restartInterval,
+                           const uint8_t qt[2][64], uint8_t sof, bool dqtPerSegment, bool withDht)
+{
+    bytes_t b = {0xFF, 0xD8};
+    bytes_t body;
+
+    if (dqtPerSegment)
+    {
+        for (int t = 0; t < 2; t++)
+        {
+            body.assign(1, t);
+            body.insert(body.end(), qt[t], qt[t] + 64);
+            putSegment(&b, 0xDB, body);
+        }
+    }
+    else
+    {
+        body.clear();
+        for (int t = 0; t < 2; t++)
+        {
+            body.push_back(t);
+            body.insert(body.end(), qt[t], qt[t] + 64);
+        }
+        putSegment(&b, 0xDB, body);
+    }
+
+    if (restartInterval)
+    {
+        body.clear();
+        putU16(&body, restartInterval);
+        putSegment(&b, 0xDD, body);
+    }
+
+    body = {8};
+    putU16(&body, height);
+    putU16(&body, width);
+    body.insert(body.end(), {3, 1, sampling, 0, 2, 0x11, 1, 3, 0x11, 1});
+    putSegment(&b, sof, body);
+
+    if (withDht)
+    {
+        body.clear();
+        putDht(&body, 0x00, jpegStdDcLumBits, jpegStdDcLumVals);
+        putDht(&body, 0x10, jpegStdAcLumBits, jpegStdAcLumVals);
+        putDht(&body, 0x01, jpegStdDcChromBits, jpegStdDcChromVals);
+        putDht(&body, 0x11, jpegStdAcChromBits, jpegStdAcChromVals);
+        putSegment(&b, 0xC4, body);
+    }
+
+    body = {3, 1, 0x00, 2, 0x11, 3, 0x11, 0, 63, 0};
+    putSegment(&b, 0xDA, body);
+    return b;
+}
+
+static void makeJpeg(const jpeg_spec_t& spec, test_jpeg_t* jpg)
+{
+    for (int t = 0; t < 2; t++)
+        for (int i = 0; i < 64; i++) jpg->qt[t][i] = 1 + nextRandom() % 255;
+
+    jpg->data = makeHeaders(spec.width, spec.height, spec.sampling, spec.restartInterval, jpg->qt, spec.sof,
+                            spec.dqtPerSegment, spec.withDht);
+    // APP0 sau SOI như camera UVC thật
+    bytes_t app0 = {0xFF, 0xE0, 0x00, 0x07, 'J', 'F', 'I', 'F', 0};
+    jpg->data.insert(jpg->data.begin() + 2, app0.begin(), app0.end());
+    jpg->scanStart = jpg->data.size();
+
+    huff_code_t dc[2], ac[2];
+    buildCodes(&dc[0], jpegStdDcLumBits, jpegStdDcLumVals);
+    buildCodes(&ac[0], jpegStdAcLumBits, jpegStdAcLumVals);
+    buildCodes(&dc[1], jpegStdDcChromBits, jpegStdDcChromVals);
+    buildCodes(&ac[1], jpegStdAcChromBits, jpegStdAcChromVals);
+
+    int h = spec.sampling >> 4, v = spec.sampling & 0x0F;
+    int mcus = ((spec.width + 8 * h - 1) / (8 * h)) * ((spec.height + 8 * v - 1) / (8 * v));
+    int pred[3] = {0, 0, 0};
+    bit_writer_t w = {&jpg->data, 0, 0};
+    jpg->coefs.clear();
+
+    for (int m = 0; m < mcus; m++)
+    {
+        if (spec.restartInterval && m > 0 && m % spec.restartInterval == 0)
+        {
+            flushBits(&w);
+            jpg->data.push_back(0xFF);
+            jpg->data.push_back(0xD0 + (m / spec.restartInterval - 1) % 8);
+            pred[0] = pred[1] = pred[2] = 0;
+        }
+
+        for (int c = 0; c < 3; c++)
+        {
+            int blocks = c == 0 ? h * v : 1;
+            for (int b = 0; b < blocks; b++)
+            {
+                int16_t coef[64] = {};
+                coef[0] = (int16_t)(nextRandom() % 1001) - 500;
+                for (int n = nextRandom() % 12; n > 0; n--)
+                {
+                    int k = 1 + nextRandom() % 63;
+                    coef[k] = (int16_t)(nextRandom() % 401) - 200;
+                }
+                encodeBlock(&w, coef, &pred[c], &dc[c ? 1 : 0], &ac[c ? 1 : 0]);
+                jpg->coefs.insert(jpg->coefs.end(), coef, coef + 64);
+            }
+        }
+    }
+    flushBits(&w);
+
+    jpg->scanLen = jpg->data.size() - jpg->scanStart;
+    jpg->data.push_back(0xFF);
+    jpg->data.push_back(0xD9);
+}
+
+// Hệ số của mọi block theo thứ tự MCU, false nếu decoder không đọc hết được
+static bool decodeAll(const bytes_t& data, std::vector<int16_t>* coefs, uint16_t qt[2][64])
+{
+    static jpeg_decoder_t dec;
+    if (!jpegDecoderBegin(&dec, data.data(), data.size())) return false;
+
+    coefs->clear();
+    for (int m = 0; m < dec.mcusX * dec.mcusY; m++)
+    {
+        if (!jpegDecoderStartMcu(&dec)) return false;
+        for (int c = 0; c < dec.numComps; c++)
+        {
+            for (int b = 0; b < dec.comps[c].h * dec.comps[c].v; b++)
+            {
+                int16_t coef[64];
+                if (!jpegDecodeBlock(&dec, c, coef, false)) return false;
+                coefs->insert(coefs->end(), coef, coef + 64);
+            }
+        }
+    }
+    for (int t = 0; t < 2; t++) memcpy(qt[t], dec.qt[dec.comps[t].tq], sizeof(qt[t]));
+    return true;
+}
+
+#endif
@@ -0,0 +1,248 @@
+// Scaler miền DCT: so hệ số đầu ra với cách làm qua pixel (IDCT rút gọn từng block gốc rồi DCT 8x8)
+#include "test_main.h"
+#include "jpeg_scaler.h"
+#include "test_jpeg.h"
+
+static const double PI = 3.14159265358979323846;
+
+static inline double dctScale(int u)
+{
+    return u == 0 ? 0.70710678118654752 : 1.0;
+}
+
+// Hệ số mong đợi theo thứ tự giải mã của frame đầu ra, lượng tử bằng bảng của chính frame đó
+static void referenceScale(const jpeg_spec_t& spec, const test_jpeg_t& src, int s, const uint16_t outQt[2][64],
+                           std::vector<int16_t>* expect)
+{
+    int h = spec.sampling >> 4, v = spec.sampling & 0x0F;
+    int mcusX = (spec.width + 8 * h - 1) / (8 * h);
+    int mcusY = (spec.height + 8 * v - 1) / (8 * v);
+    int k = 8 / s;
+
+    // Chỉ số block gốc theo từng component
+    std::vector<const int16_t*> grid[3];
+    int gridW[3] = {mcusX * h, mcusX, mcusX};
+    int gridH[3] = {mcusY * v, mcusY, mcusY};
+    for (int c = 0; c < 3; c++) grid[c].resize(gridW[c] * gridH[c]);
+
+    const int16_t* p = src.coefs.data();
+    for (int my = 0; my < mcusY; my++)
+        for (int mx = 0; mx < mcusX; mx++)
+            for (int c = 0; c < 3; c++)
+            {
+                int ch = c ? 1 : h, cv = c ? 1 : v;
+                for (int by = 0; by < cv; by++)
+                    for (int bx = 0; bx < ch; bx++, p += 64)
+                        grid[c][(my * cv + by) * gridW[c] + mx * ch + bx] = p;
+            }
+
+    int outW = (spec.width + s - 1) / s, outH = (spec.height + s - 1) / s;
+    int outMcusX = (outW + 8 * h - 1) / (8 * h);
+    int outMcusY = (outH + 8 * v - 1) / (8 * v);
+
+    expect->clear();
+    for (int my = 0; my < outMcusY; my++)
+        for (int mx = 0; mx < outMcusX; mx++)
+            for (int c = 0; c < 3; c++)
+            {
+                int ch = c ? 1 : h, cv = c ? 1 : v;
+                for (int by = 0; by < cv; by++)
+                    for (int bx = 0; bx < ch; bx++)
+                    {
+                        int ox = mx * ch + bx, oy = my * cv + by;
+                        double px[8][8];
+
+                        for (int bv = 0; bv < s; bv++)
+                            for (int bh = 0; bh < s; bh++)
+                            {
+                                int ix = min(ox * s + bh, gridW[c] - 1);
+                                int iy = min(oy * s + bv, gridH[c] - 1);
+                                const int16_t* coef = grid[c][iy * gridW[c] + ix];
+
+                                double F[8][8] = {};
+                                for (int i = 0; i < 64; i++)
+                                    F[jpegZigzag[i] >> 3][jpegZigzag[i] & 7] = coef[i] * (double)src.qt[c ? 1 : 0][i];
+
+                                for (int y = 0; y < k; y++)
+                                    for (int x = 0; x < k; x++)
+                                    {
+                                        double sum = 0;
+                                        for (int fv = 0; fv < k; fv++)
+                                            for (int fu = 0; fu < k; fu++)
+                                                sum += 0.25 * dctScale(fu) * dctScale(fv) * F[fv][fu]
+                                                     * cos((2 * x + 1) * fu * PI / (2 * k))
+                                                     * cos((2 * y + 1) * fv * PI / (2 * k));
+                                        px[bv * k + y][bh * k + x] = sum;
+                                    }
+                            }
+
+                        for (int i = 0; i < 64; i++)
+                        {
+                            int U = jpegZigzag[i] & 7, V = jpegZigzag[i] >> 3;
+                            double sum = 0;
+                            for (int y = 0; y < 8; y++)
+                                for (int x = 0; x < 8; x++)
+                                    sum += px[y][x] * cos((2 * x + 1) * U * PI / 16) * cos((2 * y + 1) * V * PI / 16);
+                            sum *= 0.25 * dctScale(U) * dctScale(V);
+                            long q = lround(sum / outQt[c ? 1 : 0][i]);
+                            expect->push_back((int16_t)constrain(q, -1023L, 1023L));
+                        }
+                    }
+            }
+}
+
+static void checkScale(const jpeg_spec_t& spec, int s)
+{
+    test_jpeg_t src;
+    makeJpeg(spec, &src);
+
+    jpeg_scaler_t scaler;
+    CHECK(jpegScalerInit(&scaler, s));
+    CHECK(jpegScaleFrame(&scaler, src.data.data(), src.data.size()));
+    CHECK(scaler.outLen > 0);
+
+    bytes_t out(scaler.out, scaler.out + scaler.outLen);
+    jpegScalerFree(&scaler);
+
+    static jpeg_decoder_t dec;
+    CHECK(jpegDecoderBegin(&dec, out.data(), out.size()));
+    CHECK_EQ(dec.width, (spec.width + s - 1) / s);
+    CHECK_EQ(dec.height, (spec.height + s - 1) / s);
+    CHECK_EQ(dec.comps[0].h << 4 | dec.comps[0].v, spec.sampling);
+    CHECK_EQ(dec.restartInterval, 0);
+
+    std::vector<int16_t> got;
+    uint16_t outQt[2][64];
+    CHECK(decodeAll(out, &got, outQt));
+
+    std::vector<int16_t> expect;
+    referenceScale(spec, src, s, outQt, &expect);
+    CHECK_EQ(got.size(), expect.size());
+    if (got.size() != expect.size()) return;
+
+    // Chỉ chấp nhận lệch 1 bước lượng tử do làm tròn float
+    size_t off = 0, maxDiff = 0;
+    for (size_t i = 0; i < got.size(); i++)
+    {
+        size_t d = abs(got[i] - expect[i]);
+        if (d) off++;
+        maxDiff = max(maxDiff, d);
+    }
+    CHECK(maxDiff <= 1);
+    CHECK(off * 100 < got.size());
+}
+
+static void test_half_420()
+{
+    checkScale({320, 240, 0x22, 0, 0xC0, false, false}, 2);
+}
+
+static void test_half_422_restart()
+{
+    checkScale({176, 144, 0x21, 5, 0xC0, false, true}, 2);
+}
+
+static void test_quarter_422_unaligned()
+{
+    // 200 / 4 = 50 không chia hết cho MCU 16: block đầu ra bên phải lấy lại block gốc cuối hàng
+    checkScale({200, 150, 0x21, 0, 0xC0, false, false}, 4);
+}
+
+static void test_quarter_420()
+{
+    checkScale({320, 240, 0x22, 0, 0xC0, true, false}, 4);
+}
+
+static void test_eighth_dc_only()
+{
+    checkScale({320, 240, 0x22, 0, 0xC0, false, false}, 8);
+    checkScale({200, 150, 0x21, 3, 0xC0, false, false}, 8);
+}
+
+static void test_flat_frame_stays_flat()
+{
+    // Frame chỉ có DC giống nhau: đầu ra cũng chỉ có DC, cùng độ sáng
+    jpeg_spec_t spec = {320, 240, 0x22, 0, 0xC0, false, false};
+    test_jpeg_t src;
+    makeJpeg(spec, &src);
+
+    for (size_t b = 0; b < src.coefs.size(); b += 64)
+    {
+        bool luma = (b / 64) % 6 < 4;
+        memset(&src.coefs[b], 0, 64 * sizeof(int16_t));
+        src.coefs[b] = luma ? 40 : -12;
+    }
+    src.data = makeHeaders(spec.width, spec.height, spec.sampling, 0, src.qt, 0xC0, false, false);
+    {
+        huff_code_t dc[2], ac[2];
+        buildCodes(&dc[0], jpegStdDcLumBits, jpegStdDcLumVals);
+        buildCodes(&ac[0], jpegStdAcLumBits, jpegStdAcLumVals);
+        buildCodes(&dc[1], jpegStdDcChromBits, jpegStdDcChromVals);
+        buildCodes(&ac[1], jpegStdAcChromBits, jpegStdAcChromVals);
+        bit_writer_t w = {&src.data, 0, 0};
+        int pred[3] = {0, 0, 0};
+        for (size_t b = 0; b < src.coefs.size(); b += 64)
+        {
+            int c = (b / 64) % 6 < 4 ? 0 : 1 + ((b / 64) % 6 == 5);
+            encodeBlock(&w, &src.coefs[b], &pred[c], &dc[c ? 1 : 0], &ac[c ? 1 : 0]);
+        }
+        flushBits(&w);
+        src.data.push_back(0xFF);
+        src.data.push_back(0xD9);
+    }
+
+    for (int s = 2; s <= 8; s *= 2)
+    {
+        jpeg_scaler_t scaler;
+        CHECK(jpegScalerInit(&scaler, s));
+        CHECK(jpegScaleFrame(&scaler, src.data.data(), src.data.size()));
+        bytes_t out(scaler.out, scaler.out + scaler.outLen);
+        jpegScalerFree(&scaler);
+
+        std::vector<int16_t> got;
+        uint16_t outQt[2][64];
+        CHECK(decodeAll(out, &got, outQt));
+        if (got.empty()) continue;
+
+        // Giá trị pixel trung bình = DC * q / 8 phải giữ nguyên
+        for (size_t b = 0; b < got.size(); b += 64)
+        {
+            bool luma = (b / 64) % 6 < 4;
+            double srcMean = (luma ? 40 : -12) * (double)src.qt[luma ? 0 : 1][0] / 8;
+            double outMean = got[b] * (double)outQt[luma ? 0 : 1][0] / 8;
+            CHECK(fabs(outMean - srcMean) <= outQt[luma ? 0 : 1][0] / 16.0 + 1e-9);
+            for (int i = 1; i < 64; i++) CHECK_EQ(got[b + i], 0);
+        }
+    }
+}
+
+static void test_rejects_bad_input()
+{
+    jpeg_scaler_t scaler;
+    CHECK(!jpegScalerInit(&scaler, 3));
+
+    test_jpeg_t src;
+    makeJpeg({320, 240, 0x22, 0, 0xC2, false, false}, &src);    // progressive
+    CHECK(jpegScalerInit(&scaler, 2));
+    CHECK(!jpegScaleFrame(&scaler, src.data.data(), src.data.size()));
+    CHECK_EQ(scaler.outLen, 0);
+
+    // Đầu ra không vừa buffer thì báo lỗi, không trả frame bị cắt
+    makeJpeg({320, 240, 0x22, 0, 0xC0, false, false}, &src);
+    scaler.outCap = 600;
+    CHECK(!jpegScaleFrame(&scaler, src.data.data(), src.data.size()));
+    CHECK_EQ(scaler.outLen, 0);
+    jpegScalerFree(&scaler);
+}
+
+int main()
+{
+    RUN_TEST(test_half_420);
+    RUN_TEST(test_half_422_restart);
+    RUN_TEST(test_quarter_422_unaligned);
+    RUN_TEST(test_quarter_420);
+    RUN_TEST(test_eighth_dc_only);
+    RUN_TEST(test_flat_frame_stays_flat);
+    RUN_TEST(test_rejects_bad_input);
+    TEST_EXIT();
+}
@@ -0,0 +1,36 @@
+#ifndef TEST_MAIN_H
+#define TEST_MAIN_H
+
+// Khung test tối giản cho các test chạy trên host (make -C camera/test test)
+
+#include <cstdio>
+
+inline int testFailures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            testFailures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(a, b) \
+    do { \
+        long long va_ = (long long)(a), vb_ = (long long)(b); \
+        if (va_ != vb_) { \
+            printf("  FAIL %s:%d: %s == %s (%lld != %lld)\n", __FILE__, __LINE__, #a, #b, va_, vb_); \
+            testFailures++; \
+        } \
+    } while (0)
+
+#define RUN_TEST(fn) \
+    do { \
+        int before_ = testFailures; \
+        fn(); \
+        printf("%s %s\n", testFailures == before_ ? "PASS" : "FAIL", #fn); \
+    } while (0)
+
+#define TEST_EXIT() return testFailures == 0 ? 0 : 1
+
+#endif
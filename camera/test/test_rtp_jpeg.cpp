@@ -0,0 +1,244 @@
+// RTP/JPEG (RFC 2435): đóng gói frame, tách gói như phía nhận rồi so với frame gốc
+#include "test_main.h"
+#include "rtp_jpeg.h"
+#include "rtsp_server.h"
+#include "test_jpeg.h"
+
+// ---------- Phía nhận: tách gói RTP và dựng lại JPEG như RFC 2435 Appendix B ----------
+
+static const uint32_t SSRC = 0x12345678;
+static const uint32_t TIMESTAMP = 0xCAFEF00D;
+static const uint16_t FIRST_SEQ = 0xFFFE;     // kiểm tra seq quay vòng
+
+typedef struct {
+    std::vector<bytes_t> packets;
+    uint16_t seq;
+    bool stopAfterFirst;
+} capture_t;
+
+static bool capturePacket(uint8_t* header, size_t headerLen, const uint8_t* payload, size_t payloadLen,
+                          bool last, void* ctx)
+{
+    capture_t* cap = (capture_t*)ctx;
+    rtpWriteHeader(header, last, cap->seq++, TIMESTAMP, SSRC);
+
+    bytes_t pkt(header, header + headerLen);
+    pkt.insert(pkt.end(), payload, payload + payloadLen);
+    cap->packets.push_back(pkt);
+    return !cap->stopAfterFirst;
+}
+
+static inline uint32_t readU24(const uint8_t* p)
+{
+    return ((uint32_t)p[0] << 16) | (p[1] << 8) | p[2];
+}
+
+static inline uint32_t readU32(const uint8_t* p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+// Kiểm tra từng gói, ghép dữ liệu entropy theo fragment offset và dựng lại JPEG hoàn chỉnh
+static bool depacketize(const capture_t& cap, bytes_t* jpeg, uint8_t qt[2][64], uint8_t* type)
+{
+    bytes_t scan;
+    uint16_t width = 0, height = 0, dri = 0;
+    int before = testFailures;
+
+    for (size_t i = 0; i < cap.packets.size(); i++)
+    {
+        const bytes_t& pkt = cap.packets[i];
+        bool last = i + 1 == cap.packets.size();
+        CHECK(pkt.size() > RTP_HEADER_SIZE + RTP_JPEG_HEADER_SIZE);
+        CHECK(pkt.size() - RTP_HEADER_SIZE <= RTP_MAX_PAYLOAD);
+
+        const uint8_t* p = pkt.data();
+        CHECK_EQ(p[0], 0x80);                               // V = 2, không padding/extension/CSRC
+        CHECK_EQ(p[1] & 0x7F, RTP_PT_JPEG);
+        CHECK_EQ(p[1] >> 7, last ? 1 : 0);                  // marker chỉ ở gói cuối
+        CHECK_EQ((p[2] << 8) | p[3], (uint16_t)(FIRST_SEQ + i));
+        CHECK_EQ(readU32(p + 4), TIMESTAMP);
+        CHECK_EQ(readU32(p + 8), SSRC);
+        p += RTP_HEADER_SIZE;
+
+        CHECK_EQ(p[0], 0);                                  // type-specific
+        CHECK_EQ(readU24(p + 1), scan.size());              // fragment offset liền mạch
+        CHECK_EQ(p[5], RTP_JPEG_Q_INBAND);
+        if (i == 0)
+        {
+            *type = p[4];
+            width = p[6] * 8;
+            height = p[7] * 8;
+        }
+        CHECK_EQ(p[4], *type);
+        CHECK_EQ(p[6] * 8, width);
+        CHECK_EQ(p[7] * 8, height);
+        p += RTP_JPEG_HEADER_SIZE;
+
+        if (*type >= 64)
+        {
+            uint16_t ri = (p[0] << 8) | p[1];
+            if (i == 0) dri = ri;
+            CHECK_EQ(ri, dri);
+            CHECK_EQ(p[2] >> 7, 1);                         // F
+            CHECK_EQ((p[2] >> 6) & 1, 1);                   // L
+            CHECK_EQ(((p[2] & 0x3F) << 8) | p[3], 0x3FFF);
+            p += RTP_RESTART_HEADER_SIZE;
+        }
+
+        if (i == 0)
+        {
+            CHECK_EQ(p[0], 0);                              // MBZ
+            CHECK_EQ(p[1], 0);                              // precision 8 bit
+            CHECK_EQ((p[2] << 8) | p[3], 128);
+            memcpy(qt[0], p + 4, 64);
+            memcpy(qt[1], p + 68, 64);
+            p += RTP_QTABLE_HEADER_SIZE;
+        }
+
+        scan.insert(scan.end(), p, pkt.data() + pkt.size());
+    }
+
+    uint8_t sampling = (*type & 63) == 0 ? 0x21 : 0x22;
+    *jpeg = makeHeaders(width, height, sampling, dri, qt, 0xC0, false, true);
+    jpeg->insert(jpeg->end(), scan.begin(), scan.end());
+    jpeg->push_back(0xFF);
+    jpeg->push_back(0xD9);
+    return testFailures == before;
+}
+
+static void roundTrip(const jpeg_spec_t& spec, uint8_t expectType)
+{
+    test_jpeg_t src;
+    makeJpeg(spec, &src);
+
+    // Bộ tạo phải ra đúng hệ số nó đã mã hoá, nếu không phép so sánh sau không có nghĩa
+    std::vector<int16_t> srcCoefs;
+    uint16_t srcQt[2][64];
+    CHECK(decodeAll(src.data, &srcCoefs, srcQt));
+    CHECK(srcCoefs == src.coefs);
+
+    rtp_jpeg_t jpg;
+    CHECK(rtpJpegParse(src.data.data(), src.data.size(), &jpg));
+    CHECK_EQ(jpg.type, expectType);
+    CHECK_EQ(jpg.width, spec.width);
+    CHECK_EQ(jpg.height, spec.height);
+    CHECK_EQ(jpg.restartInterval, spec.restartInterval);
+    CHECK(jpg.scan == src.data.data() + src.scanStart);
+    CHECK_EQ(jpg.scanLen, src.scanLen);
+
+    capture_t cap;
+    cap.seq = FIRST_SEQ;
+    cap.stopAfterFirst = false;
+    int packets = rtpJpegPacketize(&jpg, RTP_MAX_PAYLOAD, capturePacket, &cap);
+    CHECK_EQ(packets, cap.packets.size());
+    CHECK(packets > 3);
+
+    bytes_t rebuilt;
+    uint8_t qt[2][64];
+    uint8_t type = 0xFF;
+    if (!depacketize(cap, &rebuilt, qt, &type)) return;
+
+    CHECK_EQ(type, expectType);
+    CHECK(memcmp(qt, src.qt, sizeof(qt)) == 0);
+
+    // Dữ liệu entropy ghép lại phải giống từng byte, kể cả byte stuffing và RSTn
+    size_t headerLen = rebuilt.size() - src.scanLen - 2;
+    CHECK(rebuilt.size() >= src.scanLen + 2);
+    CHECK(memcmp(rebuilt.data() + headerLen, src.data.data() + src.scanStart, src.scanLen) == 0);
+
+    std::vector<int16_t> outCoefs;
+    uint16_t outQt[2][64];
+    CHECK(decodeAll(rebuilt, &outCoefs, outQt));
+    CHECK(outCoefs == srcCoefs);
+    CHECK(memcmp(outQt, srcQt, sizeof(outQt)) == 0);
+}
+
+static void test_type0_422()
+{
+    roundTrip({320, 240, 0x21, 0, 0xC0, false, false}, 0);
+}
+
+static void test_type1_420()
+{
+    roundTrip({320, 240, 0x22, 0, 0xC0, true, true}, 1);
+}
+
+static void test_type64_restart()
+{
+    roundTrip({320, 240, 0x21, 7, 0xC0, false, false}, 64);
+}
+
+static void test_type65_restart()
+{
+    roundTrip({640, 480, 0x22, 40, 0xC0, true, false}, 65);
+}
+
+static void test_single_packet_has_marker()
+{
+    test_jpeg_t src;
+    makeJpeg({16, 8, 0x21, 0, 0xC0, false, false}, &src);
+
+    rtp_jpeg_t jpg;
+    CHECK(rtpJpegParse(src.data.data(), src.data.size(), &jpg));
+
+    capture_t cap;
+    cap.seq = FIRST_SEQ;
+    cap.stopAfterFirst = false;
+    CHECK_EQ(rtpJpegPacketize(&jpg, RTP_MAX_PAYLOAD, capturePacket, &cap), 1);
+
+    bytes_t rebuilt;
+    uint8_t qt[2][64];
+    uint8_t type = 0xFF;
+    CHECK(depacketize(cap, &rebuilt, qt, &type));
+}
+
+static void test_emit_can_stop_frame()
+{
+    test_jpeg_t src;
+    makeJpeg({320, 240, 0x22, 0, 0xC0, false, false}, &src);
+
+    rtp_jpeg_t jpg;
+    CHECK(rtpJpegParse(src.data.data(), src.data.size(), &jpg));
+
+    capture_t cap;
+    cap.seq = 0;
+    cap.stopAfterFirst = true;
+    CHECK_EQ(rtpJpegPacketize(&jpg, RTP_MAX_PAYLOAD, capturePacket, &cap), 1);
+    CHECK_EQ(cap.packets.size(), 1);
+    CHECK_EQ(cap.packets[0][1] >> 7, 0);
+}
+
+static void test_unsupported_frames_rejected()
+{
+    test_jpeg_t src;
+    rtp_jpeg_t jpg;
+
+    makeJpeg({320, 240, 0x11, 0, 0xC0, false, false}, &src);   // 4:4:4 không có type RFC 2435
+    CHECK(!rtpJpegParse(src.data.data(), src.data.size(), &jpg));
+
+    makeJpeg({320, 240, 0x22, 0, 0xC2, false, false}, &src);   // progressive
+    CHECK(!rtpJpegParse(src.data.data(), src.data.size(), &jpg));
+
+    makeJpeg({320, 240, 0x22, 0, 0xC0, false, false}, &src);
+    src.data[src.data.size() - 1] = 0x00;                        // mất EOI
+    src.data[src.data.size() - 2] = 0x00;
+    CHECK(!rtpJpegParse(src.data.data(), src.data.size(), &jpg));
+
+    // Bảng lượng tử 16 bit không gửi được với precision 0
+    makeJpeg({320, 240, 0x22, 0, 0xC0, true, false}, &src);
+    src.data[2 + 9 + 4] = 0x10;
+    CHECK(!rtpJpegParse(src.data.data(), src.data.size(), &jpg));
+}
+
+int main()
+{
+    RUN_TEST(test_type0_422);
+    RUN_TEST(test_type1_420);
+    RUN_TEST(test_type64_restart);
+    RUN_TEST(test_type65_restart);
+    RUN_TEST(test_single_packet_has_marker);
+    RUN_TEST(test_emit_can_stop_frame);
+    RUN_TEST(test_unsupported_frames_rejected);
+    TEST_EXIT();
+}
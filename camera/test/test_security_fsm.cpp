@@ -0,0 +1,273 @@
+// Kịch bản xâm nhập cho security_fsm chạy trên đồng hồ ảo: không chờ thời gian thật,
+// kiểm tra mốc SMS chủ nhà (20 s), hàng xóm (40 s), reset khi có người nhà và tự reset khi hết motion.
+#include "test_main.h"
+#include "security_fsm.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+
+#define MAX_LOG 256
+#define TICK_SLACK SEC_WHEEL_TICK_MS    // timer được làm tròn lên theo tick của wheel
+
+typedef struct {
+    uint32_t atMs;
+    security_event_t event;
+    SecurityState from;
+    SecurityState to;
+    uint16_t actions;
+} action_log_t;
+
+typedef struct {
+    uint32_t nowMs;
+    security_fsm_t fsm;
+    action_log_t log[MAX_LOG];
+    int logCount;
+} scenario_t;
+
+static uint32_t virtualClock(void* ctx)
+{
+    return ((scenario_t*)ctx)->nowMs;
+}
+
+// Sự kiện timer chạy ở thời điểm tick của wheel, sự kiện ngoài chạy ở giờ của đồng hồ
+static void recordAction(void* ctx, const security_transition_t* t)
+{
+    scenario_t* sc = (scenario_t*)ctx;
+    if (sc->logCount >= MAX_LOG) return;
+
+    bool timer = t->event == SEC_EVT_OWNER_TIMEOUT || t->event == SEC_EVT_NEIGHBOR_TIMEOUT ||
+                 t->event == SEC_EVT_NO_MOTION_TIMEOUT;
+    action_log_t* a = &sc->log[sc->logCount++];
+    a->atMs = timer ? sc->fsm.tickMs : sc->nowMs;
+    a->event = t->event;
+    a->from = t->from;
+    a->to = t->to;
+    a->actions = t->actions;
+}
+
+static void begin(scenario_t* sc)
+{
+    sc->nowMs = 0;
+    sc->logCount = 0;
+    securityFsmInit(&sc->fsm, virtualClock, recordAction, sc);
+}
+
+static void advanceTo(scenario_t* sc, uint32_t ms)
+{
+    sc->nowMs = ms;
+    securityFsmPoll(&sc->fsm);
+}
+
+static void eventAt(scenario_t* sc, uint32_t ms, security_event_t event)
+{
+    sc->nowMs = ms;
+    securityFsmDispatch(&sc->fsm, event);
+}
+
+// Motion liên tục: nhịp MOTION_SEEN 500 ms như sensors_handler
+static void motionBetween(scenario_t* sc, uint32_t startMs, uint32_t endMs)
+{
+    eventAt(sc, startMs, SEC_EVT_MOTION_START);
+    for (uint32_t t = startMs + 500; t <= endMs; t += 500) eventAt(sc, t, SEC_EVT_MOTION_SEEN);
+}
+
+static const action_log_t* findAction(const scenario_t* sc, uint16_t action)
+{
+    for (int i = 0; i < sc->logCount; i++)
+        if (sc->log[i].actions & action) return &sc->log[i];
+    return nullptr;
+}
+
+static bool near(uint32_t actual, uint32_t expected)
+{
+    return actual >= expected && actual <= expected + TICK_SLACK;
+}
+
+static void test_owner_sms_at_20s_neighbor_at_40s()
+{
+    static scenario_t sc;
+    begin(&sc);
+
+    motionBetween(&sc, 1000, 60000);
+    advanceTo(&sc, 60000);
+
+    const action_log_t* owner = findAction(&sc, SEC_ACT_OWNER_SMS);
+    const action_log_t* neighbor = findAction(&sc, SEC_ACT_NEIGHBOR_SMS);
+    CHECK(owner != nullptr);
+    CHECK(neighbor != nullptr);
+    if (!owner || !neighbor) return;
+
+    CHECK(near(owner->atMs, 1000 + OWNER_SMS_BUZZER_DELAY));
+    CHECK(owner->actions & SEC_ACT_BUZZER_ON);
+    CHECK_EQ(owner->to, SECURITY_WAITING_NEIGHBOR_SMS);
+
+    CHECK(near(neighbor->atMs, 1000 + NEIGHBOR_SMS_LOCK_DELAY));
+    CHECK(neighbor->actions & SEC_ACT_LOCK);
+    CHECK_EQ(neighbor->to, SECURITY_ALARM_ACTIVE);
+    CHECK_EQ(sc.fsm.state, SECURITY_ALARM_ACTIVE);
+}
+
+static void test_family_resets_before_sms()
+{
+    static scenario_t sc;
+    begin(&sc);
+
+    motionBetween(&sc, 0, 15000);
+    eventAt(&sc, 15000, SEC_EVT_FAMILY);
+    CHECK_EQ(sc.fsm.state, SECURITY_IDLE);
+
+    const action_log_t* last = &sc.log[sc.logCount - 1];
+    CHECK_EQ(last->event, SEC_EVT_FAMILY);
+    CHECK(last->actions & SEC_ACT_UNLOCK);
+    CHECK(last->actions & SEC_ACT_BUZZER_OFF);
+
+    // Người nhà vẫn đi lại: MOTION_SEEN ở IDLE bị bỏ qua, không bao giờ gửi SMS
+    for (uint32_t t = 15500; t <= 60000; t += 500) eventAt(&sc, t, SEC_EVT_MOTION_SEEN);
+    advanceTo(&sc, 90000);
+    CHECK(findAction(&sc, SEC_ACT_OWNER_SMS) == nullptr);
+    CHECK(findAction(&sc, SEC_ACT_NEIGHBOR_SMS) == nullptr);
+    CHECK_EQ(sc.fsm.state, SECURITY_IDLE);
+}
+
+static void test_family_resets_active_alarm()
+{
+    static scenario_t sc;
+    begin(&sc);
+
+    motionBetween(&sc, 0, 45000);
+    CHECK_EQ(sc.fsm.state, SECURITY_ALARM_ACTIVE);
+    eventAt(&sc, 45000, SEC_EVT_FAMILY);
+    CHECK_EQ(sc.fsm.state, SECURITY_IDLE);
+    CHECK(sc.log[sc.logCount - 1].actions & SEC_ACT_UNLOCK);
+    CHECK_EQ(sc.fsm.armedCount, 0);
+}
+
+static void test_auto_reset_after_motion_stops()
+{
+    static scenario_t sc;
+    begin(&sc);
+
+    motionBetween(&sc, 0, 3000);
+    advanceTo(&sc, 7990);
+    CHECK_EQ(sc.fsm.state, SECURITY_WAITING_OWNER_SMS);
+
+    advanceTo(&sc, 30000);
+    CHECK_EQ(sc.fsm.state, SECURITY_IDLE);
+    const action_log_t* reset = &sc.log[sc.logCount - 1];
+    CHECK_EQ(reset->event, SEC_EVT_NO_MOTION_TIMEOUT);
+    CHECK(near(reset->atMs, 3000 + AUTO_RESET_NO_MOTION));
+    CHECK(findAction(&sc, SEC_ACT_OWNER_SMS) == nullptr);
+}
+
+static void test_auto_reset_from_alarm_keeps_timing()
+{
+    static scenario_t sc;
+    begin(&sc);
+
+    motionBetween(&sc, 0, 45000);
+    CHECK_EQ(sc.fsm.state, SECURITY_ALARM_ACTIVE);
+
+    advanceTo(&sc, 120000);
+    CHECK_EQ(sc.fsm.state, SECURITY_IDLE);
+    const action_log_t* reset = &sc.log[sc.logCount - 1];
+    CHECK_EQ(reset->event, SEC_EVT_NO_MOTION_TIMEOUT);
+    CHECK(near(reset->atMs, 45000 + AUTO_RESET_NO_MOTION));
+    CHECK(reset->actions & SEC_ACT_BUZZER_OFF);
+}
+
+// Kịch bản ngẫu nhiên: motion ngắt quãng, người nhà, tắt tay. Kiểm tra bất biến trên log hành động.
+static uint32_t rng = 12345;
+static uint32_t nextRand(uint32_t n)
+{
+    rng = rng * 1103515245u + 12345u;
+    return (rng >> 8) % n;
+}
+
+static bool checkRunInvariants(const scenario_t* sc)
+{
+    bool ok = true;
+    uint32_t episodeStart = 0;
+    uint32_t ownerAt = 0;
+    bool active = false;
+
+    for (int i = 0; i < sc->logCount; i++)
+    {
+        const action_log_t* a = &sc->log[i];
+
+        if (a->from == SECURITY_IDLE && a->to != SECURITY_IDLE)
+        {
+            ok &= a->event == SEC_EVT_MOTION_START;
+            episodeStart = a->atMs;
+            active = true;
+        }
+        if (a->actions & SEC_ACT_OWNER_SMS)
+        {
+            ok &= active && near(a->atMs, episodeStart + OWNER_SMS_BUZZER_DELAY);
+            ownerAt = a->atMs;
+        }
+        if (a->actions & SEC_ACT_NEIGHBOR_SMS)
+        {
+            ok &= active && near(a->atMs, episodeStart + NEIGHBOR_SMS_LOCK_DELAY) && ownerAt > episodeStart;
+        }
+        if (a->event == SEC_EVT_FAMILY) ok &= a->to == SECURITY_IDLE && (a->actions & SEC_ACT_UNLOCK);
+        if (a->to == SECURITY_IDLE) active = false;
+    }
+    ok &= (sc->fsm.state == SECURITY_IDLE) == (sc->fsm.armedCount == 0);
+    return ok;
+}
+
+static void test_randomized_intrusions()
+{
+    static scenario_t sc;
+    const int runs = 10000;
+    int failed = 0;
+    int ownerRuns = 0, neighborRuns = 0;
+    uint64_t transitions = 0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int run = 0; run < runs; run++)
+    {
+        begin(&sc);
+        uint32_t now = nextRand(2000);
+        eventAt(&sc, now, SEC_EVT_MOTION_START);
+
+        while (now < 90000)
+        {
+            // Phần lớn nhịp 500 ms, thỉnh thoảng mất motion lâu hơn hạn tự reset
+            uint32_t r = nextRand(100);
+            now += r < 90 ? 500 : 1000 + nextRand(9000);
+
+            uint32_t e = nextRand(1000);
+            if (e < 3) eventAt(&sc, now, SEC_EVT_FAMILY);
+            else if (e < 5) eventAt(&sc, now, SEC_EVT_RESET);
+            else if (e < 15) eventAt(&sc, now, SEC_EVT_MOTION_END);
+            else if (e < 40) eventAt(&sc, now, SEC_EVT_MOTION_START);
+            else eventAt(&sc, now, SEC_EVT_MOTION_SEEN);
+        }
+        advanceTo(&sc, now + 60000);
+
+        if (!checkRunInvariants(&sc)) failed++;
+        if (findAction(&sc, SEC_ACT_OWNER_SMS)) ownerRuns++;
+        if (findAction(&sc, SEC_ACT_NEIGHBOR_SMS)) neighborRuns++;
+        transitions += sc.fsm.stats.transitions;
+    }
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+
+    CHECK_EQ(failed, 0);
+    CHECK(ownerRuns > runs / 10);       // kịch bản phải thực sự leo thang, không chỉ reset sớm
+    CHECK(neighborRuns > runs / 50);
+    CHECK_EQ(sc.fsm.state, SECURITY_IDLE);
+    printf("  %d runs (%d owner SMS, %d neighbor SMS), %llu transitions, %lld ms\n", runs, ownerRuns, neighborRuns,
+           (unsigned long long)transitions, (long long)(us / 1000));
+}
+
+int main()
+{
+    RUN_TEST(test_owner_sms_at_20s_neighbor_at_40s);
+    RUN_TEST(test_family_resets_before_sms);
+    RUN_TEST(test_family_resets_active_alarm);
+    RUN_TEST(test_auto_reset_after_motion_stops);
+    RUN_TEST(test_auto_reset_from_alarm_keeps_timing);
+    RUN_TEST(test_randomized_intrusions);
+    TEST_EXIT();
+}
@@ -0,0 +1,233 @@
+// Engine AT của SIM800 trên UART giả: echo, URC chèn giữa lệnh, dấu nhắc '>' của AT+CMGS và timeout
+#include "test_main.h"
+#include "sim_at.h"
+#include <string>
+
+static HardwareSerial modem(1);
+
+typedef struct {
+    int calls;
+    sim_at_result_t result;
+    std::string response;
+} cmd_result_t;
+
+static std::vector<std::string> cmtiLines;
+static std::vector<std::string> cmgsLines;
+
+static void onDone(sim_at_result_t result, const char* response, void* ctx)
+{
+    cmd_result_t* r = (cmd_result_t*)ctx;
+    r->calls++;
+    r->result = result;
+    r->response = response;
+}
+
+static void onCmti(const char* line)
+{
+    cmtiLines.push_back(line);
+}
+
+static void onCmgs(const char* line)
+{
+    cmgsLines.push_back(line);
+}
+
+// Modem trả dữ liệu rồi task SimAT chạy 1 vòng
+static void receive(const char* s)
+{
+    modem.hostReceive(s);
+    simAtPoll();
+}
+
+static void advanceMs(uint32_t ms)
+{
+    hostNowUs += (int64_t)ms * 1000;
+    simAtPoll();
+}
+
+static void begin()
+{
+    modem.tx.clear();
+    cmtiLines.clear();
+    cmgsLines.clear();
+}
+
+static void test_echo_ignored()
+{
+    begin();
+    cmd_result_t r = {};
+    CHECK(simAtSubmit("AT+CPIN?", "+CPIN: READY", SIM_AT_DEFAULT_TIMEOUT, onDone, &r));
+    simAtPoll();
+    CHECK(modem.tx == "AT+CPIN?\r");
+
+    // Chưa ATE0: modem lặp lại lệnh trước khi trả lời
+    receive("AT+CPIN?\r\r\n+CPIN: READY\r\n\r\nOK\r\n");
+    CHECK_EQ(r.calls, 1);
+    CHECK_EQ(r.result, SIM_AT_OK);
+    CHECK(r.response == "+CPIN: READY");
+}
+
+static void test_response_split_across_reads()
+{
+    begin();
+    cmd_result_t r = {};
+    CHECK(simAtSubmit("AT+CSQ", nullptr, SIM_AT_DEFAULT_TIMEOUT, onDone, &r));
+    simAtPoll();
+
+    receive("\r\n+CS");
+    receive("Q: 21,0\r");
+    CHECK_EQ(r.calls, 0);
+    receive("\n\r\nOK\r\n");
+    CHECK_EQ(r.calls, 1);
+    CHECK_EQ(r.result, SIM_AT_OK);
+    CHECK(r.response == "+CSQ: 21,0");
+}
+
+static void test_missing_expect_is_error()
+{
+    begin();
+    cmd_result_t r = {};
+    CHECK(simAtSubmit("AT+CPIN?", "+CPIN: READY", SIM_AT_DEFAULT_TIMEOUT, onDone, &r));
+    simAtPoll();
+
+    receive("\r\n+CPIN: SIM PIN\r\n\r\nOK\r\n");
+    CHECK_EQ(r.calls, 1);
+    CHECK_EQ(r.result, SIM_AT_ERROR);
+
+    cmd_result_t e = {};
+    CHECK(simAtSubmit("AT+CMGF=1", nullptr, SIM_AT_DEFAULT_TIMEOUT, onDone, &e));
+    simAtPoll();
+    receive("\r\n+CMS ERROR: 302\r\n");
+    CHECK_EQ(e.calls, 1);
+    CHECK_EQ(e.result, SIM_AT_ERROR);
+    CHECK(e.response == "+CMS ERROR: 302");
+}
+
+static void test_cmti_interleaved()
+{
+    begin();
+    cmd_result_t r = {};
+    uint32_t urcsBefore = simAtStats.urcs;
+    CHECK(simAtSubmit("AT+CSQ", nullptr, SIM_AT_DEFAULT_TIMEOUT, onDone, &r));
+    simAtPoll();
+
+    // Tin nhắn đến ngay giữa response: chuyển cho handler, không lẫn vào response của lệnh
+    receive("\r\n+CSQ: 18,0\r\n\r\n+CMTI: \"SM\",3\r\n\r\nOK\r\n");
+    CHECK_EQ(r.calls, 1);
+    CHECK_EQ(r.result, SIM_AT_OK);
+    CHECK(r.response == "+CSQ: 18,0");
+    CHECK_EQ(cmtiLines.size(), 1);
+    if (!cmtiLines.empty()) CHECK(cmtiLines[0] == "+CMTI: \"SM\",3");
+
+    // Lúc không có lệnh nào cũng vẫn tới handler
+    receive("\r\n+CMTI: \"SM\",4\r\n");
+    CHECK_EQ(cmtiLines.size(), 2);
+    CHECK_EQ(simAtStats.urcs, urcsBefore + 2);
+}
+
+static void test_cmgs_prompt()
+{
+    begin();
+    cmd_result_t r = {};
+    CHECK(simAtSendSms("+84901234567", "CANH BAO", onDone, &r));
+    simAtPoll();
+    CHECK(modem.tx == "AT+CMGS=\"+84901234567\"\r");
+
+    // Nội dung chỉ gửi sau dấu nhắc "> " (không có xuống dòng), kết thúc bằng Ctrl-Z
+    receive("AT+CMGS=\"+84901234567\"\r\r\n");
+    CHECK(modem.tx == "AT+CMGS=\"+84901234567\"\r");
+    receive("> ");
+    CHECK(modem.tx == "AT+CMGS=\"+84901234567\"\rCANH BAO\x1A");
+    CHECK_EQ(r.calls, 0);
+
+    // Modem echo lại nội dung sau dấu nhắc; +CMGS vừa là URC vừa là dòng lệnh đang chờ
+    receive("CANH BAO\x1A\r\n+CMGS: 12\r\n\r\nOK\r\n");
+    CHECK_EQ(r.calls, 1);
+    CHECK_EQ(r.result, SIM_AT_OK);
+    CHECK(r.response.find("+CMGS: 12") != std::string::npos);
+    CHECK_EQ(cmgsLines.size(), 1);
+}
+
+static void test_prompt_timeout()
+{
+    begin();
+    cmd_result_t sms = {}, next = {};
+    uint32_t timeoutsBefore = simAtStats.timeouts;
+    CHECK(simAtSendSms("+84901234567", "CANH BAO", onDone, &sms));
+    CHECK(simAtSubmit("AT+CSQ", nullptr, SIM_AT_DEFAULT_TIMEOUT, onDone, &next));
+    simAtPoll();
+
+    // Lệnh sau chờ trong hàng đợi cho tới khi lệnh đang chạy xong
+    CHECK(modem.tx == "AT+CMGS=\"+84901234567\"\r");
+
+    advanceMs(SIM_AT_SMS_TIMEOUT - 1);
+    CHECK_EQ(sms.calls, 0);
+
+    // Hết giờ khi chưa có '>': ESC hủy chế độ soạn tin, rồi mới gửi lệnh kế tiếp
+    modem.tx.clear();
+    advanceMs(1);
+    CHECK_EQ(sms.calls, 1);
+    CHECK_EQ(sms.result, SIM_AT_TIMEOUT);
+    CHECK_EQ(simAtStats.timeouts, timeoutsBefore + 1);
+    CHECK(modem.tx == "\x1B" "AT+CSQ\r");
+
+    // Dấu nhắc tới muộn không còn làm gửi nội dung tin
+    modem.tx.clear();
+    receive("> ");
+    CHECK(modem.tx.empty());
+    receive("\r\nOK\r\n");
+    CHECK_EQ(next.calls, 1);
+    CHECK_EQ(next.result, SIM_AT_OK);
+}
+
+static void test_final_timeout_drops_partial_line()
+{
+    begin();
+    cmd_result_t r = {}, next = {};
+    CHECK(simAtSubmit("AT+CSQ", nullptr, SIM_AT_DEFAULT_TIMEOUT, onDone, &r));
+    CHECK(simAtSubmit("AT+CREG?", "+CREG:", SIM_AT_DEFAULT_TIMEOUT, onDone, &next));
+    simAtPoll();
+
+    receive("\r\n+CSQ: 1");
+    advanceMs(SIM_AT_DEFAULT_TIMEOUT);
+    CHECK_EQ(r.calls, 1);
+    CHECK_EQ(r.result, SIM_AT_TIMEOUT);
+    CHECK(modem.tx == "AT+CSQ\rAT+CREG?\r");
+
+    // Phần dòng dở của lệnh trước không được ghép vào response của lệnh sau
+    receive("\r\n+CREG: 0,1\r\n\r\nOK\r\n");
+    CHECK_EQ(next.calls, 1);
+    CHECK_EQ(next.result, SIM_AT_OK);
+    CHECK(next.response == "+CREG: 0,1");
+}
+
+static void test_queue_full()
+{
+    begin();
+    cmd_result_t r[SIM_AT_QUEUE_LEN] = {};
+    uint32_t fullBefore = simAtStats.queueFull;
+    for (int i = 0; i < SIM_AT_QUEUE_LEN; i++) CHECK(simAtSubmit("AT", nullptr, SIM_AT_DEFAULT_TIMEOUT, onDone, &r[i]));
+    CHECK(!simAtSubmit("AT", nullptr, SIM_AT_DEFAULT_TIMEOUT, nullptr, nullptr));
+    CHECK_EQ(simAtStats.queueFull, fullBefore + 1);
+
+    simAtPoll();
+    for (int i = 0; i < SIM_AT_QUEUE_LEN; i++) receive("\r\nOK\r\n");
+    for (int i = 0; i < SIM_AT_QUEUE_LEN; i++) CHECK_EQ(r[i].calls, 1);
+}
+
+int main()
+{
+    CHECK(simAtOnUrc("+CMTI:", onCmti));
+    CHECK(simAtOnUrc("+CMGS:", onCmgs));
+    CHECK(startSimAt(&modem));
+
+    RUN_TEST(test_echo_ignored);
+    RUN_TEST(test_response_split_across_reads);
+    RUN_TEST(test_missing_expect_is_error);
+    RUN_TEST(test_cmti_interleaved);
+    RUN_TEST(test_cmgs_prompt);
+    RUN_TEST(test_prompt_timeout);
+    RUN_TEST(test_final_timeout_drops_partial_line);
+    RUN_TEST(test_queue_full);
+    TEST_EXIT();
+}
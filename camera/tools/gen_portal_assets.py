@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""Nén các file tĩnh của portal cấu hình (camera/main/portal) thành mảng gzip trong flash.
+
+Chạy lại mỗi khi sửa file trong portal/ rồi commit portal_assets.h:
+    python3 camera/tools/gen_portal_assets.py
+"""
+
+import gzip
+import hashlib
+import os
+import re
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SRC_DIR = os.path.join(ROOT, "main", "portal")
+OUT_FILE = os.path.join(ROOT, "main", "portal_assets.h")
+
+CONTENT_TYPES = {
+    ".html": "text/html; charset=utf-8",
+    ".css": "text/css",
+    ".js": "application/javascript",
+}
+
+# HTML luôn revalidate (ETag/304), CSS/JS được cache lâu vì URL có ?v=<hash>
+CACHE_HTML = "no-cache"
+CACHE_VERSIONED = "public, max-age=31536000, immutable"
+
+
+def minify(text):
+    # Chỉ bỏ thụt lề và dòng trống: an toàn cho HTML/CSS/JS của portal (không có <pre>, chuỗi nhiều dòng)
+    lines = (line.strip() for line in text.splitlines())
+    return "\n".join(line for line in lines if line) + "\n"
+
+
+def symbol(name):
+    return re.sub(r"[^A-Za-z0-9]", "_", name).upper()
+
+
+def main():
+    names = sorted(n for n in os.listdir(SRC_DIR) if os.path.splitext(n)[1] in CONTENT_TYPES)
+    raw = {}
+    for name in names:
+        with open(os.path.join(SRC_DIR, name), encoding="utf-8") as f:
+            raw[name] = minify(f.read())
+
+    # CSS/JS trước để HTML tham chiếu được URL có version
+    versions = {}
+    for name in names:
+        if not name.endswith(".html"):
+            versions[name] = hashlib.sha256(raw[name].encode()).hexdigest()[:12]
+
+    assets = []
+    for name in sorted(names, key=lambda n: n.endswith(".html")):
+        text = raw[name]
+        if name.endswith(".html"):
+            for ref, ver in versions.items():
+                text = text.replace('"/%s"' % ref, '"/%s?v=%s"' % (ref, ver))
+        data = text.encode()
+        # mtime=0 để file sinh ra không đổi khi nội dung không đổi
+        gz = gzip.compress(data, compresslevel=9, mtime=0)
+        etag = '"%s"' % hashlib.sha256(data).hexdigest()[:16]
+        path = "/" if name == "index.html" else "/" + name
+        cache = CACHE_HTML if name.endswith(".html") else CACHE_VERSIONED
+        assets.append((name, path, CONTENT_TYPES[os.path.splitext(name)[1]], cache, etag, data, gz))
+
+    out = []
+    out.append("// File sinh tự động bởi camera/tools/gen_portal_assets.py từ camera/main/portal/, không sửa tay")
+    out.append("#ifndef PORTAL_ASSETS_H")
+    out.append("#define PORTAL_ASSETS_H")
+    out.append("")
+    out.append("#include <Arduino.h>")
+    out.append("")
+    out.append("typedef struct {")
+    out.append("    const char* path;")
+    out.append("    const char* contentType;")
+    out.append("    const char* cacheControl;")
+    out.append("    const char* etag;")
+    out.append("    const uint8_t* gz;")
+    out.append("    size_t gzLen;")
+    out.append("} portal_asset_t;")
+    out.append("")
+    for name, ver in versions.items():
+        out.append('#define PORTAL_URL_%s "/%s?v=%s"' % (symbol(name), name, ver))
+    out.append("")
+
+    for name, path, ctype, cache, etag, data, gz in assets:
+        out.append("// %s: %u -> %u byte" % (name, len(data), len(gz)))
+        out.append("static const uint8_t portal_%s_gz[] PROGMEM = {" % symbol(name).lower())
+        for i in range(0, len(gz), 16):
+            out.append("    " + ", ".join("0x%02x" % b for b in gz[i:i + 16]) + ",")
+        out.append("};")
+        out.append("")
+
+    out.append("static const portal_asset_t portalAssets[] = {")
+    for name, path, ctype, cache, etag, data, gz in assets:
+        out.append('    { "%s", "%s", "%s", "%s", portal_%s_gz, sizeof(portal_%s_gz) },' % (
+            path, ctype, cache, etag.replace('"', '\\"'), symbol(name).lower(), symbol(name).lower()))
+    out.append("};")
+    out.append("")
+    out.append("#define PORTAL_ASSET_COUNT (sizeof(portalAssets) / sizeof(portalAssets[0]))")
+    out.append("")
+    out.append("#endif")
+
+    # Cùng kiểu xuống dòng CRLF với các file nguồn khác trong camera/main
+    with open(OUT_FILE, "w", encoding="utf-8", newline="\r\n") as f:
+        f.write("\n".join(out) + "\n")
+
+    for name, path, ctype, cache, etag, data, gz in assets:
+        print("%-12s %5u -> %5u byte  %s" % (name, len(data), len(gz), etag))
+
+
+if __name__ == "__main__":
+    main()